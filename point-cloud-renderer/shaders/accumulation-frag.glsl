@@ -0,0 +1,17 @@
+#version 410
+
+uniform sampler2DMS accumulated;
+uniform int samples;
+
+out vec4 colour;
+
+void main()
+{
+    // resolve the samples of the pixel, as drawing to the window would
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec4 sum = vec4(0.0);
+    for (int i = 0; i < samples; i++) {
+        sum += texelFetch(accumulated, texel, i);
+    }
+    colour = sum / float(samples);
+}
@@ -0,0 +1,16 @@
+#version 410
+
+// a corner of the unit cube, moved onto each instance's box
+layout(location=0) in vec3 corner;
+layout(location=1) in vec3 boxMin;
+layout(location=2) in vec3 boxExtent;
+
+uniform mat4 MVP;
+
+out vec3 fragColour;
+
+void main()
+{
+    gl_Position = MVP * vec4(boxMin + corner * boxExtent, 1.0);
+    fragColour = vec3(0.0, 1.0, 0.0);
+}
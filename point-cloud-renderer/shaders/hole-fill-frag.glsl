@@ -0,0 +1,76 @@
+#version 410
+
+// one pass of HoleFiller, see hole-filler.h
+uniform sampler2D colourIn;
+// the window depth of the drawn points, or, unless the first pass, the
+// linear depth the previous pass wrote, 0 for the background
+uniform sampler2D depthIn;
+uniform bool isDepthLinear;
+uniform float zNear;
+uniform float zFar;
+// pixels to the neighbours the pass reads
+uniform int stepSize;
+
+layout(location=0) out vec4 colour;
+layout(location=1) out float depth;
+
+// neighbours up to this much farther than the nearest are on its surface
+const float surfaceTolerance = 0.05;
+
+// the 8 neighbours, each opposite the one 4 places on
+const ivec2 directions[8] = ivec2[](
+    ivec2(1, 0), ivec2(1, 1), ivec2(0, 1), ivec2(-1, 1),
+    ivec2(-1, 0), ivec2(-1, -1), ivec2(0, -1), ivec2(1, -1));
+
+float getDepth(ivec2 texel)
+{
+    float value = texelFetch(depthIn, texel, 0).r;
+    if (isDepthLinear) return value;
+    if (value >= 1.0) return 0.0;
+    return zNear * zFar / (zFar - value * (zFar - zNear));
+}
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    ivec2 maxTexel = textureSize(depthIn, 0) - 1;
+    colour = texelFetch(colourIn, texel, 0);
+    depth = getDepth(texel);
+
+    float neighbourDepths[8];
+    float nearest = 0.0;
+    for (int i = 0; i < 8; i++) {
+        ivec2 neighbour = clamp(texel + directions[i] * stepSize, ivec2(0), maxTexel);
+        neighbourDepths[i] = getDepth(neighbour);
+        if (neighbourDepths[i] > 0.0 && (nearest == 0.0 || neighbourDepths[i] < nearest)) {
+            nearest = neighbourDepths[i];
+        }
+    }
+    // the pixel already shows the nearest surface, or there is none
+    float farthest = nearest * (1.0 + surfaceTolerance);
+    if (nearest == 0.0 || (depth > 0.0 && depth <= farthest)) return;
+
+    bool isOnSurface[8];
+    for (int i = 0; i < 8; i++) {
+        isOnSurface[i] = neighbourDepths[i] > 0.0 && neighbourDepths[i] <= farthest;
+    }
+    bool isBetween = false;
+    for (int i = 0; i < 4; i++) {
+        isBetween = isBetween || (isOnSurface[i] && isOnSurface[i + 4]);
+    }
+    // past the edge of the surface
+    if (!isBetween) return;
+
+    vec4 colourSum = vec4(0.0);
+    float depthSum = 0.0;
+    float count = 0.0;
+    for (int i = 0; i < 8; i++) {
+        if (!isOnSurface[i]) continue;
+        ivec2 neighbour = clamp(texel + directions[i] * stepSize, ivec2(0), maxTexel);
+        colourSum += texelFetch(colourIn, neighbour, 0);
+        depthSum += neighbourDepths[i];
+        count += 1.0;
+    }
+    colour = colourSum / count;
+    depth = depthSum / count;
+}
@@ -1,16 +1,163 @@
 #version 410
 
+// The HAS_* defines are inserted after #version for the attributes the
+// points carry, see PointSchema::getDefines()
+
 layout(location=0) in vec3 position;
+#ifdef HAS_COLOUR
 layout(location=1) in vec3 colour;
+#endif
+#ifdef HAS_INTENSITY
+layout(location=2) in float intensity;
+#endif
+#ifdef HAS_CLASSIFICATION
+layout(location=3) in uint classification;
+#endif
+#ifdef HAS_NORMAL
+layout(location=4) in vec3 normal;
+#endif
 
 uniform mat4 MVP;
 uniform float pointSize;
- 
+// what points are coloured by, see colourmap::Mode; scalar modes look up
+// their value's place in its range in the colourMap row of colourMaps
+uniform int colourMode;
+uniform sampler2D colourMaps;
+uniform int colourMap;
+uniform vec2 intensityRange;
+uniform vec2 zRange;
+uniform mat3 normalMatrix;
+// the display filter: points outside either range are not drawn
+uniform vec2 intensityFilter;
+uniform vec2 classificationFilter;
+// adaptive point size: points are drawn wide enough to cover the spacing of
+// the finest drawn node containing them, found by walking spacingTree (see
+// OctreeNode::DrawList) down from the node being drawn, and at least
+// pointSize wide
+uniform bool isAdaptivePointSize;
+uniform usamplerBuffer spacingTree;
+uniform int nodeIndex;
+uniform vec3 nodeMin;
+uniform vec3 nodeExtent;
+// pixels a unit of the tree's coordinates spans at a view distance of 1
+uniform float spacingScale;
+
 out vec3 fragColour;
 
+const int RGB = 0;
+const int CLASSIFICATION = 1;
+const int INTENSITY = 2;
+const int HEIGHT = 3;
+
+// points are drawn this much wider than their spacing, as it is not regular
+const float spacingCoverage = 1.5;
+const float maxAdaptivePointSize = 32.0;
+// deeper than any octree's depth limit
+const int maxSpacingDepth = 24;
+
+#ifdef HAS_CLASSIFICATION
+// ASPRS LAS classes 0 to 18
+const vec3 classColours[19] = vec3[](
+    vec3(0.6, 0.6, 0.6),    // never classified
+    vec3(0.8, 0.8, 0.8),    // unclassified
+    vec3(0.6, 0.45, 0.3),   // ground
+    vec3(0.55, 0.8, 0.35),  // low vegetation
+    vec3(0.3, 0.7, 0.25),   // medium vegetation
+    vec3(0.1, 0.5, 0.15),   // high vegetation
+    vec3(0.85, 0.35, 0.25), // building
+    vec3(1.0, 0.0, 1.0),    // low noise
+    vec3(0.9, 0.9, 0.3),    // model key point
+    vec3(0.2, 0.45, 0.9),   // water
+    vec3(0.5, 0.3, 0.6),    // rail
+    vec3(0.4, 0.4, 0.45),   // road surface
+    vec3(0.9, 0.6, 0.2),    // overlap
+    vec3(0.9, 0.9, 0.9),    // wire guard
+    vec3(0.95, 0.85, 0.1),  // wire conductor
+    vec3(0.7, 0.2, 0.2),    // transmission tower
+    vec3(0.3, 0.9, 0.9),    // wire connector
+    vec3(0.6, 0.6, 0.3),    // bridge deck
+    vec3(1.0, 0.2, 0.6));   // high noise
+#endif
+
+vec3 mapScalar(float value, vec2 range)
+{
+    float t = range.y > range.x ? clamp((value - range.x) / (range.y - range.x), 0.0, 1.0)
+                                : 0.0;
+    // sample between the first and last texel centres
+    vec2 size = vec2(textureSize(colourMaps, 0));
+    vec2 coords = vec2((0.5 + t * (size.x - 1.0)) / size.x, (float(colourMap) + 0.5) / size.y);
+    return textureLod(colourMaps, coords, 0.0).rgb;
+}
+
+float getSpacing()
+{
+    int index = nodeIndex;
+    vec3 boxMin = nodeMin;
+    vec3 extent = nodeExtent;
+    float spacing = 0.0;
+    for (int depth = 0; depth < maxSpacingDepth; depth++) {
+        uvec2 node = texelFetch(spacingTree, index).xy;
+        if (node.y != 0u) spacing = uintBitsToFloat(node.y);
+
+        // octants as OctreeNode::getChildNodeIndex(): x -> bit 2, y -> bit 1, z -> bit 0
+        extent *= 0.5;
+        vec3 center = boxMin + extent;
+        bvec3 isUpper = greaterThan(position, center);
+        uint octant = (isUpper.x ? 4u : 0u) | (isUpper.y ? 2u : 0u) | (isUpper.z ? 1u : 0u);
+        uint childMask = node.x & 0xFFu;
+        if ((childMask & (1u << octant)) == 0u) break;
+
+        index = int(node.x >> 8) + bitCount(childMask & ((1u << octant) - 1u));
+        boxMin = mix(boxMin, center, vec3(isUpper));
+    }
+    return spacing;
+}
+
 void main()
 {
     gl_Position = MVP * vec4(position, 1.0);
     gl_PointSize = pointSize;
-    fragColour = colour;
+    if (isAdaptivePointSize) {
+        float spacingSize = spacingCoverage * getSpacing() * spacingScale / gl_Position.w;
+        gl_PointSize = clamp(spacingSize, pointSize, max(pointSize, maxAdaptivePointSize));
+    }
+
+    bool isFilteredOut = false;
+#ifdef HAS_INTENSITY
+    isFilteredOut = isFilteredOut || intensity < intensityFilter.x || intensity > intensityFilter.y;
+#endif
+#ifdef HAS_CLASSIFICATION
+    float classValue = float(classification);
+    isFilteredOut = isFilteredOut ||
+                    classValue < classificationFilter.x || classValue > classificationFilter.y;
+#endif
+    if (isFilteredOut) {
+        // beyond the far plane, so the point is clipped
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+    }
+
+    // only modes the points have the attribute for are selected
+    vec3 baseColour = vec3(1.0);
+#ifdef HAS_COLOUR
+    if (colourMode == RGB) baseColour = colour;
+#endif
+#ifdef HAS_CLASSIFICATION
+    if (colourMode == CLASSIFICATION) baseColour = classColours[min(classification, 18u)];
+#endif
+#ifdef HAS_INTENSITY
+    if (colourMode == INTENSITY) baseColour = mapScalar(intensity, intensityRange);
+#endif
+    if (colourMode == HEIGHT) baseColour = mapScalar(position.z, zRange);
+
+#ifdef HAS_NORMAL
+    // lit by a headlight, i.e. along the view direction; points may face
+    // either way, so the normal's sign is ignored
+    float shade = 1.0;
+    if (dot(normal, normal) > 0.0) {
+        shade = 0.3 + 0.7 * abs(normalize(normalMatrix * normal).z);
+    }
+    baseColour *= shade;
+#endif
+
+    fragColour = baseColour;
 }
@@ -0,0 +1,83 @@
+#include <algorithm>
+
+#include <accumulation-target/accumulation-target.h>
+
+namespace {
+
+  // texture unit the full-screen pass reads the target from; the points
+  // shader's colour maps are on unit 0
+  constexpr int textureUnit = 1;
+
+}  // namespace
+
+AccumulationTarget::AccumulationTarget()
+    : framebuffer(0),
+      colourTexture(0),
+      depthBuffer(0),
+      vao(0),
+      samples(0),
+      width(0),
+      height(0) {
+}
+
+AccumulationTarget::~AccumulationTarget() {
+  if (framebuffer == 0) return;
+  glDeleteFramebuffers(1, &framebuffer);
+  glDeleteTextures(1, &colourTexture);
+  glDeleteRenderbuffers(1, &depthBuffer);
+  glDeleteVertexArrays(1, &vao);
+}
+
+void AccumulationTarget::bind(int width, int height, bool clear) {
+  if (framebuffer == 0) create();
+
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  if (width != this->width || height != this->height) {
+    resize(width, height);
+    clear = true;
+  }
+  if (clear) glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void AccumulationTarget::present(unsigned int program) {
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDisable(GL_DEPTH_TEST);
+
+  glUseProgram(program);
+  glActiveTexture(GL_TEXTURE0 + textureUnit);
+  glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, colourTexture);
+  glUniform1i(glGetUniformLocation(program, "accumulated"), textureUnit);
+  glUniform1i(glGetUniformLocation(program, "samples"), samples);
+  glBindVertexArray(vao);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+
+  glActiveTexture(GL_TEXTURE0);
+  glEnable(GL_DEPTH_TEST);
+}
+
+void AccumulationTarget::create() {
+  // the window's framebuffer is bound, so this is its sample count
+  glGetIntegerv(GL_SAMPLES, &samples);
+  samples = std::max(samples, 1);
+
+  glGenFramebuffers(1, &framebuffer);
+  glGenTextures(1, &colourTexture);
+  glGenRenderbuffers(1, &depthBuffer);
+  glGenVertexArrays(1, &vao);
+}
+
+void AccumulationTarget::resize(int width, int height) {
+  this->width = width;
+  this->height = height;
+
+  glActiveTexture(GL_TEXTURE0 + textureUnit);
+  glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, colourTexture);
+  glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, GL_RGBA8, width, height, GL_TRUE);
+  glActiveTexture(GL_TEXTURE0);
+  glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+  glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, width, height);
+
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE,
+                         colourTexture, 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+}
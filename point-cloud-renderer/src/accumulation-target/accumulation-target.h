@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glad/gl.h>
+
+// A colour and depth target that keeps what is drawn into it between frames,
+// so an idle view can be refined over several frames without redrawing the
+// points already drawn. It has as many samples as the window's framebuffer,
+// and is shown by a full-screen pass that resolves them. The GL objects are
+// only created by the first bind().
+class AccumulationTarget {
+ public:
+  AccumulationTarget();
+  ~AccumulationTarget();
+
+  AccumulationTarget(const AccumulationTarget&) = delete;
+  AccumulationTarget& operator=(const AccumulationTarget&) = delete;
+
+  // Draws go into the target until present(). It is resized to `width` by
+  // `height`, which clears it, and cleared if `clear`.
+  void bind(int width, int height, bool clear);
+  // Draws the target over the window's framebuffer, which it binds again,
+  // with `program`, built from fullscreen-vertex.glsl and
+  // accumulation-frag.glsl.
+  void present(unsigned int program);
+
+ private:
+  void create();
+  void resize(int width, int height);
+
+  unsigned int framebuffer;
+  unsigned int colourTexture;  // multisampled, read by the full-screen pass
+  unsigned int depthBuffer;
+  unsigned int vao;  // empty: the full-screen pass makes its own vertices
+  int samples;
+  int width;
+  int height;
+};
@@ -1,18 +1,12 @@
 #pragma once
 #include <glm/glm.hpp>
-#include <glad/gl.h>
-#include <buffers/buffers.h>
 
+// An axis-aligned box. Boxes are drawn as debug overlays by a BoxOverlay,
+// so they hold no GPU data of their own.
 class BoundingBox {
  public:
-  Buffers buffers;
-
   BoundingBox();
   BoundingBox(const glm::vec3& min, const glm::vec3& max, bool uniform);
-  BoundingBox(const BoundingBox& original);
-  ~BoundingBox();
-
-  BoundingBox& operator=(const BoundingBox& original);
 
   glm::vec3 getCenter() const;
   glm::vec3 getDimensions() const;
@@ -21,11 +15,9 @@ class BoundingBox {
   float getScale() const;
   float getScreenScaleFactor() const;
   float getBoundingSphereRadius() const;
-  void buffer();
-  void draw() const;
+  bool contains(const glm::vec3& position) const;
 
  private:
   glm::vec3 min;
   glm::vec3 max;
-  unsigned int vao;
 };
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cstddef>
+
+#include <box-overlay/box-overlay.h>
+
+namespace {
+
+  constexpr int numCubeVerts = 8;
+  constexpr int numCubeIndices = 24;
+
+  const glm::vec3 cubeVerts[numCubeVerts] = {
+      {0, 0, 0}, {0, 0, 1}, {0, 1, 0}, {0, 1, 1},
+      {1, 0, 0}, {1, 0, 1}, {1, 1, 0}, {1, 1, 1}};
+
+  // the 12 edges as line pairs
+  const unsigned short int cubeIndices[numCubeIndices] = {
+      0, 1, 1, 3, 3, 2, 2, 0,
+      4, 5, 5, 7, 7, 6, 6, 4,
+      0, 4, 1, 5, 2, 6, 3, 7};
+
+}  // namespace
+
+BoxOverlay::BoxOverlay()
+    : vao(0),
+      cubeVBO(0),
+      indexVBO(0),
+      instanceVBO(0),
+      instanceCapacity(0) {
+}
+
+BoxOverlay::~BoxOverlay() {
+  if (vao == 0) return;
+  glDeleteVertexArrays(1, &vao);
+  glDeleteBuffers(1, &cubeVBO);
+  glDeleteBuffers(1, &indexVBO);
+  glDeleteBuffers(1, &instanceVBO);
+}
+
+void BoxOverlay::clear() {
+  instances.clear();
+}
+
+void BoxOverlay::add(const BoundingBox& bbox) {
+  instances.push_back({bbox.getMin(), bbox.getDimensions()});
+}
+
+void BoxOverlay::draw() {
+  if (instances.empty()) return;
+  if (vao == 0) create();
+
+  glBindVertexArray(vao);
+  glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+  if (instances.size() > instanceCapacity) {
+    // grow geometrically, as the overlay is refilled every frame
+    instanceCapacity = std::max(instances.size(), instanceCapacity * 2);
+    glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(Instance), nullptr,
+                 GL_STREAM_DRAW);
+  }
+  glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(Instance), instances.data());
+  glDrawElementsInstanced(GL_LINES, numCubeIndices, GL_UNSIGNED_SHORT, 0,
+                          static_cast<GLsizei>(instances.size()));
+}
+
+void BoxOverlay::create() {
+  glGenVertexArrays(1, &vao);
+  glBindVertexArray(vao);
+
+  glGenBuffers(1, &cubeVBO);
+  glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVerts), cubeVerts, GL_STATIC_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
+
+  glGenBuffers(1, &indexVBO);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexVBO);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cubeIndices), cubeIndices, GL_STATIC_DRAW);
+
+  glGenBuffers(1, &instanceVBO);
+  glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                        reinterpret_cast<void*>(offsetof(Instance, min)));
+  glVertexAttribDivisor(1, 1);
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                        reinterpret_cast<void*>(offsetof(Instance, extent)));
+  glVertexAttribDivisor(2, 1);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <boundingbox/boundingbox.h>
+
+// Draws the edges of many boxes with one instanced call: a shared unit cube
+// is scaled and moved to each box by a per-instance min and extent. The GL
+// objects are only created by the first draw().
+class BoxOverlay {
+ public:
+  BoxOverlay();
+  ~BoxOverlay();
+
+  BoxOverlay(const BoxOverlay&) = delete;
+  BoxOverlay& operator=(const BoxOverlay&) = delete;
+
+  void clear();
+  void add(const BoundingBox& bbox);
+  // Uploads the boxes added since clear() and draws them, with a program
+  // taking the attributes of bbox-vertex.glsl bound.
+  void draw();
+
+ private:
+  struct Instance {
+    glm::vec3 min;
+    glm::vec3 extent;
+  };
+
+  void create();
+
+  std::vector<Instance> instances;
+  unsigned int vao;
+  unsigned int cubeVBO;
+  unsigned int indexVBO;
+  unsigned int instanceVBO;
+  std::size_t instanceCapacity;  // instances instanceVBO can hold
+};
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <chrono>
+
+#include <build-pipeline/build-pipeline.h>
+
+template <typename Schema>
+BuildPipeline<Schema>::BuildPipeline(const PointCloud& pointCloud, OctreeNode<Schema>& octree,
+                                     std::mutex& octreeMutex, const Options& options)
+    : pointCloud(pointCloud),
+      octree(octree),
+      options(options),
+      queue(queueCapacity),
+      octreeMutex(octreeMutex),
+      renderWaiting(false),
+      stopping(false),
+      isBuilt(false),
+      pointsInserted(0),
+      pointsDropped(0),
+      finished(false) {
+  reader = std::thread(&BuildPipeline::read, this);
+  builder = std::thread(&BuildPipeline::build, this);
+}
+
+template <typename Schema>
+BuildPipeline<Schema>::~BuildPipeline() {
+  // closing the queue stops both stages when quitting mid-build
+  stopping = true;
+  queue.close();
+  if (reader.joinable()) reader.join();
+  if (builder.joinable()) builder.join();
+}
+
+template <typename Schema>
+std::unique_lock<std::mutex> BuildPipeline<Schema>::lockOctree() {
+  // the builder backs off while this is set, so frames are not starved by
+  // it relocking straight after each chunk
+  renderWaiting = true;
+  std::unique_lock<std::mutex> lock(octreeMutex);
+  renderWaiting = false;
+  return lock;
+}
+
+template <typename Schema>
+bool BuildPipeline<Schema>::upload(std::uint64_t pointBudget) {
+  if (finished) return true;
+
+  // read before uploading: once set, no insert can slip in after the upload
+  const bool built = isBuilt;
+  if (!octree.bufferChanged(pointBudget, built) || !built) return false;
+
+  if (!options.keepBuildData) octree.releaseBuildData();
+  reader.join();
+  builder.join();
+  finished = true;
+  return true;
+}
+
+template <typename Schema>
+bool BuildPipeline<Schema>::isFinished() const {
+  return finished;
+}
+
+template <typename Schema>
+bool BuildPipeline<Schema>::hasFailed() const {
+  return !error.empty();
+}
+
+template <typename Schema>
+const std::string& BuildPipeline<Schema>::getError() const {
+  return error;
+}
+
+template <typename Schema>
+std::uint64_t BuildPipeline<Schema>::getPointsInserted() const {
+  return pointsInserted;
+}
+
+template <typename Schema>
+std::uint64_t BuildPipeline<Schema>::getPointsDropped() const {
+  return pointsDropped;
+}
+
+template <typename Schema>
+void BuildPipeline<Schema>::read() {
+  // the builder inserts what was queued before an error, then stops, and
+  // the render thread reports it once the pipeline has finished
+  std::string readError;
+  const bool isRead = pointCloud.stream(
+      [this](const PointBatch& batch) { return queue.push(batch); }, readError);
+  if (!isRead) error = readError.empty() ? "Failed to read the file" : readError;
+  queue.close();
+}
+
+template <typename Schema>
+void BuildPipeline<Schema>::build() {
+  const auto start = std::chrono::steady_clock::now();
+  const BoundingBox& bounds = octree.getBoundingBox();
+  std::uint64_t pointsPaced = 0;
+
+  PointBatch batch;
+  while (queue.pop(batch) && !stopping) {
+    Schema::fillMissing(batch);
+    for (std::size_t begin = 0; begin < batch.size() && !stopping; begin += insertChunkSize) {
+      const std::size_t end = std::min(batch.size(), begin + insertChunkSize);
+      if (options.pointsPerSecond > 0) {
+        // per chunk, so quitting never waits long on a slow rate
+        std::this_thread::sleep_until(
+            start + std::chrono::duration<double>(static_cast<double>(pointsPaced) /
+                                                  options.pointsPerSecond));
+        pointsPaced += end - begin;
+      }
+
+      while (renderWaiting) std::this_thread::yield();
+
+      std::lock_guard<std::mutex> lock(octreeMutex);
+      std::uint64_t dropped = 0;
+      for (std::size_t i = begin; i < end; i++) {
+        if (options.dropOutside && !bounds.contains(batch.positions[i])) {
+          dropped++;
+          continue;
+        }
+        octree.insert(Schema::getPoint(batch, i));
+      }
+      pointsInserted += end - begin - dropped;
+      pointsDropped += dropped;
+    }
+  }
+  isBuilt = true;
+}
+
+#define INSTANTIATE_BUILD_PIPELINE(...) template class BuildPipeline<PointSchema<__VA_ARGS__>>;
+POINT_SCHEMAS(INSTANTIATE_BUILD_PIPELINE)
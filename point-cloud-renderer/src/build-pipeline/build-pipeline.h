@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <octree/octree-node.h>
+#include <parallel/parallel.h>
+#include <point-cloud/point-cloud.h>
+#include <point-reader/point-reader.h>
+#include <point-schema/point-schema.h>
+
+// Runs the stages of a streaming build concurrently: a reader thread decodes
+// batches of a scanned PointCloud into a bounded queue, a builder thread
+// inserts them into the octree, and the render thread uploads changed nodes
+// each frame within an upload budget. The coarse levels can be drawn long
+// before the whole file has been read and refine as points arrive.
+//
+// The octree can also be one that is already built and drawn, with its
+// build data kept, to insert live points into, e.g. from a mobile scanner.
+// Attributes of the octree's schema that the streamed file lacks are given
+// their default values.
+template <typename Schema>
+class BuildPipeline {
+ public:
+  struct Options {
+    // leave the octree's build data in place once finished, so more points
+    // can be inserted later
+    bool keepBuildData = false;
+    // skip points outside the octree's bounds instead of inserting them;
+    // needed when the octree was not built from the same file
+    bool dropOutside = false;
+    // when nonzero, paces insertion, e.g. to replay a scan at the rate its
+    // scanner produced it
+    std::uint64_t pointsPerSecond = 0;
+  };
+
+  // batches in flight between the reader and the builder
+  static constexpr std::size_t queueCapacity = 4;
+  // points the builder inserts per lock, bounding how long a frame can wait
+  static constexpr std::size_t insertChunkSize = 4096;
+
+  // `pointCloud`, `octree` and `octreeMutex`, which guards the octree against
+  // other threads reading it, must outlive the pipeline
+  BuildPipeline(const PointCloud& pointCloud, OctreeNode<Schema>& octree,
+                std::mutex& octreeMutex, const Options& options);
+  ~BuildPipeline();
+
+  BuildPipeline(const BuildPipeline&) = delete;
+  BuildPipeline& operator=(const BuildPipeline&) = delete;
+
+  // Guards the octree against the builder thread. Hold it while uploading
+  // or drawing until isFinished().
+  std::unique_lock<std::mutex> lockOctree();
+
+  // Render thread, with the octree locked: uploads up to about `pointBudget`
+  // points of changed nodes. Once every point has been inserted and
+  // uploaded, frees the build data unless kept and returns true. A read
+  // error ends the stream early, so the points read until then are kept.
+  bool upload(std::uint64_t pointBudget);
+  bool isFinished() const;
+  // once finished, whether reading the file failed, and why
+  bool hasFailed() const;
+  const std::string& getError() const;
+  std::uint64_t getPointsInserted() const;
+  std::uint64_t getPointsDropped() const;  // outside the bounds, see Options
+
+ private:
+  void read();
+  void build();
+
+  const PointCloud& pointCloud;
+  OctreeNode<Schema>& octree;
+  Options options;
+  parallel::BoundedQueue<PointBatch> queue;
+  std::mutex& octreeMutex;
+  std::atomic<bool> renderWaiting;
+  std::atomic<bool> stopping;
+  std::atomic<bool> isBuilt;
+  std::atomic<std::uint64_t> pointsInserted;
+  std::atomic<std::uint64_t> pointsDropped;
+  std::string error;  // the reader's, set before it closes the queue
+  bool finished;
+  std::thread reader;
+  std::thread builder;
+};
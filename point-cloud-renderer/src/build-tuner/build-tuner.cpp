@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <build-tuner/build-tuner.h>
+#include <timer/timer.h>
+
+namespace {
+
+  constexpr unsigned int minPointsPerNodeCandidates[] = {2500, 5000, 10000, 20000, 40000};
+  constexpr unsigned int resolutionCandidates[] = {64, 128, 256, 512};
+  constexpr float minScreenSizeCandidates[] = {0.5f, 1.f, 2.f, 4.f};
+
+  // A candidate's score sums, over its measures, how many times worse than
+  // the best candidate it is, in powers of two, times the measure's weight.
+  // The frontier stands for image quality, so it weighs as much as the costs
+  // of building, holding and selecting nodes put together.
+  constexpr float buildTimeWeight = 1.f;
+  constexpr float memoryWeight = 1.f;
+  constexpr float nodeCountWeight = 0.5f;
+  constexpr float selectTimeWeight = 0.5f;
+  constexpr float drawCallWeight = 1.f;
+  constexpr float frontierWeight = 4.f;
+
+  // the camera path in the units of the cloud's model matrix, where the
+  // cloud's bounding box diagonal is 300 and the default camera sits at z = 100
+  constexpr float orbitRadius = 250.f;
+  constexpr float orbitHeight = 60.f;
+  constexpr float flightStart = 200.f;
+
+  float getCost(float value, float best, float weight) {
+    // keeps measures too small to time, or views with no nodes left to
+    // draw, from dividing by zero
+    constexpr float floor = 1e-3f;
+    return weight * std::log2(std::max(value, floor) / std::max(best, floor));
+  }
+
+}  // namespace
+
+template <typename Schema>
+BuildTuner<Schema>::BuildTuner(const PointCloud& sample, std::uint64_t fullPoints,
+                               std::uint64_t frameBudget, OctreeNodeBase::Sampling sampling,
+                               std::uint64_t seed, const View& view)
+    : sample(sample),
+      fraction(std::min(1.f, static_cast<float>(sample.getPoints().size()) /
+                                 static_cast<float>(std::max<std::uint64_t>(1, fullPoints)))),
+      frameBudget(frameBudget),
+      sampling(sampling),
+      seed(seed),
+      view(view) {
+}
+
+template <typename Schema>
+std::vector<glm::mat4> BuildTuner<Schema>::getCameraPath(const glm::mat4& modelMatrix) {
+  std::vector<glm::mat4> path;
+  const glm::vec3 up(0.f, 1.f, 0.f);
+
+  // half the views orbit the whole cloud, the rest fly through its middle
+  const unsigned int orbitViews = cameraPathViews / 2;
+  for (unsigned int i = 0; i < orbitViews; i++) {
+    const float angle = glm::two_pi<float>() * i / orbitViews;
+    const glm::vec3 eye(orbitRadius * std::sin(angle), orbitHeight,
+                        orbitRadius * std::cos(angle));
+    path.push_back(glm::lookAt(eye, glm::vec3(0.f), up) * modelMatrix);
+  }
+
+  const unsigned int flightViews = cameraPathViews - orbitViews;
+  for (unsigned int i = 0; i < flightViews; i++) {
+    const float z = flightStart - 2.f * flightStart * i / std::max(1u, flightViews - 1);
+    const glm::vec3 eye(0.f, 0.f, z);
+    path.push_back(glm::lookAt(eye, eye + glm::vec3(0.f, 0.f, -1.f), up) * modelMatrix);
+  }
+  return path;
+}
+
+template <typename Schema>
+std::vector<typename BuildTuner<Schema>::Result> BuildTuner<Schema>::run() {
+  const std::uint64_t sampleBudget =
+      std::max<std::uint64_t>(1, static_cast<std::uint64_t>(frameBudget * fraction));
+  const std::vector<glm::mat4> path = getCameraPath(sample.getModelMatrix());
+  LODSelector<Schema> selector(sampleBudget);
+
+  std::cout << "Tuning on " << sample.getPoints().size() << " points ("
+            << fraction * 100.f << "% of the cloud):" << std::endl;
+
+  std::vector<Result> results;
+  Timer timer;
+  for (unsigned int minPointsPerNode : minPointsPerNodeCandidates) {
+    for (unsigned int resolution : resolutionCandidates) {
+      const auto sampleMinPoints = std::max(
+          1u, static_cast<unsigned int>(std::lround(minPointsPerNode * fraction)));
+      const auto sampleResolution = std::max(
+          2u, static_cast<unsigned int>(std::lround(resolution * std::sqrt(fraction))));
+
+      timer.start();
+      OctreeNode<Schema> octree = OctreeNode<Schema>::buildOctree(
+          sample, sampleMinPoints, sampleResolution, sampling, seed);
+      timer.end();
+
+      Result built;
+      built.buildMS = timer.getMS() / fraction;
+      built.memory = static_cast<std::size_t>(octree.getBuildMemory() / fraction);
+      built.nodes = octree.getNodeCount();
+      std::cout << "  - " << minPointsPerNode << " points per node, resolution "
+                << resolution << ": " << built.nodes << " nodes" << std::endl;
+
+      for (float minScreenSize : minScreenSizeCandidates) {
+        selector.setMinScreenSize(minScreenSize);
+        Result result = built;
+        result.parameters = {minPointsPerNode, resolution, minScreenSize};
+
+        std::uint64_t drawCalls = 0;
+        double frontier = 0.0;
+        timer.start();
+        for (const glm::mat4& modelViewMat : path) {
+          const LODSelectorBase::Selection& selection =
+              selector.select(octree, view, modelViewMat);
+          drawCalls += selection.nodes;
+          frontier += selection.frontier;
+        }
+        timer.end();
+
+        result.selectMS = timer.getMS() / path.size();
+        result.drawCalls = static_cast<float>(drawCalls) / path.size();
+        result.frontier = static_cast<float>(frontier / path.size());
+        results.push_back(result);
+      }
+    }
+  }
+
+  score(results);
+  std::sort(results.begin(), results.end(),
+            [](const Result& a, const Result& b) { return a.score < b.score; });
+  return results;
+}
+
+template <typename Schema>
+void BuildTuner<Schema>::score(std::vector<Result>& results) {
+  Result best = results.front();
+  for (const Result& result : results) {
+    best.buildMS = std::min(best.buildMS, result.buildMS);
+    best.memory = std::min(best.memory, result.memory);
+    best.nodes = std::min(best.nodes, result.nodes);
+    best.selectMS = std::min(best.selectMS, result.selectMS);
+    best.drawCalls = std::min(best.drawCalls, result.drawCalls);
+    best.frontier = std::min(best.frontier, result.frontier);
+  }
+
+  for (Result& result : results) {
+    result.score = getCost(result.buildMS, best.buildMS, buildTimeWeight) +
+                   getCost(result.memory, best.memory, memoryWeight) +
+                   getCost(result.nodes, best.nodes, nodeCountWeight) +
+                   getCost(result.selectMS, best.selectMS, selectTimeWeight) +
+                   getCost(result.drawCalls, best.drawCalls, drawCallWeight) +
+                   getCost(result.frontier, best.frontier, frontierWeight);
+  }
+}
+
+#define INSTANTIATE_BUILD_TUNER(...) template class BuildTuner<PointSchema<__VA_ARGS__>>;
+POINT_SCHEMAS(INSTANTIATE_BUILD_TUNER)
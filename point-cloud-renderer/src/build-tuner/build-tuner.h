@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <lod-selector/lod-selector.h>
+#include <octree/octree-node.h>
+#include <point-cloud/point-cloud.h>
+#include <point-schema/point-schema.h>
+#include <view/view.h>
+
+// Picks MIN POINTS PER NODE, the grid resolution and the minimum screen size
+// for a cloud from quick builds of a random subsample of it. Each pair of
+// node size and resolution candidates is built once, then every screen size
+// candidate selects nodes from that tree with an LODSelector, headless,
+// along a camera path that orbits the cloud and flies through it.
+//
+// The subsample holds a fraction of the cloud's points, so the candidates are
+// scaled to keep the tree's shape: node sizes and the frame budget by the
+// fraction and, as scans sample surfaces, resolutions by its square root.
+// Build times and memory are scaled back up, which makes them estimates; it
+// is the ranking that matters.
+template <typename Schema>
+class BuildTuner {
+ public:
+  struct Parameters {
+    unsigned int minPointsPerNode;
+    unsigned int resolution;
+    float minScreenSize;
+  };
+
+  struct Result {
+    Parameters parameters;  // for the full cloud
+    float buildMS = 0.f;
+    std::size_t memory = 0;  // see OctreeNode::getBuildMemory()
+    std::uint64_t nodes = 0;
+    // averages per view of the camera path
+    float selectMS = 0.f;
+    float drawCalls = 0.f;
+    float frontier = 0.f;  // see LODSelectorBase::Selection
+    float score = 0.f;     // lower is better
+  };
+
+  static constexpr std::uint64_t defaultSamplePoints = 1 << 19;
+  static constexpr unsigned int cameraPathViews = 64;
+
+  // `sample` is a random subsample of a cloud that loads `fullPoints` points
+  BuildTuner(const PointCloud& sample, std::uint64_t fullPoints,
+             std::uint64_t frameBudget, OctreeNodeBase::Sampling sampling,
+             std::uint64_t seed, const View& view);
+
+  // Builds and scores every candidate, printing progress. Sorted best first.
+  std::vector<Result> run();
+
+  // the model-view matrices of cameraPathViews views orbiting and flying
+  // through a cloud placed by `modelMatrix`, see PointCloud::getModelMatrix()
+  static std::vector<glm::mat4> getCameraPath(const glm::mat4& modelMatrix);
+
+ private:
+  static void score(std::vector<Result>& results);
+
+  const PointCloud& sample;
+  float fraction;  // of the full cloud's points in the sample
+  std::uint64_t frameBudget;
+  OctreeNodeBase::Sampling sampling;
+  std::uint64_t seed;
+  View view;
+};
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <colour-map/colour-map.h>
+
+namespace {
+
+  // evenly spaced 0xRRGGBB stops of each map, interpolated linearly
+  const std::vector<std::uint32_t> mapStops[colourmap::numMaps] = {
+      // dark grey to white, as the height gradient drawn before maps
+      {0x1a1a1a, 0xffffff},
+      // viridis
+      {0x440154, 0x482475, 0x414487, 0x355f8d, 0x2a788e, 0x21918c, 0x22a884, 0x44bf70,
+       0x7ad151, 0xbddf26, 0xfde725},
+      // turbo
+      {0x30123b, 0x4454c4, 0x4490fe, 0x1fc8de, 0x29efa2, 0x7dff56, 0xc1f334, 0xf1ca3a,
+       0xfd8a26, 0xe4460a, 0x7a0403},
+  };
+
+  glm::vec3 toColour(std::uint32_t rgb) {
+    return glm::vec3((rgb >> 16) & 0xff, (rgb >> 8) & 0xff, rgb & 0xff);
+  }
+
+  glm::u8vec3 sample(const std::vector<std::uint32_t>& stops, float t) {
+    const float position = t * static_cast<float>(stops.size() - 1);
+    const std::size_t lower = std::min(static_cast<std::size_t>(position), stops.size() - 2);
+    const glm::vec3 colour = glm::mix(toColour(stops[lower]), toColour(stops[lower + 1]),
+                                      position - static_cast<float>(lower));
+    return glm::u8vec3(glm::round(colour));
+  }
+
+}  // namespace
+
+namespace colourmap {
+
+  const char* getModeName(Mode mode) {
+    switch (mode) {
+      case Mode::RGB:
+        return "rgb";
+      case Mode::Classification:
+        return "classification";
+      case Mode::Intensity:
+        return "intensity";
+      default:
+        return "height";
+    }
+  }
+
+  const char* getMapName(Map map) {
+    switch (map) {
+      case Map::Grey:
+        return "grey";
+      case Map::Viridis:
+        return "viridis";
+      default:
+        return "turbo";
+    }
+  }
+
+  std::vector<Mode> getModes(const AttributeSet& attributes) {
+    std::vector<Mode> modes;
+    if (attributes.colours) modes.push_back(Mode::RGB);
+    if (attributes.classifications) modes.push_back(Mode::Classification);
+    if (attributes.intensities) modes.push_back(Mode::Intensity);
+    modes.push_back(Mode::Height);
+    return modes;
+  }
+
+  unsigned int createTexture() {
+    std::vector<glm::u8vec3> texels;
+    texels.reserve(mapWidth * numMaps);
+    for (const std::vector<std::uint32_t>& stops : mapStops) {
+      for (int x = 0; x < mapWidth; x++) {
+        texels.push_back(sample(stops, static_cast<float>(x) / (mapWidth - 1)));
+      }
+    }
+
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, mapWidth, numMaps, 0, GL_RGB, GL_UNSIGNED_BYTE,
+                 texels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+  }
+
+}  // namespace colourmap
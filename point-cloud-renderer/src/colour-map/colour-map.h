@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+#include <glad/gl.h>
+
+#include <point-reader/point-reader.h>
+
+// Colouring of points in the shader. Scalar attributes are uploaded once and
+// mapped to colour by a texture lookup over a range uniform, so the mode and
+// map switch with a uniform and nothing is re-uploaded.
+namespace colourmap {
+  // what points are coloured by, the colourMode values in vertex.glsl
+  enum class Mode : int {
+    RGB,
+    Classification,  // a fixed palette of the ASPRS classes
+    Intensity,
+    Height,
+  };
+
+  // the maps scalar modes look up, the texture's rows in order
+  enum class Map : int {
+    Grey,
+    Viridis,
+    Turbo,
+  };
+  constexpr int numMaps = 3;
+  constexpr int mapWidth = 256;
+
+  const char* getModeName(Mode mode);
+  const char* getMapName(Map map);
+  // The modes points with `attributes` can be coloured by, in the order C
+  // cycles through them. The first is the default.
+  std::vector<Mode> getModes(const AttributeSet& attributes);
+  // Creates a mapWidth x numMaps texture holding every map, each running left
+  // to right from the low end of the range, and leaves it bound.
+  unsigned int createTexture();
+}
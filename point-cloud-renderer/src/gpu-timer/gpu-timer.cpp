@@ -0,0 +1,46 @@
+#include <gpu-timer/gpu-timer.h>
+
+GpuTimer::GpuTimer()
+    : queries{0},
+      oldest(0),
+      numPending(0),
+      elapsedMS(0.f) {
+}
+
+GpuTimer::~GpuTimer() {
+  if (queries[0] == 0) return;
+  glDeleteQueries(numQueries, queries);
+}
+
+void GpuTimer::begin() {
+  if (queries[0] == 0) glGenQueries(numQueries, queries);
+
+  // every query is in flight only if the GPU is several frames behind
+  collect(numPending == numQueries);
+  glBeginQuery(GL_TIME_ELAPSED, queries[(oldest + numPending) % numQueries]);
+}
+
+void GpuTimer::end() {
+  glEndQuery(GL_TIME_ELAPSED);
+  numPending++;
+  collect(false);
+}
+
+float GpuTimer::getMS() const {
+  return elapsedMS;
+}
+
+void GpuTimer::collect(bool wait) {
+  while (numPending > 0) {
+    GLint isAvailable = GL_FALSE;
+    if (!wait) glGetQueryObjectiv(queries[oldest], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+    if (!wait && !isAvailable) return;
+
+    GLuint64 elapsedNS = 0;
+    glGetQueryObjectui64v(queries[oldest], GL_QUERY_RESULT, &elapsedNS);
+    elapsedMS = static_cast<float>(elapsedNS) / 1e6f;
+    oldest = (oldest + 1) % numQueries;
+    numPending--;
+    wait = false;
+  }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <glad/gl.h>
+
+// Measures how long the GPU takes over the commands between begin() and
+// end() with timer queries. Results are read frames later, once they are
+// available, so measuring never makes the CPU wait for the GPU. The query
+// objects are only created by the first begin().
+class GpuTimer {
+ public:
+  // measurements in flight at once
+  static constexpr int numQueries = 4;
+
+  GpuTimer();
+  ~GpuTimer();
+
+  GpuTimer(const GpuTimer&) = delete;
+  GpuTimer& operator=(const GpuTimer&) = delete;
+
+  void begin();
+  void end();
+  // the latest finished measurement, 0 before the first
+  float getMS() const;
+
+ private:
+  // reads the finished measurements, waiting for the oldest if `wait`
+  void collect(bool wait);
+
+  unsigned int queries[numQueries];
+  int oldest;  // query of the oldest measurement in flight
+  int numPending;
+  float elapsedMS;
+};
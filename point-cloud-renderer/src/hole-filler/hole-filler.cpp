@@ -0,0 +1,124 @@
+#include <hole-filler/hole-filler.h>
+
+namespace {
+
+  // texture units the passes read colour and depth from; the points
+  // shader's colour maps are on unit 0
+  constexpr int colourUnit = 3;
+  constexpr int depthUnit = 4;
+
+  // allocates `texture` at `width` by `height`, read texel by texel
+  void allocateTexture(unsigned int texture, GLint internalFormat, GLenum format, GLenum type,
+                       int width, int height) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  }
+
+}  // namespace
+
+HoleFiller::HoleFiller()
+    : sceneFramebuffer(0),
+      sceneColour(0),
+      sceneDepth(0),
+      fillFramebuffers{0},
+      fillColours{0},
+      fillDepths{0},
+      vao(0),
+      width(0),
+      height(0) {
+}
+
+HoleFiller::~HoleFiller() {
+  if (sceneFramebuffer == 0) return;
+  glDeleteFramebuffers(1, &sceneFramebuffer);
+  glDeleteTextures(1, &sceneColour);
+  glDeleteTextures(1, &sceneDepth);
+  glDeleteFramebuffers(2, fillFramebuffers);
+  glDeleteTextures(2, fillColours);
+  glDeleteTextures(2, fillDepths);
+  glDeleteVertexArrays(1, &vao);
+}
+
+void HoleFiller::bind(int width, int height) {
+  if (sceneFramebuffer == 0) create();
+  if (width != this->width || height != this->height) resize(width, height);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void HoleFiller::fill(unsigned int program, unsigned int passes, float zNear, float zFar) {
+  gpuTimer.begin();
+  glDisable(GL_DEPTH_TEST);
+  glUseProgram(program);
+  glUniform1i(glGetUniformLocation(program, "colourIn"), colourUnit);
+  glUniform1i(glGetUniformLocation(program, "depthIn"), depthUnit);
+  glUniform1f(glGetUniformLocation(program, "zNear"), zNear);
+  glUniform1f(glGetUniformLocation(program, "zFar"), zFar);
+  const int isDepthLinearLoc = glGetUniformLocation(program, "isDepthLinear");
+  const int stepSizeLoc = glGetUniformLocation(program, "stepSize");
+  glBindVertexArray(vao);
+
+  for (unsigned int pass = 0; pass < passes; pass++) {
+    // the first pass reads the drawn points, the others the previous pass
+    const bool isFirst = pass == 0;
+    const unsigned int previous = (pass + 1) % 2;
+    glActiveTexture(GL_TEXTURE0 + colourUnit);
+    glBindTexture(GL_TEXTURE_2D, isFirst ? sceneColour : fillColours[previous]);
+    glActiveTexture(GL_TEXTURE0 + depthUnit);
+    glBindTexture(GL_TEXTURE_2D, isFirst ? sceneDepth : fillDepths[previous]);
+    glUniform1i(isDepthLinearLoc, !isFirst);
+    glUniform1i(stepSizeLoc, 1 << (passes - 1 - pass));
+
+    // the last pass goes to the window, which drops the depth it writes
+    glBindFramebuffer(GL_FRAMEBUFFER, pass + 1 == passes ? 0 : fillFramebuffers[pass % 2]);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+  }
+
+  glActiveTexture(GL_TEXTURE0);
+  glEnable(GL_DEPTH_TEST);
+  gpuTimer.end();
+}
+
+float HoleFiller::getGpuMS() const {
+  return gpuTimer.getMS();
+}
+
+void HoleFiller::create() {
+  glGenFramebuffers(1, &sceneFramebuffer);
+  glGenTextures(1, &sceneColour);
+  glGenTextures(1, &sceneDepth);
+  glGenFramebuffers(2, fillFramebuffers);
+  glGenTextures(2, fillColours);
+  glGenTextures(2, fillDepths);
+  glGenVertexArrays(1, &vao);
+}
+
+void HoleFiller::resize(int width, int height) {
+  this->width = width;
+  this->height = height;
+
+  glActiveTexture(GL_TEXTURE0 + colourUnit);
+  allocateTexture(sceneColour, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+  allocateTexture(sceneDepth, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, width,
+                  height);
+  glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sceneColour, 0);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, sceneDepth, 0);
+
+  const GLenum drawBuffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+  for (int i = 0; i < 2; i++) {
+    allocateTexture(fillColours[i], GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+    allocateTexture(fillDepths[i], GL_R32F, GL_RED, GL_FLOAT, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, fillFramebuffers[i]);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fillColours[i],
+                           0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, fillDepths[i], 0);
+    glDrawBuffers(2, drawBuffers);
+  }
+  glActiveTexture(GL_TEXTURE0);
+}
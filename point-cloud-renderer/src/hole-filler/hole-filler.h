@@ -0,0 +1,55 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <gpu-timer/gpu-timer.h>
+
+// Fills the gaps a low point budget leaves between points with full-screen
+// passes run after the points are drawn, whose cost depends on the window
+// size and not on the points. Each pass fills a pixel showing the
+// background, or a farther surface through a gap, with the nearest surface
+// around it, if that surface lies on opposite sides of the pixel at the
+// pass's step. Steps halve from pass to pass down to one pixel, so the
+// first pass bridges the widest gaps, while the edges of surfaces never
+// grow. The points are drawn into the filler's own single-sampled target.
+// The GL objects are only created by the first bind().
+class HoleFiller {
+ public:
+  static constexpr unsigned int defaultPasses = 3;
+  // the first pass's step is 2^(passes - 1) pixels
+  static constexpr unsigned int maxPasses = 6;
+
+  HoleFiller();
+  ~HoleFiller();
+
+  HoleFiller(const HoleFiller&) = delete;
+  HoleFiller& operator=(const HoleFiller&) = delete;
+
+  // Draws go into the filler's target, resized to `width` by `height` and
+  // cleared, until fill().
+  void bind(int width, int height);
+  // Runs `passes` fill passes with `program`, built from
+  // fullscreen-vertex.glsl and hole-fill-frag.glsl, the last into the
+  // window's framebuffer, which it binds again. `zNear` and `zFar` are the
+  // clip planes the points were drawn with.
+  void fill(unsigned int program, unsigned int passes, float zNear, float zFar);
+  // GPU time of the passes of a recent fill(), see GpuTimer
+  float getGpuMS() const;
+
+ private:
+  void create();
+  void resize(int width, int height);
+
+  unsigned int sceneFramebuffer;
+  unsigned int sceneColour;
+  unsigned int sceneDepth;
+  // ping-pong targets of the passes before the last, with the colour and
+  // the linear depth of each pixel, 0 for the background
+  unsigned int fillFramebuffers[2];
+  unsigned int fillColours[2];
+  unsigned int fillDepths[2];
+  unsigned int vao;  // empty: the full-screen passes make their own vertices
+  int width;
+  int height;
+  GpuTimer gpuTimer;
+};
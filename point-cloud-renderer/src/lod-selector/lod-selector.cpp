@@ -0,0 +1,406 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+
+#include <lod-selector/lod-selector.h>
+
+namespace {
+  // Each draw list entry is drawn by one glDrawArrays() call, whose count is
+  // a signed 32-bit GLsizei. Nodes are split well before that, except those
+  // at the depth or extent limit, which keep every point that reaches them
+  // (e.g. billions of duplicates), so larger counts are clamped.
+  std::uint32_t toEntryCount(std::size_t drawSize) {
+    constexpr std::size_t maxCount = std::numeric_limits<std::int32_t>::max();
+    if (drawSize <= maxCount) return static_cast<std::uint32_t>(drawSize);
+
+    static std::atomic<bool> isWarned(false);
+    if (!isWarned.exchange(true)) {
+      std::cerr << "Warning: A node holds " << drawSize << " points, only the first "
+                << maxCount << " are drawn" << std::endl;
+    }
+    return static_cast<std::uint32_t>(maxCount);
+  }
+}  // namespace
+
+template <typename Schema>
+LODSelector<Schema>::LODSelector(std::uint64_t pointBudget, float minScreenSize)
+    : pointBudget(pointBudget),
+      minScreenSize(minScreenSize),
+      viewpoint(1),
+      selections(1) {
+}
+
+template <typename Schema>
+std::uint64_t LODSelector<Schema>::getPointBudget() const {
+  return pointBudget;
+}
+
+template <typename Schema>
+void LODSelector<Schema>::setPointBudget(std::uint64_t pointBudget) {
+  this->pointBudget = pointBudget;
+}
+
+template <typename Schema>
+float LODSelector<Schema>::getMinScreenSize() const {
+  return minScreenSize;
+}
+
+template <typename Schema>
+void LODSelector<Schema>::setMinScreenSize(float minScreenSize) {
+  this->minScreenSize = minScreenSize;
+}
+
+template <typename Schema>
+const OctreeNodeBase::DisplayFilter& LODSelector<Schema>::getDisplayFilter() const {
+  return displayFilter;
+}
+
+template <typename Schema>
+void LODSelector<Schema>::setDisplayFilter(const OctreeNodeBase::DisplayFilter& displayFilter) {
+  this->displayFilter = displayFilter;
+}
+
+template <typename Schema>
+bool LODSelector<Schema>::getOcclusionCulling() const {
+  return occlusionCulling;
+}
+
+template <typename Schema>
+void LODSelector<Schema>::setOcclusionCulling(bool occlusionCulling) {
+  this->occlusionCulling = occlusionCulling;
+}
+
+template <typename Schema>
+void LODSelector<Schema>::buildDrawList(const Node& root, const View& view,
+                                        const glm::mat4& modelViewMat, DrawList& drawList) {
+  pick(root, getViewpoint(view, modelViewMat), false, &drawList);
+}
+
+template <typename Schema>
+void LODSelector<Schema>::buildDrawLists(const Node& root,
+                                         const std::vector<Viewpoint>& viewpoints,
+                                         std::vector<DrawList>& drawLists) {
+  drawLists.resize(viewpoints.size());
+  pick(root, viewpoints, false, drawLists.data());
+}
+
+template <typename Schema>
+void LODSelector<Schema>::buildDrawLists(const Scene<Schema>& scene, const View& view,
+                                         const glm::mat4& modelViewMat,
+                                         std::vector<DrawList>& drawLists) {
+  const std::size_t numTrees = scene.getNumTrees();
+  drawLists.resize(numTrees);
+  if (numTrees == 1) {
+    buildDrawList(scene.getTree(0), view, modelViewMat * scene.getModelMatrix(0),
+                  drawLists[0]);
+    return;
+  }
+
+  // one viewpoint, moved onto each tree in turn, gathers every tree's nodes
+  // into one list
+  Viewpoint& current = viewpoint.front();
+  current.view = view;
+  current.pointBudget = pointBudget;
+  reset(viewpoint);
+  areRootsRanked = true;
+  treeModelViews.resize(numTrees);
+  for (std::size_t i = 0; i < numTrees; i++) {
+    current.modelViewMat = modelViewMat * scene.getModelMatrix(i);
+    treeModelViews[i] = current.modelViewMat;
+    viewScales.front() = glm::length(glm::vec3(current.modelViewMat[0]));
+    collect(scene.getTree(i), 1, static_cast<std::uint32_t>(i), false);
+  }
+  areRootsRanked = false;
+  activeViewpoints = nullptr;
+
+  for (DrawList& drawList : drawLists) {
+    drawList.entries.clear();
+    drawList.points = 0;
+  }
+  Selection& selection = selections.front();
+  std::vector<Candidate>& sceneCandidates = candidates.front();
+  selection.candidates = sceneCandidates.size();
+  std::sort(sceneCandidates.begin(), sceneCandidates.end(),
+            [](const Candidate& a, const Candidate& b) { return a.screenSize > b.screenSize; });
+  if (occlusionCulling) cullOccluded(view, pointBudget, sceneCandidates, selection);
+
+  selection.frontier = minScreenSize;
+  for (const Candidate& candidate : sceneCandidates) {
+    const std::uint32_t nodePointCount = toEntryCount(candidate.node->getDrawSize());
+    if (selection.points + nodePointCount > pointBudget) {
+      selection.frontier = candidate.screenSize;
+      break;
+    }
+    DrawList& drawList = drawLists[candidate.tree];
+    drawList.entries.push_back({candidate.node, nodePointCount});
+    drawList.points += nodePointCount;
+    selection.points += nodePointCount;
+    selection.nodes++;
+  }
+  for (std::size_t i = 0; i < numTrees; i++) {
+    buildSpacingTree(scene.getTree(i), drawLists[i]);
+  }
+}
+
+template <typename Schema>
+const LODSelectorBase::Selection& LODSelector<Schema>::select(
+    const Node& root, const View& view, const glm::mat4& modelViewMat) {
+  pick(root, getViewpoint(view, modelViewMat), true, nullptr);
+  return selections.front();
+}
+
+template <typename Schema>
+const std::vector<LODSelectorBase::Selection>& LODSelector<Schema>::select(
+    const Node& root, const std::vector<Viewpoint>& viewpoints) {
+  pick(root, viewpoints, true, nullptr);
+  return selections;
+}
+
+template <typename Schema>
+const LODSelectorBase::Selection& LODSelector<Schema>::getSelection() const {
+  return selections.front();
+}
+
+template <typename Schema>
+const std::vector<LODSelectorBase::Selection>& LODSelector<Schema>::getSelections() const {
+  return selections;
+}
+
+template <typename Schema>
+const std::vector<LODSelectorBase::Viewpoint>& LODSelector<Schema>::getViewpoint(
+    const View& view, const glm::mat4& modelViewMat) {
+  viewpoint.front().view = view;
+  viewpoint.front().modelViewMat = modelViewMat;
+  viewpoint.front().pointBudget = pointBudget;
+  return viewpoint;
+}
+
+template <typename Schema>
+std::uint64_t LODSelector<Schema>::reset(const std::vector<Viewpoint>& viewpoints) {
+  if (viewpoints.empty() || viewpoints.size() > maxViewpoints) {
+    std::cerr << "Error: LOD selection takes 1 to " << maxViewpoints << " viewpoints, not "
+              << viewpoints.size() << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  const std::size_t numViews = viewpoints.size();
+  activeViewpoints = &viewpoints;
+  viewScales.resize(numViews);
+  candidates.resize(numViews);
+  selections.assign(numViews, Selection());
+  for (std::size_t i = 0; i < numViews; i++) {
+    // the model matrix only rotates and scales uniformly
+    viewScales[i] = glm::length(glm::vec3(viewpoints[i].modelViewMat[0]));
+    candidates[i].clear();
+  }
+  return numViews == maxViewpoints ? ~std::uint64_t(0) : (std::uint64_t(1) << numViews) - 1;
+}
+
+template <typename Schema>
+void LODSelector<Schema>::pick(const Node& root, const std::vector<Viewpoint>& viewpoints,
+                               bool isHeadless, DrawList* drawLists) {
+  const std::size_t numViews = viewpoints.size();
+  collect(root, reset(viewpoints), 0, isHeadless);
+
+  // the root node (LOD 0) is always drawn, unless filtered out
+  const bool isRootDrawn =
+      isHeadless || (root.isBuffered && !root.isFilteredOut(displayFilter));
+  const std::uint32_t rootPointCount = toEntryCount(root.getDrawSize());
+
+  for (std::size_t i = 0; i < numViews; i++) {
+    Selection& selection = selections[i];
+    DrawList* drawList = drawLists ? &drawLists[i] : nullptr;
+    if (drawList) drawList->entries.clear();
+
+    if (isRootDrawn) {
+      if (drawList) drawList->entries.push_back({&root, rootPointCount});
+      selection.points = rootPointCount;
+      selection.nodes = 1;
+    }
+
+    std::vector<Candidate>& viewCandidates = candidates[i];
+    selection.candidates = viewCandidates.size();
+    std::sort(viewCandidates.begin(), viewCandidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.screenSize > b.screenSize; });
+    if (occlusionCulling) {
+      treeModelViews.assign(1, viewpoints[i].modelViewMat);
+      cullOccluded(viewpoints[i].view, viewpoints[i].pointBudget, viewCandidates, selection);
+    }
+
+    selection.frontier = root.activeChildren != 0 ? minScreenSize : 0.f;
+    for (const Candidate& candidate : viewCandidates) {
+      const std::uint32_t nodePointCount = toEntryCount(candidate.node->getDrawSize());
+      if (selection.points + nodePointCount > viewpoints[i].pointBudget) {
+        selection.frontier = candidate.screenSize;
+        break;
+      }
+      if (drawList) drawList->entries.push_back({candidate.node, nodePointCount});
+      selection.points += nodePointCount;
+      selection.nodes++;
+    }
+    if (drawList) {
+      drawList->points = selection.points;
+      buildSpacingTree(root, *drawList);
+    }
+  }
+  activeViewpoints = nullptr;
+}
+
+template <typename Schema>
+void LODSelector<Schema>::cullOccluded(const View& view, std::uint64_t pointBudget,
+                                       std::vector<Candidate>& viewCandidates,
+                                       Selection& selection) {
+  // the occluders are drawn whatever the cull finds, so they are taken from
+  // the front of the list, within the budget, and never culled themselves
+  occlusionCuller.reset(view);
+  std::uint64_t points = selection.points;
+  std::size_t numOccluders = 0;
+  std::size_t numOccluderNodes = 0;
+  while (numOccluders < viewCandidates.size() && numOccluderNodes < maxOccluderNodes) {
+    const Candidate& candidate = viewCandidates[numOccluders];
+    points += toEntryCount(candidate.node->getDrawSize());
+    if (points > pointBudget) break;
+    if (candidate.node->depth >= Node::initialDepth + minOccluderDepth &&
+        candidate.node->occupancy != 0) {
+      addOccluders(*candidate.node, candidate.tree);
+      numOccluderNodes++;
+    }
+    numOccluders++;
+  }
+  occlusionCuller.rasterize();
+
+  occlusionSpheres.clear();
+  for (std::size_t i = numOccluders; i < viewCandidates.size(); i++) {
+    const Node& node = *viewCandidates[i].node;
+    const glm::mat4& modelViewMat = treeModelViews[viewCandidates[i].tree];
+    const float viewScale = glm::length(glm::vec3(modelViewMat[0]));
+    occlusionSpheres.push_back({modelViewMat * glm::vec4(node.bbox.getCenter(), 1.f),
+                                node.bbox.getBoundingSphereRadius() * viewScale});
+  }
+  occlusionCuller.test(occlusionSpheres, occlusionHidden);
+
+  std::size_t kept = numOccluders;
+  for (std::size_t i = numOccluders; i < viewCandidates.size(); i++) {
+    if (!occlusionHidden[i - numOccluders]) viewCandidates[kept++] = viewCandidates[i];
+  }
+  selection.occluded = viewCandidates.size() - kept;
+  viewCandidates.erase(viewCandidates.begin() + kept, viewCandidates.end());
+}
+
+template <typename Schema>
+void LODSelector<Schema>::addOccluders(const Node& node, std::uint32_t tree) {
+  const std::uint64_t occupancy = node.occupancy;
+  if (occupancy == 0) return;
+
+  const glm::mat4& modelViewMat = treeModelViews[tree];
+  const float viewScale = glm::length(glm::vec3(modelViewMat[0]));
+  const glm::vec3 voxel = node.bbox.getDimensions() / float(Node::occupancyResolution);
+  const float inner = std::min(voxel.x, std::min(voxel.y, voxel.z)) * 0.5f * viewScale;
+  const float outer = glm::length(voxel) * 0.5f * viewScale;
+  constexpr unsigned int resolution = Node::occupancyResolution;
+  for (unsigned int i = 0; i < resolution * resolution * resolution; i++) {
+    if (!(occupancy & (std::uint64_t(1) << i))) continue;
+    const glm::vec3 coords(i / (resolution * resolution), i / resolution % resolution,
+                           i % resolution);
+    const glm::vec4 center(node.bbox.getMin() + (coords + 0.5f) * voxel, 1.f);
+    occlusionCuller.addOccluder(modelViewMat * center, inner, outer);
+  }
+}
+
+template <typename Schema>
+void LODSelector<Schema>::buildSpacingTree(const Node& root, DrawList& drawList) {
+  std::vector<glm::uvec2>& spacingTree = drawList.spacingTree;
+  spacingTree.clear();
+  if (drawList.entries.empty()) return;
+
+  spacingEntries.resize(drawList.entries.size());
+  for (std::size_t i = 0; i < spacingEntries.size(); i++) {
+    spacingEntries[i] = static_cast<std::uint32_t>(i);
+  }
+  spacingQueue.clear();
+  spacingQueue.push_back({&root, 0, spacingEntries.size()});
+  spacingTree.emplace_back(0);
+
+  // the queue is the spacing tree's order, so each node's listed children
+  // are queued together
+  for (std::size_t idx = 0; idx < spacingQueue.size(); idx++) {
+    const SpacingNode current = spacingQueue[idx];
+    const Node& node = *current.node;
+    // the node itself first, then the nodes below it grouped by the child
+    // their centers lie in
+    const auto getOctant = [&](std::uint32_t entry) {
+      const Node* entryNode = drawList.entries[entry].node;
+      return entryNode == &node ? -1
+                                : static_cast<int>(
+                                      node.getChildNodeIndex(entryNode->bbox.getCenter()));
+    };
+    const auto first = spacingEntries.begin() + current.begin;
+    const auto last = spacingEntries.begin() + current.end;
+    std::sort(first, last, [&](std::uint32_t a, std::uint32_t b) {
+      return getOctant(a) < getOctant(b);
+    });
+
+    std::size_t begin = current.begin;
+    if (getOctant(spacingEntries[begin]) == -1) {
+      drawList.entries[spacingEntries[begin]].spacingIndex = static_cast<std::uint32_t>(idx);
+      spacingTree[idx].y = glm::floatBitsToUint(node.getSpacing());
+      begin++;
+    }
+    unsigned int childMask = 0;
+    const auto firstChild = static_cast<std::uint32_t>(spacingTree.size());
+    while (begin < current.end) {
+      const int octant = getOctant(spacingEntries[begin]);
+      std::size_t end = begin + 1;
+      while (end < current.end && getOctant(spacingEntries[end]) == octant) end++;
+      childMask |= 1u << octant;
+      spacingQueue.push_back({node.children[octant], begin, end});
+      spacingTree.emplace_back(0);
+      begin = end;
+    }
+    spacingTree[idx].x = childMask | (firstChild << 8);
+  }
+}
+
+template <typename Schema>
+void LODSelector<Schema>::collect(const Node& node, std::uint64_t viewMask, std::uint32_t tree,
+                                  bool isHeadless) {
+  const glm::vec4 center(node.bbox.getCenter(), 1);
+  const float radius = node.bbox.getBoundingSphereRadius();
+  const bool isCandidate = (node.depth != 0 || (areRootsRanked && node.isBuffered)) &&
+                           !node.isFilteredOut(displayFilter);
+
+  // a node's children lie inside its bounding sphere, so they are only
+  // visible in the views it is visible in
+  std::uint64_t visibleMask = 0;
+  for (std::size_t i = 0; i < viewScales.size(); i++) {
+    const std::uint64_t bit = std::uint64_t(1) << i;
+    if (!(viewMask & bit)) continue;
+
+    // get the position of the node with the model-view matrix applied to
+    // sync its CPU position with its GPU position
+    const Viewpoint& current = (*activeViewpoints)[i];
+    const glm::vec3 viewPosition = current.modelViewMat * center;
+    const float viewRadius = radius * viewScales[i];
+    if (!current.view.isSphereVisible(viewPosition, viewRadius)) continue;
+    visibleMask |= bit;
+
+    const float screenSize =
+        current.view.getScreenProjectedSize(viewRadius, glm::length(viewPosition));
+    if (isCandidate && screenSize > minScreenSize) {
+      candidates[i].push_back({&node, screenSize, tree});
+    }
+  }
+  if (visibleMask == 0) return;
+
+  for (int i = 0; i < 8; i++) {
+    if (node.isChildActive(i) && (isHeadless || node.children[i]->isBuffered)) {
+      collect(*node.children[i], visibleMask, tree, isHeadless);
+    }
+  }
+}
+
+#define INSTANTIATE_LOD_SELECTOR(...) template class LODSelector<PointSchema<__VA_ARGS__>>;
+POINT_SCHEMAS(INSTANTIATE_LOD_SELECTOR)
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <occlusion-culler/occlusion-culler.h>
+#include <octree/octree-node.h>
+#include <scene/scene.h>
+#include <view/view.h>
+
+// The settings and statistics shared by selectors of every schema.
+class LODSelectorBase {
+ public:
+  // nodes whose bounding spheres project to this many pixels or fewer are
+  // not drawn
+  static constexpr float defaultMinScreenSize = 1.f;
+  // nodes whose voxels occlusion culling draws, at most
+  static constexpr std::size_t maxOccluderNodes = 32;
+  // Levels below the root a node must be at for occlusion culling to draw
+  // its voxels: the top levels' voxels span large parts of the scene, and
+  // their points are drawn smaller once finer nodes are drawn over them, so
+  // they cover less than they did at their own spacing.
+  static constexpr unsigned int minOccluderDepth = 2;
+
+  // what the last selection picked
+  struct Selection {
+    std::uint64_t points = 0;
+    std::uint64_t nodes = 0;       // draw calls
+    std::uint64_t candidates = 0;  // nodes large enough on screen, sorted by size
+    // on-screen size, in pixels, of the largest node left undrawn by the
+    // budget; at most minScreenSize when every candidate was drawn
+    float frontier = 0.f;
+    // candidates dropped by occlusion culling, before the budget
+    std::uint64_t occluded = 0;
+  };
+
+  // one of the views of a multi-view selection, with its own budget
+  struct Viewpoint {
+    View view;
+    glm::mat4 modelViewMat = glm::mat4(1.f);
+    std::uint64_t pointBudget = 0;
+  };
+
+  // views one traversal can select for, one bit each in its visibility mask
+  static constexpr std::size_t maxViewpoints = 64;
+};
+
+// Picks the nodes of an octree to draw from a viewpoint: those in its view
+// frustum whose bounding spheres project to more than minScreenSize pixels,
+// largest first, until the point budget runs out. Several viewpoints, e.g. a
+// stereo pair or the faces of a cube map, can share one traversal, which
+// projects each node into every view it may be visible in and skips subtrees
+// outside all of them.
+//
+// With occlusion culling on, the largest candidates the budget lets through,
+// below the top levels, are drawn into an OcclusionCuller's coarse depth
+// buffer as the voxels their points cover, which are taken as solid, and the
+// other candidates hidden behind them are dropped before they take any
+// budget. Covered voxels are solid enough from most angles, but not all, so
+// the cull is approximate and off by default. Each selector has its own
+// settings, scratch space and statistics and only reads the tree, so several
+// can select from one tree at once, e.g. one per viewport or render job,
+// while nothing inserts into or uploads it.
+template <typename Schema>
+class LODSelector : public LODSelectorBase {
+ public:
+  using Node = OctreeNode<Schema>;
+  using DrawList = typename Node::DrawList;
+
+  explicit LODSelector(std::uint64_t pointBudget, float minScreenSize = defaultMinScreenSize);
+
+  std::uint64_t getPointBudget() const;
+  void setPointBudget(std::uint64_t pointBudget);
+  float getMinScreenSize() const;
+  void setMinScreenSize(float minScreenSize);
+  const OctreeNodeBase::DisplayFilter& getDisplayFilter() const;
+  void setDisplayFilter(const OctreeNodeBase::DisplayFilter& displayFilter);
+  bool getOcclusionCulling() const;
+  void setOcclusionCulling(bool occlusionCulling);
+
+  // Picks the uploaded nodes of `root`'s tree to draw. The view is taken per
+  // call, so a resized window applies from the next selection. Makes no GL
+  // calls, so it can run on any thread holding the lock that guards the
+  // tree's uploads and inserts.
+  void buildDrawList(const Node& root, const View& view, const glm::mat4& modelViewMat,
+                     DrawList& drawList);
+  // As buildDrawList(), for up to maxViewpoints views in one traversal. Each
+  // view gets its own list, within its own budget; the selector's budget is
+  // not used.
+  void buildDrawLists(const Node& root, const std::vector<Viewpoint>& viewpoints,
+                      std::vector<DrawList>& drawLists);
+  // Picks from every tree of `scene`, placed by `modelViewMat`, in one order
+  // within the selector's budget, filling one list per tree. With more than
+  // one tree, roots are ranked like the other nodes instead of always drawn.
+  void buildDrawLists(const Scene<Schema>& scene, const View& view,
+                      const glm::mat4& modelViewMat, std::vector<DrawList>& drawLists);
+  // Picks the nodes buildDrawList() would without the tree being uploaded.
+  // Nodes that were not are counted by their build data, and occlusion
+  // culling draws them by the masks OctreeNode::updateOccupancy() last set.
+  const Selection& select(const Node& root, const View& view, const glm::mat4& modelViewMat);
+  const std::vector<Selection>& select(const Node& root,
+                                       const std::vector<Viewpoint>& viewpoints);
+  // of the last selection's first view
+  const Selection& getSelection() const;
+  // of each view of the last selection
+  const std::vector<Selection>& getSelections() const;
+
+ private:
+  struct Candidate {
+    const Node* node;
+    float screenSize;    // pixels
+    std::uint32_t tree;  // of a scene
+  };
+
+  // picks into `drawLists`, one per viewpoint, if given; unless
+  // `isHeadless`, only uploaded nodes
+  void pick(const Node& root, const std::vector<Viewpoint>& viewpoints, bool isHeadless,
+            DrawList* drawLists);
+  // Gathers the nodes large enough on screen below and including `node` for
+  // each view in `viewMask`, the views `node`'s parent was visible in.
+  void collect(const Node& node, std::uint64_t viewMask, std::uint32_t tree, bool isHeadless);
+  // Drops the candidates of `viewCandidates`, sorted, that are hidden
+  // behind the occluders picked from the first of them, keeping their
+  // order. Candidates are placed by treeModelViews.
+  void cullOccluded(const View& view, std::uint64_t pointBudget,
+                    std::vector<Candidate>& viewCandidates, Selection& selection);
+  // adds the voxels of `node`, from the scene's `tree`, to the culler
+  void addOccluders(const Node& node, std::uint32_t tree);
+  // Resets the scratch space for `viewpoints`, which collect() reads until
+  // the next reset, and returns the mask of them all.
+  std::uint64_t reset(const std::vector<Viewpoint>& viewpoints);
+  // Lists the picked nodes of `drawList`, from `root`'s tree, and their
+  // ancestors in its spacing tree, and points each entry at its node there.
+  void buildSpacingTree(const Node& root, DrawList& drawList);
+  // the single viewpoint of buildDrawList() and select()
+  const std::vector<Viewpoint>& getViewpoint(const View& view, const glm::mat4& modelViewMat);
+
+  std::uint64_t pointBudget;
+  float minScreenSize;
+  OctreeNodeBase::DisplayFilter displayFilter;
+  bool occlusionCulling = false;
+  // kept between selections so their memory is reused
+  std::vector<Viewpoint> viewpoint;
+  std::vector<std::vector<Candidate>> candidates;  // per viewpoint
+  std::vector<Selection> selections;
+  // the viewpoints being picked for, and the scale of each one's model-view
+  // matrix, which node radii are multiplied by to match view-space distances
+  const std::vector<Viewpoint>* activeViewpoints = nullptr;
+  std::vector<float> viewScales;
+  bool areRootsRanked = false;
+  // buildSpacingTree()'s queue: each listed node with the range of
+  // spacingEntries, the entries at or below it
+  struct SpacingNode {
+    const Node* node;
+    std::size_t begin;
+    std::size_t end;
+  };
+  std::vector<SpacingNode> spacingQueue;
+  std::vector<std::uint32_t> spacingEntries;
+  // cullOccluded()'s model-view matrix of each tree, and the spheres of the
+  // candidates it tests
+  OcclusionCuller occlusionCuller;
+  std::vector<glm::mat4> treeModelViews;
+  std::vector<OcclusionCuller::Sphere> occlusionSpheres;
+  std::vector<unsigned char> occlusionHidden;
+};
@@ -0,0 +1,75 @@
+#include <limits>
+
+#include <lod-worker/lod-worker.h>
+
+template <typename Schema>
+LODWorker<Schema>::LODWorker(const Scene<Schema>& scene, std::mutex& octreeMutex,
+                             std::uint64_t pointBudget, float minScreenSize)
+    : scene(scene),
+      octreeMutex(octreeMutex),
+      pointBudget(pointBudget),
+      selector(pointBudget, minScreenSize),
+      stopping(false) {
+  worker = std::thread(&LODWorker::run, this);
+}
+
+template <typename Schema>
+LODWorker<Schema>::~LODWorker() {
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    stopping = true;
+  }
+  wake.notify_one();
+  worker.join();
+}
+
+template <typename Schema>
+void LODWorker<Schema>::post(const Request& request) {
+  mailbox.getBack() = request;
+  mailbox.publish();
+  {
+    // orders the wakeup after the worker's check for a posted view
+    std::lock_guard<std::mutex> lock(wakeMutex);
+  }
+  wake.notify_one();
+}
+
+template <typename Schema>
+const std::vector<typename LODWorker<Schema>::DrawList>& LODWorker<Schema>::getDrawLists() {
+  selected.take();
+  return selected.getFront().drawLists;
+}
+
+template <typename Schema>
+const typename LODWorker<Schema>::Request& LODWorker<Schema>::getDrawListsRequest() {
+  return selected.getFront().request;
+}
+
+template <typename Schema>
+void LODWorker<Schema>::run() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(wakeMutex);
+      wake.wait(lock, [this]() { return stopping || mailbox.hasFresh(); });
+      if (stopping) return;
+    }
+    mailbox.take();
+
+    const Request& request = mailbox.getFront();
+    selector.setDisplayFilter(request.displayFilter);
+    selector.setOcclusionCulling(request.isOcclusionCulled);
+    selector.setPointBudget(request.isRefining ? std::numeric_limits<std::uint64_t>::max()
+                                              : pointBudget);
+    // the back lists are the worker's own until published
+    Selected& back = selected.getBack();
+    back.request = request;
+    {
+      std::lock_guard<std::mutex> lock(octreeMutex);
+      selector.buildDrawLists(scene, request.view, request.modelViewMat, back.drawLists);
+    }
+    selected.publish();
+  }
+}
+
+#define INSTANTIATE_LOD_WORKER(...) template class LODWorker<PointSchema<__VA_ARGS__>>;
+POINT_SCHEMAS(INSTANTIATE_LOD_WORKER)
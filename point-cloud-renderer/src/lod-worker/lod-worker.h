@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <lod-selector/lod-selector.h>
+#include <octree/octree-node.h>
+#include <parallel/parallel.h>
+#include <scene/scene.h>
+#include <view/view.h>
+
+// Runs an LODSelector over a scene on its own thread, so the tree walks and
+// sort stay off the render thread, which only submits the finished lists.
+// The render thread posts the latest view into a lock-free mailbox each
+// frame it changes; the worker selects for the newest one it finds and
+// publishes a draw list per tree into a triple buffer, which the render
+// thread reads without waiting. Lists may be a frame behind the camera.
+template <typename Schema>
+class LODWorker {
+ public:
+  using DrawList = typename OctreeNode<Schema>::DrawList;
+
+  // what to select for, all of it posted with every change
+  struct Request {
+    View view;
+    glm::mat4 modelViewMat = glm::mat4(1.f);  // of the scene
+    OctreeNodeBase::DisplayFilter displayFilter;
+    // select every node in view above the minimum screen size, ignoring
+    // the point budget, to refine an idle view with
+    bool isRefining = false;
+    // drop the nodes hidden behind nearer ones, see LODSelector
+    bool isOcclusionCulled = false;
+    // counted up by the render thread, to tell which request the lists it
+    // reads were selected for
+    std::uint64_t serial = 0;
+  };
+
+  // `octreeMutex` guards the scene's trees against inserts and uploads; the
+  // worker holds it while selecting. Both must outlive the worker.
+  LODWorker(const Scene<Schema>& scene, std::mutex& octreeMutex,
+            std::uint64_t pointBudget, float minScreenSize);
+  ~LODWorker();
+
+  LODWorker(const LODWorker&) = delete;
+  LODWorker& operator=(const LODWorker&) = delete;
+
+  // render thread: what to select for next, replacing any request not yet taken
+  void post(const Request& request);
+  // render thread: the newest finished lists, one per tree, none before the
+  // first
+  const std::vector<DrawList>& getDrawLists();
+  // render thread: the request the lists getDrawLists() returned were
+  // selected for
+  const Request& getDrawListsRequest();
+
+ private:
+  struct Selected {
+    Request request;
+    std::vector<DrawList> drawLists;
+  };
+
+  void run();
+
+  const Scene<Schema>& scene;
+  std::mutex& octreeMutex;
+  const std::uint64_t pointBudget;
+  LODSelector<Schema> selector;  // only used by the worker thread
+  parallel::TripleBuffer<Request> mailbox;
+  parallel::TripleBuffer<Selected> selected;
+  std::atomic<bool> stopping;
+  // only used to sleep while no view is posted, not to pass data
+  std::mutex wakeMutex;
+  std::condition_variable wake;
+  std::thread worker;
+};
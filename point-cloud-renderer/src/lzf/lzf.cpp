@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cstring>
+
+#include <lzf/lzf.h>
+
+namespace lzf {
+
+  std::size_t decompress(const unsigned char* in, std::size_t inLen,
+                         unsigned char* out, std::size_t outLen) {
+    const unsigned char* ip = in;
+    const unsigned char* const inEnd = in + inLen;
+    unsigned char* op = out;
+    unsigned char* const outEnd = out + outLen;
+
+    while (ip < inEnd) {
+      unsigned int ctrl = *ip++;
+
+      if (ctrl < (1 << 5)) {
+        // literal run of ctrl + 1 bytes
+        std::size_t len = ctrl + 1;
+        if (op + len > outEnd || ip + len > inEnd) return 0;
+        std::memcpy(op, ip, len);
+        op += len;
+        ip += len;
+        continue;
+      }
+
+      // back reference: 3 bits of length (7 = extended), 13 bits of offset
+      std::size_t len = ctrl >> 5;
+      if (len == 7) {
+        if (ip >= inEnd) return 0;
+        len += *ip++;
+      }
+      len += 2;
+
+      if (ip >= inEnd) return 0;
+      std::size_t offset = ((ctrl & 0x1f) << 8) + *ip++ + 1;
+      if (offset > static_cast<std::size_t>(op - out)) return 0;
+      if (op + len > outEnd) return 0;
+
+      // the source may overlap the destination (run-length style references),
+      // so copy byte by byte.
+      const unsigned char* ref = op - offset;
+      for (std::size_t i = 0; i < len; i++) {
+        *op++ = *ref++;
+      }
+    }
+
+    return static_cast<std::size_t>(op - out);
+  }
+
+  namespace {
+    constexpr std::size_t maxOffset = 1 << 13;     // furthest a back reference reaches
+    constexpr std::size_t maxTokenLen = 1 + 32;    // longest literal run with its control byte
+    constexpr std::size_t chunkSize = 64 * 1024;   // bytes read or decoded at a time
+  }
+
+  StreamDecoder::StreamDecoder(std::istream& in, std::size_t inLen)
+      : in(in), inRemaining(inLen), inputPos(0), outputPos(0) {}
+
+  bool StreamDecoder::read(unsigned char* out, std::size_t len) {
+    while (len > 0) {
+      if (outputPos == output.size() && !decodeMore()) return false;
+
+      const std::size_t n = std::min(len, output.size() - outputPos);
+      if (out) {
+        std::memcpy(out, output.data() + outputPos, n);
+        out += n;
+      }
+      outputPos += n;
+      len -= n;
+    }
+    return true;
+  }
+
+  bool StreamDecoder::fillInput(std::size_t minBytes) {
+    if (input.size() - inputPos >= minBytes || inRemaining == 0) return true;
+
+    input.erase(input.begin(), input.begin() + inputPos);
+    inputPos = 0;
+    const std::size_t kept = input.size();
+    const std::size_t n = std::min(inRemaining, chunkSize);
+    input.resize(kept + n);
+    in.read(reinterpret_cast<char*>(input.data() + kept), n);
+    if (static_cast<std::size_t>(in.gcount()) != n) return false;
+    inRemaining -= n;
+    return true;
+  }
+
+  bool StreamDecoder::decodeMore() {
+    // drop delivered output that no back reference can reach any more
+    if (outputPos > maxOffset) {
+      output.erase(output.begin(), output.begin() + (outputPos - maxOffset));
+      outputPos = maxOffset;
+    }
+
+    const std::size_t target = output.size() + chunkSize;
+    while (output.size() < target) {
+      if (!fillInput(maxTokenLen)) return false;
+      if (inputPos == input.size()) break;
+
+      const unsigned char* ip = input.data() + inputPos;
+      const unsigned char* const inEnd = input.data() + input.size();
+      unsigned int ctrl = *ip++;
+
+      if (ctrl < (1 << 5)) {
+        // literal run of ctrl + 1 bytes
+        std::size_t len = ctrl + 1;
+        if (ip + len > inEnd) return false;
+        output.insert(output.end(), ip, ip + len);
+        inputPos = ip + len - input.data();
+        continue;
+      }
+
+      // back reference: 3 bits of length (7 = extended), 13 bits of offset
+      std::size_t len = ctrl >> 5;
+      if (len == 7) {
+        if (ip >= inEnd) return false;
+        len += *ip++;
+      }
+      len += 2;
+
+      if (ip >= inEnd) return false;
+      std::size_t offset = ((ctrl & 0x1f) << 8) + *ip++ + 1;
+      inputPos = ip - input.data();
+      if (offset > output.size()) return false;
+
+      // the source may overlap the destination, so copy byte by byte
+      std::size_t ref = output.size() - offset;
+      for (std::size_t i = 0; i < len; i++) {
+        output.push_back(output[ref + i]);
+      }
+    }
+
+    return outputPos < output.size();
+  }
+
+}  // namespace lzf
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <vector>
+
+namespace lzf {
+  // Decompresses a raw LZF stream (no block headers, as written by liblzf's
+  // lzf_compress and by PCL for binary_compressed PCD files).
+  // Returns the number of bytes written to `out`, or 0 if the stream is
+  // malformed or would not fit in `outLen` bytes.
+  std::size_t decompress(const unsigned char* in, std::size_t inLen,
+                         unsigned char* out, std::size_t outLen);
+
+  // Decompresses a raw LZF stream piecewise as it is read from `in`. Only the
+  // output a back reference can still reach (8 KiB) is kept between calls, so
+  // memory use does not grow with the stream.
+  class StreamDecoder {
+   public:
+    // `in` must be positioned at the start of the `inLen` compressed bytes and
+    // outlive the decoder.
+    StreamDecoder(std::istream& in, std::size_t inLen);
+
+    // Writes the next `len` decompressed bytes to `out`, or discards them if
+    // `out` is nullptr. Returns false if the stream is malformed or ends first.
+    bool read(unsigned char* out, std::size_t len);
+
+   private:
+    bool fillInput(std::size_t minBytes);
+    bool decodeMore();
+
+    std::istream& in;
+    std::size_t inRemaining;  // compressed bytes not yet read from `in`
+    std::vector<unsigned char> input;
+    std::size_t inputPos;
+    std::vector<unsigned char> output;  // the back reference window, then undelivered bytes
+    std::size_t outputPos;              // first undelivered byte of `output`
+  };
+}
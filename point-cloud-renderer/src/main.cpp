@@ -1,9 +1,15 @@
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include <SDL2/SDL.h>
 #include <glad/gl.h>
@@ -11,11 +17,24 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <accumulation-target/accumulation-target.h>
+#include <build-pipeline/build-pipeline.h>
+#include <build-tuner/build-tuner.h>
 #include <camera/camera.h>
+#include <colour-map/colour-map.h>
+#include <hole-filler/hole-filler.h>
+#include <lod-selector/lod-selector.h>
+#include <lod-worker/lod-worker.h>
 #include <mouse/mouse.h>
 #include <octree/octree-node.h>
 #include <point-cloud/point-cloud.h>
+#include <point-schema/point-schema.h>
+#include <resource-usage/resource-usage.h>
+#include <scene/scene.h>
 #include <shader-compiler/shader-compiler.h>
+#include <spacing-texture/spacing-texture.h>
+#include <tile-index/tile-index.h>
+#include <tile-loader/tile-loader.h>
 #include <timer/timer.h>
 #include <view/view.h>
 
@@ -24,44 +43,673 @@ static constexpr int glMinorVersion = 1;
 static constexpr int defaultWinWidth = 1280;
 static constexpr int defaultWinHeight = 720;
 static constexpr unsigned int defaultMinPointsPerNode = 10000;
+static constexpr std::uint64_t uploadBudgetPerFrame = 1 << 20;  // pipelined build
+static constexpr unsigned int maxResolution = 1024;  // keeps 1025^3 cell hashes in an int
+static constexpr std::size_t tuningResultsShown = 5;
 static constexpr int fpsLimit = 240;
 static constexpr float fpsLimitMS = 1000.f / fpsLimit;
+// how long a fully refined view waits for input before checking for changes,
+// e.g. tiles that finished loading
+static constexpr int idleWaitMS = 50;
 static constexpr const char* vertexShaderPath = "./shaders/vertex.glsl";
 static constexpr const char* pcFragShaderPath = "./shaders/pc-frag.glsl";
+static constexpr const char* bboxVertexShaderPath = "./shaders/bbox-vertex.glsl";
 static constexpr const char* bboxFragShaderPath = "./shaders/bbox-frag.glsl";
+// the vertex shader of the full-screen passes
+static constexpr const char* fullscreenVertexShaderPath = "./shaders/fullscreen-vertex.glsl";
+static constexpr const char* accumulationFragShaderPath = "./shaders/accumulation-frag.glsl";
+static constexpr const char* holeFillFragShaderPath = "./shaders/hole-fill-frag.glsl";
 
-int main(int argc, char** argv) {
-  // --- initialisation ---
-  if (argc < 3 || argc > 5) {
-    std::cerr
-        << "Usage:\n"
-        << "  PointCloudRenderer <FILE> <POINTS PER FRAME BUDGET> "
-           "[POINT BUFFER BUDGET] [MIN POINTS PER NODE]\n\n"
-
-        << "Arguments:\n"
-        << "  FILE\n"
-        << "      Path to the input point cloud file.\n\n"
-
-        << "  POINTS PER FRAME BUDGET\n"
-        << "      Maximum number of points to render per frame.\n\n"
-
-        << "  POINT BUFFER BUDGET (optional)\n"
-        << "      Maximum number of points that can be loaded into memory.\n"
-        << "      If not specified, no limit is applied.\n\n"
-
-        << "  MIN POINTS PER NODE (optional)\n"
-        << "      Minimum number of points per octree node.\n"
-        << "      Defaults to " << defaultMinPointsPerNode << ".\n"
-        << std::endl;
-    return EXIT_FAILURE;
+// Options for building and viewing the octree; LoadOptions holds the rest.
+struct ViewerOptions {
+  OctreeNodeBase::Sampling lodSampling = OctreeNodeBase::Sampling::First;
+  bool pipelinedBuild = false;
+  // file inserted into the drawn octree once it is built, see BuildPipeline
+  std::string liveFeed;
+  std::uint64_t liveRate = 0;  // points per second, 0 for as fast as possible
+  // node size band for the rebalancing pass, which is skipped when unset
+  std::optional<glm::uvec2> nodeSize;
+  unsigned int resolution = OctreeNodeBase::defaultResolution;
+  float minScreenSize = LODSelectorBase::defaultMinScreenSize;
+  // run the BuildTuner first, then exit or, with applyTuning, use its pick
+  bool tune = false;
+  bool applyTuning = false;
+  // time node selection with and without occlusion culling, then exit
+  bool benchmarkOcclusion = false;
+  // toggled with O while viewing
+  bool occlusionCulling = false;
+  // toggled with V while viewing
+  OctreeNodeBase::DisplayFilter displayFilter;
+  // screen-space hole filling, toggled with H while viewing
+  bool fillHoles = false;
+  unsigned int fillPasses = HoleFiller::defaultPasses;
+};
+
+// how far an idle view has been refined past the point budget
+enum class Refinement {
+  Off,       // the view changed, so each frame draws the budgeted lists
+  Refining,  // each frame adds about a budget of points to the accumulated view
+  Done,      // every selected node is drawn, so nothing is redrawn
+};
+
+static void printUsage() {
+  std::cerr
+      << "Usage:\n"
+      << "  PointCloudRenderer [OPTIONS] <FILE> <POINTS PER FRAME BUDGET> "
+         "[POINT BUFFER BUDGET] [MIN POINTS PER NODE]\n\n"
+
+      << "Arguments:\n"
+      << "  FILE\n"
+      << "      Path to the input point cloud file (.ply or .pcd), or several\n"
+      << "      separated by commas, e.g. the tiles of one site. Each file gets its\n"
+      << "      own octree, drawn together as one scene within the budgets, of\n"
+      << "      which each file is given a share by its number of points.\n"
+      << "      Or a directory of .ply and .pcd tiles, or a manifest (.txt) listing\n"
+      << "      them, each line a path optionally followed by MINX MINY MINZ MAXX MAXY\n"
+      << "      MAXZ. Headers and bounds are read up front, and each tile is loaded\n"
+      << "      in the background once it is first in view.\n\n"
+
+      << "  POINTS PER FRAME BUDGET\n"
+      << "      Maximum number of points to render per frame.\n\n"
+
+      << "  POINT BUFFER BUDGET (optional)\n"
+      << "      Maximum number of points that can be loaded into memory.\n"
+      << "      If not specified, no limit is applied.\n\n"
+
+      << "  MIN POINTS PER NODE (optional)\n"
+      << "      Minimum number of points per octree node.\n"
+      << "      Defaults to " << defaultMinPointsPerNode << ".\n\n"
+
+      << "Options:\n"
+      << "  --sampling=<first|stride|reservoir|voxel>\n"
+      << "      How the point buffer budget picks points from larger files.\n"
+      << "      Defaults to voxel (spatially uniform).\n\n"
+
+      << "  --lod-sampling=<first|center|average|random>\n"
+      << "      How each octree grid cell picks the point drawn at its level.\n"
+      << "      Defaults to first (file order); the others build the same octree\n"
+      << "      whatever the order, taking points at one position as copies.\n\n"
+
+      << "  --seed=<N>\n"
+      << "      Seed for the reservoir, stride and voxel sampling modes and the\n"
+      << "      random LOD sampling policy.\n"
+      << "      Defaults to " << PointSampler::defaultSeed << ".\n\n"
+
+      << "  --crop-box=<MINX,MINY,MINZ,MAXX,MAXY,MAXZ>\n"
+      << "      Only load points inside the axis-aligned box.\n\n"
+
+      << "  --crop-polygon=<X,Y,X,Y,...>\n"
+      << "      Only load points inside the polygon (3+ vertices on the xy plane).\n\n"
+
+      << "  --crop-z=<MIN,MAX>\n"
+      << "      Height range the crop polygon is extruded over. Defaults to unbounded.\n\n"
+
+      << "  --intensity=<MIN,MAX>\n"
+      << "      Only load points with an intensity in the range.\n\n"
+
+      << "  --classification=<MIN,MAX>\n"
+      << "      Only load points with a classification (label) in the range.\n\n"
+
+      << "  --every-nth=<N>\n"
+      << "      Only load every Nth point of the file.\n\n"
+
+      << "  --attributes=<LIST>\n"
+      << "      Comma separated point attributes to load and draw besides the position:\n"
+      << "      rgb, intensity, classification and normal, or none. Defaults to rgb.\n\n"
+
+      << "  --streaming-build\n"
+      << "      Insert points into the octree as they are read instead of loading\n"
+      << "      the whole cloud first. Reads the file twice but lowers peak memory.\n\n"
+
+      << "  --pipelined-build\n"
+      << "      Streaming build that reads, builds and uploads concurrently, drawing\n"
+      << "      the coarse levels while the rest of the file loads.\n\n"
+
+      << "  --live-feed=<FILE>\n"
+      << "      Once the octree is drawn, insert the points of FILE into it as they\n"
+      << "      are read, uploading only the nodes they change. Points outside the\n"
+      << "      octree's bounds are dropped.\n\n"
+
+      << "  --live-rate=<POINTS PER SECOND>\n"
+      << "      Paces the live feed, e.g. to replay a scan at its scanner's rate.\n\n"
+
+      << "  --node-size=<MIN,MAX>\n"
+      << "      Rebalance the built octree so nodes hold MIN to MAX points, splitting\n"
+      << "      larger nodes and collapsing sparse leaves into their parent.\n"
+      << "      Not available with --pipelined-build.\n\n"
+
+      << "  --grid-resolution=<N>\n"
+      << "      Grid cells along each octree node's diagonal, which bounds its points.\n"
+      << "      Defaults to " << OctreeNodeBase::defaultResolution << ", at most " << maxResolution
+      << ".\n\n"
+
+      << "  --min-screen-size=<PIXELS>\n"
+      << "      Nodes smaller than this on screen are not drawn.\n"
+      << "      Defaults to " << LODSelectorBase::defaultMinScreenSize << ".\n\n"
+
+      << "  --show-intensity=<MIN,MAX> and --show-classification=<MIN,MAX>\n"
+      << "      Only draw points with an intensity or classification in the range,\n"
+      << "      skipping nodes with none. Unlike --intensity and --classification,\n"
+      << "      the other points stay loaded and the filter can be toggled.\n\n"
+
+      << "  --fill-holes[=PASSES]\n"
+      << "      Fill the gaps between drawn points with PASSES full-screen passes,\n"
+      << "      1 to " << HoleFiller::maxPasses << ", so a lower budget still looks complete.\n"
+      << "      Defaults to " << HoleFiller::defaultPasses << ".\n\n"
+
+      << "  --occlusion-culling\n"
+      << "      Skip nodes hidden behind nearer ones, found on the CPU, before they\n"
+      << "      take any of the budget. Approximate, as points are not solid.\n\n"
+
+      << "  --benchmark-occlusion\n"
+      << "      Time node selection along a camera path with and without occlusion\n"
+      << "      culling, headless, view by view and in shared traversals, print what\n"
+      << "      each picked and exit. Fails if the two ways pick differently.\n\n"
+
+      << "  --tune[=apply]\n"
+      << "      Build octrees from a subsample of the file over a grid of node sizes,\n"
+      << "      grid resolutions and screen sizes, print the best settings and exit.\n"
+      << "      With =apply, view the file with the best settings instead.\n"
+      << std::endl;
+}
+
+// Applies `filter` to the points shader; an unset range passes every value.
+// Node selection gets it with each view posted to the LOD worker.
+static void applyDisplayFilter(unsigned int shaderProg,
+                               const OctreeNodeBase::DisplayFilter& filter) {
+  const glm::vec2 all(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::max());
+  glUseProgram(shaderProg);
+  glUniform2fv(glGetUniformLocation(shaderProg, "intensityFilter"), 1,
+               glm::value_ptr(filter.intensity.value_or(all)));
+  glUniform2fv(glGetUniformLocation(shaderProg, "classificationFilter"), 1,
+               glm::value_ptr(filter.classification.value_or(all)));
+}
+
+// Splits the point buffer budget between files by the points their headers
+// hold, as tiles of one site are sampled at one density.
+static std::vector<std::optional<std::uint64_t>> sharePointLimit(
+    const std::vector<std::string>& filepaths, std::optional<std::uint64_t> pointLimit) {
+  if (!pointLimit || filepaths.size() == 1) return {pointLimit};
+
+  std::vector<std::uint64_t> filePoints;
+  double totalPoints = 0.0;
+  for (const std::string& filepath : filepaths) {
+    filePoints.push_back(PointCloud::getFilePoints(filepath));
+    totalPoints += filePoints.back();
   }
+  std::vector<std::optional<std::uint64_t>> limits;
+  for (std::uint64_t points : filePoints) {
+    const double share = totalPoints > 0.0 ? points / totalPoints : 0.0;
+    limits.push_back(std::max<std::uint64_t>(1, static_cast<std::uint64_t>(*pointLimit * share)));
+  }
+  return limits;
+}
 
-  const std::string filepath = argv[1];
-  const unsigned int frameBudget = std::stoul(argv[2]);
-  const std::optional<unsigned int> bufferBudget =
-      argc >= 4 ? std::optional<unsigned int>(std::stoul(argv[3])) : std::nullopt;
-  const unsigned int minPointsPerNode =
-      argc == 5 ? std::stoul(argv[4]) : defaultMinPointsPerNode;
+// the ranges the points shader normalises heights and intensities over
+struct SceneShading {
+  glm::vec2 zRange;
+  glm::vec2 intensityRange;
+  bool isColourUniform;  // see PointCloud::hasUniformColour()
+};
+
+// Frames the first cloud's view on the bounds of every cloud, which share one
+// coordinate system, and returns the shading ranges over them all.
+static SceneShading frameScene(std::vector<PointCloud>& clouds) {
+  PointCloud& first = clouds.front();
+  SceneShading shading = {first.getZRange(), first.getIntensityRange(),
+                          first.hasUniformColour()};
+  if (clouds.size() == 1) return shading;
+
+  glm::vec3 min = first.getBoundingBox().getMin();
+  glm::vec3 max = first.getBoundingBox().getMax();
+  for (std::size_t i = 1; i < clouds.size(); i++) {
+    const PointCloud& cloud = clouds[i];
+    min = glm::min(min, cloud.getBoundingBox().getMin());
+    max = glm::max(max, cloud.getBoundingBox().getMax());
+    shading.zRange = glm::vec2(std::min(shading.zRange.x, cloud.getZRange().x),
+                               std::max(shading.zRange.y, cloud.getZRange().y));
+    shading.intensityRange =
+        glm::vec2(std::min(shading.intensityRange.x, cloud.getIntensityRange().x),
+                  std::max(shading.intensityRange.y, cloud.getIntensityRange().y));
+    shading.isColourUniform = shading.isColourUniform && cloud.hasUniformColour();
+  }
+  first.frame(min, max);
+  return shading;
+}
+
+// Prints a startup duration in seconds, e.g. "LOAD TIME: 1.25s".
+static void printTime(const char* label, float ms) {
+  const auto defaultPrecision = std::cout.precision();
+  std::cout << std::fixed << std::setprecision(2) << label << ": " << ms / 1000.f
+            << "s" << std::endl;
+  std::cout.unsetf(std::ios::fixed);
+  std::cout.precision(defaultPrecision);
+}
+
+// Prints the scene's size, the points that hit its build limits and the peak
+// memory use once it is built.
+template <typename Schema>
+static void printBuildStats(const Scene<Schema>& scene) {
+  const auto defaultPrecision = std::cout.precision();
+  if (scene.getNumTrees() > 1) std::cout << "OCTREES: " << scene.getNumTrees() << '\n';
+  std::cout << "TOTAL NODES: " << scene.getNodeCount() << '\n'
+            << "MAX DEPTH: " << scene.getMaxDepth() << '\n';
+  const OctreeNodeBase::BuildStats buildStats = OctreeNodeBase::getBuildStats();
+  if (buildStats.duplicatePoints > 0) {
+    std::cout << "DUPLICATE POINTS DROPPED: " << buildStats.duplicatePoints << '\n';
+  }
+  if (buildStats.depthLimitedPoints > 0 || buildStats.extentLimitedPoints > 0) {
+    std::cout << "POINTS KEPT IN LIMITED LEAVES: " << buildStats.depthLimitedPoints
+              << " (depth), " << buildStats.extentLimitedPoints << " (extent)\n";
+  }
+  std::cout << std::fixed << std::setprecision(2)
+            << "PEAK MEMORY: " << resources::getPeakRSS() / (1024.f * 1024.f)
+            << "MB" << std::endl;
+  std::cout.unsetf(std::ios::fixed);
+  std::cout.precision(defaultPrecision);
+}
+
+// Adds a histogram from OctreeNode::getSizeHistogram() to `total`.
+static void addHistogram(std::vector<std::uint64_t>& total,
+                         const std::vector<std::uint64_t>& histogram) {
+  if (total.size() < histogram.size()) total.resize(histogram.size(), 0);
+  for (std::size_t bucket = 0; bucket < histogram.size(); bucket++) {
+    total[bucket] += histogram[bucket];
+  }
+}
+
+// Prints a node size histogram, see OctreeNode::getSizeHistogram(), and how
+// many draw calls drawing every node would take.
+static void printNodeSizes(const char* label, const std::vector<std::uint64_t>& histogram) {
+  std::uint64_t drawCalls = 0;
+  std::cout << label << ":\n";
+  for (std::size_t bucket = 0; bucket < histogram.size(); bucket++) {
+    if (histogram[bucket] == 0) continue;
+    const std::uint64_t low = bucket == 0 ? 0 : std::uint64_t(1) << bucket;
+    std::cout << "  - " << low << " to " << (std::uint64_t(2) << bucket) - 1
+              << " points: " << histogram[bucket] << " nodes\n";
+    drawCalls += histogram[bucket];
+  }
+  std::cout << "  - " << drawCalls << " draw calls with every node drawn" << std::endl;
+}
+
+// Loads a random subsample of the file and runs a BuildTuner on it, printing
+// its best results. Returns the best settings.
+template <typename Schema>
+static typename BuildTuner<Schema>::Parameters tuneBuild(const std::string& filepath,
+                                                         std::uint64_t frameBudget,
+                                                         const LoadOptions& loadOptions,
+                                                         const ViewerOptions& viewerOptions) {
+  Timer timer;
+  timer.start();
+
+  // a uniform random subset keeps the cloud's density, unlike voxel sampling
+  LoadOptions sampleOptions = loadOptions;
+  constexpr std::uint64_t samplePoints = BuildTuner<Schema>::defaultSamplePoints;
+  sampleOptions.pointLimit = std::min(loadOptions.pointLimit.value_or(samplePoints), samplePoints);
+  sampleOptions.sampling = PointSampler::Mode::Reservoir;
+  sampleOptions.streamingBuild = false;
+  PointCloud sample = PointCloud::build(filepath, sampleOptions);
+
+  // what the full load would keep
+  std::uint64_t fullPoints = sample.getSourcePoints();
+  if (loadOptions.pointLimit) fullPoints = std::min(fullPoints, *loadOptions.pointLimit);
+
+  View view;
+  view.width = defaultWinWidth;
+  view.height = defaultWinHeight;
+  BuildTuner<Schema> tuner(sample, fullPoints, frameBudget, viewerOptions.lodSampling,
+                           loadOptions.seed, view);
+  const std::vector<typename BuildTuner<Schema>::Result> results = tuner.run();
+  timer.end();
+  printTime("TUNING TIME", timer.getMS());
+
+  const auto defaultPrecision = std::cout.precision();
+  std::cout << std::fixed << std::setprecision(2)
+            << "BEST SETTINGS (estimated for the full cloud):\n";
+  for (std::size_t i = 0; i < std::min(tuningResultsShown, results.size()); i++) {
+    const typename BuildTuner<Schema>::Result& result = results[i];
+    std::cout << "  - " << result.parameters.minPointsPerNode << " points per node, resolution "
+              << result.parameters.resolution << ", min screen size "
+              << result.parameters.minScreenSize << ": score " << result.score << '\n'
+              << "    build " << result.buildMS / 1000.f << "s, "
+              << result.memory / (1024.f * 1024.f) << "MB, " << result.nodes << " nodes; per view "
+              << result.selectMS << "ms, " << result.drawCalls << " draw calls, largest node left "
+              << result.frontier << "px\n";
+  }
+  const typename BuildTuner<Schema>::Parameters& best = results.front().parameters;
+  std::cout << "RECOMMENDED: MIN POINTS PER NODE " << best.minPointsPerNode
+            << " --grid-resolution=" << best.resolution
+            << " --min-screen-size=" << best.minScreenSize << std::endl;
+  std::cout.unsetf(std::ios::fixed);
+  std::cout.precision(defaultPrecision);
+  return best;
+}
+
+// Builds the file's octree and selects nodes from it along the BuildTuner's
+// camera path with occlusion culling off, then on, printing the averages per
+// view of each. Each pass is repeated with the views selected for in shared
+// traversals, which must pick what they picked one by one; returns false if
+// they don't. Needs no window, so it runs on machines without a GPU.
+template <typename Schema>
+static bool benchmarkOcclusion(const std::string& filepath, std::uint64_t frameBudget,
+                               unsigned int minPointsPerNode, const LoadOptions& loadOptions,
+                               const ViewerOptions& viewerOptions) {
+  LoadOptions buildOptions = loadOptions;
+  buildOptions.streamingBuild = false;
+  const PointCloud cloud = PointCloud::build(filepath, buildOptions);
+  OctreeNode<Schema> octree = OctreeNode<Schema>::buildOctree(
+      cloud, minPointsPerNode, viewerOptions.resolution, viewerOptions.lodSampling,
+      loadOptions.seed);
+  if (viewerOptions.nodeSize) {
+    octree.rebalance(viewerOptions.nodeSize->x, viewerOptions.nodeSize->y);
+  }
+  octree.updateOccupancy();
+  std::cout << "OCCLUSION BENCHMARK: " << octree.getNodeCount() << " nodes, "
+            << BuildTuner<Schema>::cameraPathViews << " views" << std::endl;
+
+  View view;
+  view.width = defaultWinWidth;
+  view.height = defaultWinHeight;
+  const std::vector<glm::mat4> path = BuildTuner<Schema>::getCameraPath(cloud.getModelMatrix());
+  LODSelector<Schema> selector(frameBudget, viewerOptions.minScreenSize);
+  selector.setDisplayFilter(viewerOptions.displayFilter);
+  std::vector<LODSelectorBase::Viewpoint> viewpoints(path.size());
+  for (std::size_t i = 0; i < path.size(); i++) {
+    viewpoints[i] = {view, path[i], frameBudget};
+  }
+
+  const auto defaultPrecision = std::cout.precision();
+  std::cout << std::fixed << std::setprecision(2);
+  Timer timer;
+  std::size_t numDiffering = 0;
+  for (bool isCulling : {false, true}) {
+    selector.setOcclusionCulling(isCulling);
+    LODSelectorBase::Selection total;
+    std::vector<LODSelectorBase::Selection> selections;
+    timer.start();
+    for (const glm::mat4& modelViewMat : path) {
+      const LODSelectorBase::Selection& selection = selector.select(octree, view, modelViewMat);
+      selections.push_back(selection);
+      total.points += selection.points;
+      total.nodes += selection.nodes;
+      total.candidates += selection.candidates;
+      total.occluded += selection.occluded;
+      total.frontier += selection.frontier;
+    }
+    timer.end();
+    const float views = static_cast<float>(path.size());
+    std::cout << "  - occlusion culling " << (isCulling ? "on" : "off") << ": "
+              << timer.getMS() / views << "ms, " << total.points / views << " points, "
+              << total.nodes / views << " draw calls, " << total.candidates / views
+              << " candidates, " << total.occluded / views
+              << " occluded, largest node left " << total.frontier / views << "px per view"
+              << std::endl;
+
+    // the same views, up to maxViewpoints per traversal
+    float sharedMS = 0.f;
+    for (std::size_t first = 0; first < viewpoints.size();
+         first += LODSelectorBase::maxViewpoints) {
+      const std::size_t last =
+          std::min(viewpoints.size(), first + LODSelectorBase::maxViewpoints);
+      const std::vector<LODSelectorBase::Viewpoint> batch(viewpoints.begin() + first,
+                                                          viewpoints.begin() + last);
+      timer.start();
+      const std::vector<LODSelectorBase::Selection>& shared = selector.select(octree, batch);
+      timer.end();
+      sharedMS += timer.getMS();
+      for (std::size_t i = first; i < last; i++) {
+        const LODSelectorBase::Selection& a = selections[i];
+        const LODSelectorBase::Selection& b = shared[i - first];
+        if (a.points != b.points || a.nodes != b.nodes || a.candidates != b.candidates ||
+            a.occluded != b.occluded || a.frontier != b.frontier) {
+          numDiffering++;
+        }
+      }
+    }
+    std::cout << "  - occlusion culling " << (isCulling ? "on" : "off")
+              << ", views sharing traversals: " << sharedMS / views << "ms per view"
+              << std::endl;
+  }
+  std::cout.unsetf(std::ios::fixed);
+  std::cout.precision(defaultPrecision);
+
+  if (numDiffering > 0) {
+    std::cerr << "Error: Shared traversals picked differently from single views in "
+              << numDiffering << " views" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Prints how many points a finished live feed inserted and how fast.
+template <typename Schema>
+static void printLiveFeedStats(const BuildPipeline<Schema>& pipeline, float ms) {
+  printTime("LIVE FEED TIME", ms);
+  std::cout << "LIVE POINTS INSERTED: " << pipeline.getPointsInserted() << " ("
+            << static_cast<std::uint64_t>(pipeline.getPointsInserted() / (ms / 1000.f))
+            << " per second)\n"
+            << "LIVE POINTS OUTSIDE THE OCTREE: " << pipeline.getPointsDropped() << std::endl;
+}
+
+// Splits a comma separated list of file paths.
+static std::vector<std::string> splitPaths(const std::string& value) {
+  std::vector<std::string> paths;
+  std::istringstream tokens(value);
+  for (std::string token; std::getline(tokens, token, ',');) {
+    if (!token.empty()) paths.push_back(token);
+  }
+  return paths;
+}
+
+// Parses a comma separated list of numbers. Returns false if any is malformed.
+static bool parseList(const std::string& value, std::vector<float>& numbers) {
+  std::istringstream tokens(value);
+  for (std::string token; std::getline(tokens, token, ',');) {
+    char* end = nullptr;
+    numbers.push_back(std::strtof(token.c_str(), &end));
+    if (token.empty() || *end != '\0') return false;
+  }
+  return !numbers.empty();
+}
+
+// Parses a comma separated list of attribute names, or "none". Returns false
+// if any is unknown.
+static bool parseAttributes(const std::string& value, AttributeSet& attributes) {
+  attributes = AttributeSet();
+  attributes.colours = false;
+  if (value == "none") return true;
+
+  std::istringstream tokens(value);
+  bool isEmpty = true;
+  for (std::string token; std::getline(tokens, token, ',');) {
+    if (token == "rgb") {
+      attributes.colours = true;
+    } else if (token == "intensity") {
+      attributes.intensities = true;
+    } else if (token == "classification") {
+      attributes.classifications = true;
+    } else if (token == "normal") {
+      attributes.normals = true;
+    } else {
+      return false;
+    }
+    isEmpty = false;
+  }
+  return !isEmpty;
+}
+
+// Drops the requested attributes the file, which has `available`, lacks.
+// Colourless clouds are shaded instead, as before; the other attributes are an
+// error. Returns false on one.
+static bool resolveAttributes(const std::string& filepath, const AttributeSet& available,
+                              AttributeSet& attributes) {
+  if (attributes.colours && !available.colours) {
+    std::cerr << "Warning: No colour attribute found in " << filepath << std::endl;
+    attributes.colours = false;
+  }
+
+  const char* missing = nullptr;
+  if (attributes.intensities && !available.intensities) missing = "intensity";
+  if (attributes.classifications && !available.classifications) missing = "classification";
+  if (attributes.normals && !available.normals) missing = "normal";
+  if (missing) {
+    std::cerr << "Error: No " << missing << " attribute found in " << filepath << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Splits "--name=value" options out of argv. Returns false on an unknown or
+// malformed option.
+static bool parseOptions(int argc, char** argv, LoadOptions& loadOptions,
+                         ViewerOptions& viewerOptions, std::vector<std::string>& positional) {
+  std::vector<glm::vec2> polygon;
+  glm::vec2 polygonZ(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::max());
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg.rfind("--", 0) != 0) {
+      positional.push_back(arg);
+      continue;
+    }
+
+    const std::size_t eq = arg.find('=');
+    const std::string name = arg.substr(2, eq == std::string::npos ? std::string::npos : eq - 2);
+    const std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+    if (name == "sampling") {
+      std::optional<PointSampler::Mode> mode = PointSampler::parseMode(value);
+      if (!mode) {
+        std::cerr << "Error: Unknown sampling mode '" << value << "'" << std::endl;
+        return false;
+      }
+      loadOptions.sampling = *mode;
+    } else if (name == "lod-sampling") {
+      std::optional<OctreeNodeBase::Sampling> sampling = OctreeNodeBase::parseSampling(value);
+      if (!sampling) {
+        std::cerr << "Error: Unknown LOD sampling policy '" << value << "'" << std::endl;
+        return false;
+      }
+      viewerOptions.lodSampling = *sampling;
+    } else if (name == "seed" && !value.empty()) {
+      loadOptions.seed = std::stoull(value);
+    } else if (name == "streaming-build" && value.empty()) {
+      loadOptions.streamingBuild = true;
+    } else if (name == "pipelined-build" && value.empty()) {
+      loadOptions.streamingBuild = true;
+      viewerOptions.pipelinedBuild = true;
+    } else if (name == "live-feed" && !value.empty()) {
+      viewerOptions.liveFeed = value;
+    } else if (name == "live-rate" && !value.empty()) {
+      viewerOptions.liveRate = std::stoull(value);
+    } else if (name == "fill-holes") {
+      std::vector<float> numbers;
+      if (!value.empty() && (!parseList(value, numbers) || numbers.size() != 1 ||
+                             numbers[0] < 1.f || numbers[0] > HoleFiller::maxPasses)) {
+        std::cerr << "Error: Malformed value for option '" << arg << "'" << std::endl;
+        return false;
+      }
+      viewerOptions.fillHoles = true;
+      if (!numbers.empty()) viewerOptions.fillPasses = static_cast<unsigned int>(numbers[0]);
+    } else if (name == "occlusion-culling" && value.empty()) {
+      viewerOptions.occlusionCulling = true;
+    } else if (name == "benchmark-occlusion" && value.empty()) {
+      viewerOptions.benchmarkOcclusion = true;
+    } else if (name == "tune" && (value.empty() || value == "apply")) {
+      viewerOptions.tune = true;
+      viewerOptions.applyTuning = value == "apply";
+    } else if (name == "attributes") {
+      if (!parseAttributes(value, loadOptions.attributes)) {
+        std::cerr << "Error: Malformed value for option '" << arg << "'" << std::endl;
+        return false;
+      }
+    } else if (name == "every-nth" && !value.empty()) {
+      loadOptions.filter.setEveryNth(std::stoull(value));
+    } else if (name == "crop-box" || name == "crop-polygon" || name == "crop-z" ||
+               name == "intensity" || name == "classification" || name == "node-size" ||
+               name == "grid-resolution" || name == "min-screen-size" ||
+               name == "show-intensity" || name == "show-classification") {
+      std::vector<float> numbers;
+      const bool ok = parseList(value, numbers);
+      if (ok && name == "crop-box" && numbers.size() == 6) {
+        loadOptions.filter.setBox(glm::vec3(numbers[0], numbers[1], numbers[2]),
+                                  glm::vec3(numbers[3], numbers[4], numbers[5]));
+      } else if (ok && name == "crop-polygon" && numbers.size() >= 6 &&
+                 numbers.size() % 2 == 0) {
+        for (std::size_t v = 0; v < numbers.size(); v += 2) {
+          polygon.emplace_back(numbers[v], numbers[v + 1]);
+        }
+      } else if (ok && name == "crop-z" && numbers.size() == 2) {
+        polygonZ = glm::vec2(numbers[0], numbers[1]);
+      } else if (ok && name == "intensity" && numbers.size() == 2) {
+        loadOptions.filter.setIntensityRange(numbers[0], numbers[1]);
+      } else if (ok && name == "classification" && numbers.size() == 2) {
+        loadOptions.filter.setClassificationRange(static_cast<int>(numbers[0]),
+                                                  static_cast<int>(numbers[1]));
+      } else if (ok && name == "show-intensity" && numbers.size() == 2) {
+        viewerOptions.displayFilter.intensity = glm::vec2(numbers[0], numbers[1]);
+      } else if (ok && name == "show-classification" && numbers.size() == 2) {
+        viewerOptions.displayFilter.classification = glm::vec2(numbers[0], numbers[1]);
+      } else if (ok && name == "node-size" && numbers.size() == 2 && numbers[0] >= 0.f &&
+                 numbers[1] >= 1.f && numbers[0] <= numbers[1]) {
+        viewerOptions.nodeSize = glm::uvec2(numbers[0], numbers[1]);
+      } else if (ok && name == "grid-resolution" && numbers.size() == 1 &&
+                 numbers[0] >= 1.f && numbers[0] <= maxResolution) {
+        viewerOptions.resolution = static_cast<unsigned int>(numbers[0]);
+      } else if (ok && name == "min-screen-size" && numbers.size() == 1 && numbers[0] >= 0.f) {
+        viewerOptions.minScreenSize = numbers[0];
+      } else {
+        std::cerr << "Error: Malformed value for option '" << arg << "'" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Error: Unknown option '" << arg << "'" << std::endl;
+      return false;
+    }
+  }
+
+  if (!polygon.empty()) {
+    loadOptions.filter.setPolygon(polygon, polygonZ.x, polygonZ.y);
+  }
+  // the display filter needs its attributes loaded, even if not shaded by
+  if (viewerOptions.displayFilter.intensity) loadOptions.attributes.intensities = true;
+  if (viewerOptions.displayFilter.classification) loadOptions.attributes.classifications = true;
+  if (viewerOptions.nodeSize && viewerOptions.pipelinedBuild) {
+    std::cerr << "Error: --node-size needs the whole octree built before it is drawn, "
+                 "so it can't be used with --pipelined-build"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Builds an octree per file in `Schema`'s layout, then opens the window and
+// draws them as one scene until it is closed.
+// `tileIndex` is set when the files are the tiles of a TileIndex, which are
+// loaded as they come into view rather than up front.
+template <typename Schema>
+static int run(const std::vector<std::string>& filepaths, const TileIndex* tileIndex,
+               std::uint64_t frameBudget, unsigned int minPointsPerNode, LoadOptions loadOptions,
+               ViewerOptions viewerOptions) {
+  std::cout << "POINT ATTRIBUTES: " << Schema::getName() << std::endl;
+
+  // headless, so it runs before a window opens; tiles of one site share the
+  // first file's settings
+  if (viewerOptions.tune) {
+    const typename BuildTuner<Schema>::Parameters best =
+        tuneBuild<Schema>(filepaths.front(), frameBudget, loadOptions, viewerOptions);
+    if (!viewerOptions.applyTuning) return EXIT_SUCCESS;
+    minPointsPerNode = best.minPointsPerNode;
+    viewerOptions.resolution = best.resolution;
+    viewerOptions.minScreenSize = best.minScreenSize;
+  }
+  if (viewerOptions.benchmarkOcclusion) {
+    return benchmarkOcclusion<Schema>(filepaths.front(), frameBudget, minPointsPerNode,
+                                      loadOptions, viewerOptions)
+               ? EXIT_SUCCESS
+               : EXIT_FAILURE;
+  }
 
   if (SDL_Init(SDL_INIT_VIDEO)) {
     std::cerr << "SDL_Init failed: " << SDL_GetError() << std::endl;
@@ -134,23 +782,129 @@ int main(int argc, char** argv) {
   Camera camera;
   Mouse pointCloudMouse(0.02f, true);
 
-  PointCloud pointCloud = PointCloud::build(filepath, bufferBudget);
+  Timer startupTimer;
+  startupTimer.start();
 
+  // a scene of several files shares the first one's view controls, and one of
+  // tiles those of a cloud framing them all
+  std::vector<PointCloud> clouds;
+  clouds.reserve(filepaths.size());
+  const std::vector<std::optional<std::uint64_t>> pointLimits =
+      tileIndex ? std::vector<std::optional<std::uint64_t>>()
+                : sharePointLimit(filepaths, loadOptions.pointLimit);
   timer.start();
-  OctreeNode octree = OctreeNode::buildOctree(
-      pointCloud, frameBudget, minPointsPerNode, view);
+  if (tileIndex) {
+    clouds.push_back(PointCloud::frameBounds(tileIndex->getMin(), tileIndex->getMax()));
+  }
+  for (std::size_t i = 0; i < pointLimits.size(); i++) {
+    if (filepaths.size() > 1) std::cout << filepaths[i] << ":" << std::endl;
+    LoadOptions fileOptions = loadOptions;
+    fileOptions.pointLimit = pointLimits[i];
+    clouds.push_back(fileOptions.streamingBuild ? PointCloud::scan(filepaths[i], fileOptions)
+                                                : PointCloud::build(filepaths[i], fileOptions));
+  }
   timer.end();
+  if (!tileIndex) printTime("LOAD TIME", timer.getMS());
+  PointCloud& pointCloud = clouds.front();
+  SceneShading shading = frameScene(clouds);
+  if (tileIndex) {
+    shading.zRange = glm::vec2(tileIndex->getMin().z, tileIndex->getMax().z);
+    shading.intensityRange = tileIndex->getIntensityRange();
+  }
 
-  const float octreeBuildTime = timer.getMS();
-  const auto defaultPrecision = std::cout.precision();
-  std::cout.precision(2);
-  std::cout << "OCTREE BUILD TIME: " << octreeBuildTime / 1000.f << "s\n"
-            << "TOTAL NODES: " << octree.getTotalNodes() << '\n'
-            << "MAX DEPTH: " << octree.getMaxDepth() << std::endl;
-  std::cout.precision(defaultPrecision);
+  // the live feed's bounds pass runs now so the feed can start right away
+  std::unique_ptr<PointCloud> liveCloud;
+  if (!viewerOptions.liveFeed.empty()) {
+    std::cout << "Live feed " << viewerOptions.liveFeed << ":" << std::endl;
+    liveCloud = std::make_unique<PointCloud>(PointCloud::scan(viewerOptions.liveFeed, loadOptions));
+  }
+
+  // A streaming build reads the points here, so compare it with the default
+  // mode by total time. A pipelined build only creates the root here and
+  // inserts the points while frames are drawn. The build settings are shared,
+  // so each tree is rebalanced before the next is built.
+  Scene<Schema> scene;
+  std::vector<std::uint64_t> sizesBefore;
+  std::vector<std::uint64_t> sizesAfter;
+  float rebalanceMS = 0.f;
+  Timer rebalanceTimer;
+  OctreeNodeBase::resetBuildStats();
+  timer.start();
+  // tiles are built by a TileLoader instead, once they are needed
+  const std::size_t numClouds = tileIndex ? 0 : clouds.size();
+  for (std::size_t i = 0; i < numClouds; i++) {
+    const PointCloud& cloud = clouds[i];
+    OctreeNode<Schema> tree =
+        viewerOptions.pipelinedBuild
+            ? OctreeNode<Schema>::createRoot(cloud.getBoundingBox(), minPointsPerNode,
+                                             viewerOptions.resolution, viewerOptions.lodSampling,
+                                             loadOptions.seed)
+            : OctreeNode<Schema>::buildOctree(cloud, minPointsPerNode,
+                                              viewerOptions.resolution, viewerOptions.lodSampling,
+                                              loadOptions.seed);
+    if (viewerOptions.nodeSize) {
+      addHistogram(sizesBefore, tree.getSizeHistogram());
+      rebalanceTimer.start();
+      tree.rebalance(viewerOptions.nodeSize->x, viewerOptions.nodeSize->y);
+      rebalanceTimer.end();
+      rebalanceMS += rebalanceTimer.getMS();
+      addHistogram(sizesAfter, tree.getSizeHistogram());
+    }
+    // the clouds share one coordinate system, placed by the view's model matrix
+    scene.add(std::move(tree));
+  }
+  timer.end();
+  // the pipelined build and live feed only take a single file, not tiles
+  OctreeNode<Schema>* octree = tileIndex ? nullptr : &scene.getTree(0);
 
-  octree.buffer();
-  octree.bufferDebug();
+  // a live feed needs the build data kept to insert into the drawn octree
+  typename BuildPipeline<Schema>::Options pipelineOptions;
+  pipelineOptions.keepBuildData = liveCloud != nullptr;
+
+  // shared by the build pipeline's inserts and uploads and the LOD worker
+  std::mutex octreeMutex;
+  std::unique_ptr<BuildPipeline<Schema>> pipeline;
+  if (viewerOptions.pipelinedBuild) {
+    pipeline = std::make_unique<BuildPipeline<Schema>>(pointCloud, *octree, octreeMutex,
+                                                       pipelineOptions);
+  } else if (!tileIndex) {
+    printTime("OCTREE BUILD TIME", timer.getMS() - rebalanceMS);
+    printBuildStats(scene);
+    if (viewerOptions.nodeSize) {
+      printNodeSizes("NODE SIZES BEFORE REBALANCING", sizesBefore);
+      printTime("REBALANCE TIME", rebalanceMS);
+      printNodeSizes("NODE SIZES AFTER REBALANCING", sizesAfter);
+    }
+    if (liveCloud) {
+      octree->bufferChanged(std::numeric_limits<std::uint64_t>::max(), true);
+    } else {
+      for (std::size_t i = 0; i < scene.getNumTrees(); i++) {
+        scene.getTree(i).buffer();
+      }
+    }
+  }
+  // tiles are read and built in the background as they come into view
+  std::unique_ptr<TileLoader<Schema>> tileLoader;
+  std::vector<std::size_t> visibleTiles;
+  bool areTilesInViewLoaded = false;
+  if (tileIndex) {
+    const typename TileLoader<Schema>::Settings tileSettings = {
+        minPointsPerNode, viewerOptions.resolution, viewerOptions.lodSampling,
+        viewerOptions.nodeSize};
+    tileLoader = std::make_unique<TileLoader<Schema>>(*tileIndex, loadOptions, tileSettings);
+  }
+  // declared after the scene and pipeline so it stops before either is freed
+  LODWorker<Schema> lodWorker(scene, octreeMutex, frameBudget, viewerOptions.minScreenSize);
+  typename LODWorker<Schema>::Request lodRequest;
+  std::uint64_t pointDrawCount = 0;
+  // set by input that changes what is drawn without moving the view
+  bool needsRedraw = true;
+  glm::mat4 lastModelViewMat(0.f);
+  Refinement refinement = Refinement::Off;
+  std::vector<typename Scene<Schema>::Cursor> refineCursors;
+  bool isFirstFrameDrawn = false;
+  bool isLiveFeeding = false;
+  Timer liveTimer;
 
   const std::string standardTitle = "Point Cloud Renderer";
   SDL_SetWindowTitle(window, standardTitle.c_str());
@@ -163,14 +917,56 @@ int main(int argc, char** argv) {
   // model to world -> world to view -> view projection
   glm::mat4 mvp = projectionMatrix * camera.getViewMatrix() * pointCloud.getModelMatrix();
 
-  unsigned int pointsShaderProg = shader::createProgram(vertexShaderPath, pcFragShaderPath);
-  unsigned int bboxShaderProg = shader::createProgram(vertexShaderPath, bboxFragShaderPath);
+  unsigned int pointsShaderProg =
+      shader::createProgram(vertexShaderPath, pcFragShaderPath, Schema::getDefines());
+  unsigned int bboxShaderProg = shader::createProgram(bboxVertexShaderPath, bboxFragShaderPath);
+  unsigned int accumulationShaderProg =
+      shader::createProgram(fullscreenVertexShaderPath, accumulationFragShaderPath);
+  unsigned int holeFillShaderProg =
+      shader::createProgram(fullscreenVertexShaderPath, holeFillFragShaderPath);
+  // their GL objects are created when a debug view first draws boxes, when
+  // an idle view is first refined and when holes are first filled
+  BoxOverlay bboxOverlay;
+  AccumulationTarget accumulationTarget;
+  HoleFiller holeFiller;
+  bool isFillingHoles = viewerOptions.fillHoles;
+  bool isOcclusionCulled = viewerOptions.occlusionCulling;
 
   glUseProgram(pointsShaderProg);
   unsigned int pcMvpLoc = glGetUniformLocation(pointsShaderProg, "MVP");
   unsigned int pointSizeLoc = glGetUniformLocation(pointsShaderProg, "pointSize");
+  unsigned int normalMatrixLoc = glGetUniformLocation(pointsShaderProg, "normalMatrix");
   glUniformMatrix4fv(pcMvpLoc, 1, GL_FALSE, glm::value_ptr(mvp));
   glUniform1f(pointSizeLoc, pointCloud.getPointSize());
+  glUniform2fv(glGetUniformLocation(pointsShaderProg, "zRange"), 1,
+               glm::value_ptr(shading.zRange));
+  glUniform2fv(glGetUniformLocation(pointsShaderProg, "intensityRange"), 1,
+               glm::value_ptr(shading.intensityRange));
+  bool isDisplayFiltered = true;
+  applyDisplayFilter(pointsShaderProg, viewerOptions.displayFilter);
+
+  // switched with C and M by setting uniforms, nothing is re-uploaded
+  const std::vector<colourmap::Mode> colourModes =
+      colourmap::getModes(Schema::getAttributes());
+  // a placeholder colour shows nothing, so it starts on the next mode
+  std::size_t colourModeIdx = shading.isColourUniform && colourModes.size() > 1 ? 1 : 0;
+  int colourMap = static_cast<int>(colourmap::Map::Grey);
+  unsigned int colourModeLoc = glGetUniformLocation(pointsShaderProg, "colourMode");
+  unsigned int colourMapLoc = glGetUniformLocation(pointsShaderProg, "colourMap");
+  glActiveTexture(GL_TEXTURE0);
+  colourmap::createTexture();
+  glUniform1i(glGetUniformLocation(pointsShaderProg, "colourMaps"), 0);
+  glUniform1i(colourModeLoc, static_cast<int>(colourModes[colourModeIdx]));
+  glUniform1i(colourMapLoc, colourMap);
+
+  // toggled with P; points are sized by the spacing of the nodes drawn over
+  // them, so coarse nodes leave no holes
+  bool isAdaptivePointSize = true;
+  unsigned int adaptivePointSizeLoc =
+      glGetUniformLocation(pointsShaderProg, "isAdaptivePointSize");
+  unsigned int spacingScaleLoc = glGetUniformLocation(pointsShaderProg, "spacingScale");
+  glUniform1i(adaptivePointSizeLoc, isAdaptivePointSize);
+  SpacingTexture spacingTexture(pointsShaderProg);
 
   glUseProgram(bboxShaderProg);
   unsigned int bboxMvpLoc = glGetUniformLocation(bboxShaderProg, "MVP");
@@ -179,6 +975,8 @@ int main(int argc, char** argv) {
   glViewport(0, 0, view.width, view.height);
 
   while (true) {
+    // a fully refined view is not redrawn until something changes
+    if (refinement == Refinement::Done) SDL_WaitEventTimeout(nullptr, idleWaitMS);
     timer.start();
 
     // --- input handling ---
@@ -237,6 +1035,46 @@ int main(int argc, char** argv) {
               break;
             case SDLK_TAB:
               liveDebug = (liveDebug + 1) % 4;
+              needsRedraw = true;
+              break;
+            case SDLK_c:
+            case SDLK_m:
+              if (event.key.keysym.sym == SDLK_c) {
+                colourModeIdx = (colourModeIdx + 1) % colourModes.size();
+              } else {
+                colourMap = (colourMap + 1) % colourmap::numMaps;
+              }
+              glUseProgram(pointsShaderProg);
+              glUniform1i(colourModeLoc, static_cast<int>(colourModes[colourModeIdx]));
+              glUniform1i(colourMapLoc, colourMap);
+              std::cout << "Colouring by "
+                        << colourmap::getModeName(colourModes[colourModeIdx]) << ", "
+                        << colourmap::getMapName(static_cast<colourmap::Map>(colourMap))
+                        << " map" << std::endl;
+              needsRedraw = true;
+              break;
+            case SDLK_v:
+              isDisplayFiltered = !isDisplayFiltered;
+              applyDisplayFilter(pointsShaderProg,
+                                 isDisplayFiltered ? viewerOptions.displayFilter
+                                                   : OctreeNodeBase::DisplayFilter());
+              needsRedraw = true;
+              break;
+            case SDLK_h:
+              isFillingHoles = !isFillingHoles;
+              needsRedraw = true;
+              break;
+            case SDLK_o:
+              isOcclusionCulled = !isOcclusionCulled;
+              std::cout << "Occlusion culling " << (isOcclusionCulled ? "on" : "off")
+                        << std::endl;
+              needsRedraw = true;
+              break;
+            case SDLK_p:
+              isAdaptivePointSize = !isAdaptivePointSize;
+              glUseProgram(pointsShaderProg);
+              glUniform1i(adaptivePointSizeLoc, isAdaptivePointSize);
+              needsRedraw = true;
               break;
           }
           break;
@@ -264,9 +1102,12 @@ int main(int argc, char** argv) {
           }
           glUseProgram(pointsShaderProg);
           glUniform1f(pointSizeLoc, pointCloud.getPointSize());
+          needsRedraw = true;
           break;
 
         case SDL_WINDOWEVENT:
+          // e.g. exposed, or resized
+          needsRedraw = true;
           // update projection matrix and viewport to account for new window size
           if (event.window.event == SDL_WINDOWEVENT_RESIZED) {
             SDL_GetWindowSize(window, &view.width, &view.height);
@@ -282,30 +1123,169 @@ int main(int argc, char** argv) {
 
     // --- drawing ---
 
+    // while a pipelined build runs, the octree is shared with its builder
+    std::unique_lock<std::mutex> octreeLock;
+    if (pipeline && !pipeline->isFinished()) {
+      octreeLock = pipeline->lockOctree();
+      if (pipeline->upload(uploadBudgetPerFrame)) {
+        octreeLock.unlock();
+        if (pipeline->hasFailed()) {
+          std::cerr << "Error: " << pipeline->getError()
+                    << ", drawing the points read until then" << std::endl;
+        }
+        if (isLiveFeeding) {
+          liveTimer.end();
+          printLiveFeedStats(*pipeline, liveTimer.getMS());
+        } else {
+          startupTimer.end();
+          printTime("TIME TO FULL DETAIL", startupTimer.getMS());
+        }
+        printBuildStats(scene);
+      }
+    }
+
+    // the live feed starts once the octree from the file is drawn in full
+    if (liveCloud && !isLiveFeeding && isFirstFrameDrawn &&
+        (!pipeline || pipeline->isFinished())) {
+      typename BuildPipeline<Schema>::Options liveOptions = pipelineOptions;
+      liveOptions.dropOutside = true;
+      liveOptions.pointsPerSecond = viewerOptions.liveRate;
+      pipeline =
+          std::make_unique<BuildPipeline<Schema>>(*liveCloud, *octree, octreeMutex, liveOptions);
+      isLiveFeeding = true;
+      liveTimer.start();
+    }
+
     mvp = projectionMatrix * camera.getViewMatrix() * pointCloud.getModelMatrix();
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // model-view matrix - for syncing node position with GPU
+    const glm::mat4 modelViewMat = camera.getViewMatrix() * pointCloud.getModelMatrix();
+    bool isSceneChanged = pipeline && !pipeline->isFinished();
 
-    if (liveDebug) {
-      glUseProgram(bboxShaderProg);
-      glUniformMatrix4fv(bboxMvpLoc, 1, GL_FALSE, glm::value_ptr(mvp));
-      // debug mode 2: draw bounding boxes of nodes being drawn
-      if (liveDebug == 2) octree.drawDebug();
-      // debug mode 3: draw bounding boxes of all nodes
-      if (liveDebug == 3) octree.drawDebugAll();
+    // Tiles are requested once in view, largest on screen first, and one
+    // finished tile is uploaded per frame, bounding the frame's stall. It is
+    // added under the lock, as the LOD worker reads the scene's trees.
+    if (tileLoader) {
+      tileIndex->findVisible(view, modelViewMat, viewerOptions.minScreenSize, visibleTiles);
+      for (std::size_t tile : visibleTiles) {
+        tileLoader->request(tile);
+      }
+      if (std::optional<typename TileLoader<Schema>::Loaded> loaded = tileLoader->take()) {
+        loaded->octree.buffer();
+        {
+          std::lock_guard<std::mutex> lock(octreeMutex);
+          scene.add(std::move(loaded->octree));
+        }
+        isSceneChanged = true;
+        std::cout << "TILE " << scene.getNumTrees() << "/" << tileIndex->size() << " LOADED: "
+                  << tileIndex->getTile(loaded->tile).filepath << ", " << loaded->points
+                  << " points" << std::endl;
+      }
+      // skipped tiles count as loaded
+      if (!areTilesInViewLoaded && scene.getNumTrees() > 0 &&
+          tileLoader->getPendingCount() == 0) {
+        areTilesInViewLoaded = true;
+        startupTimer.end();
+        printTime("TIME TO FULL DETAIL", startupTimer.getMS());
+      }
     }
+    // Only this thread uploads and deletes nodes, so submitting the worker's
+    // latest lists needs no lock. It selects for this frame's view meanwhile.
+    if (octreeLock.owns_lock()) octreeLock.unlock();
 
-    glUseProgram(pointsShaderProg);
-    glUniformMatrix4fv(pcMvpLoc, 1, GL_FALSE, glm::value_ptr(mvp));
-    octree.draw(
-        // model-view matrix - for syncing node position with GPU
-        camera.getViewMatrix() * pointCloud.getModelMatrix());
+    // A view that changed, or shows node boxes, is drawn within the budget
+    // every frame. Once idle, it is selected for again without the budget,
+    // and each frame adds about a budget of points to the accumulation
+    // target until every node is drawn. It is then not redrawn at all.
+    const bool isIdle = modelViewMat == lastModelViewMat && !needsRedraw && !isSceneChanged &&
+                        liveDebug < 2;
+    lastModelViewMat = modelViewMat;
+    needsRedraw = false;
+    if (!isIdle) refinement = Refinement::Off;
+    if (!isIdle || !lodRequest.isRefining) {
+      // the window size is read per request, so resizes apply to selection too
+      lodRequest.view = view;
+      lodRequest.modelViewMat = modelViewMat;
+      lodRequest.displayFilter =
+          isDisplayFiltered ? viewerOptions.displayFilter : OctreeNodeBase::DisplayFilter();
+      lodRequest.isRefining = isIdle;
+      lodRequest.isOcclusionCulled = isOcclusionCulled;
+      lodRequest.serial++;
+      lodWorker.post(lodRequest);
+    }
 
-    SDL_GL_SwapWindow(window);
+    const std::vector<typename OctreeNode<Schema>::DrawList>& drawLists =
+        lodWorker.getDrawLists();
+    const auto setModelMatrix = [&](const glm::mat4& treeModelMat) {
+      glUniformMatrix4fv(pcMvpLoc, 1, GL_FALSE, glm::value_ptr(mvp * treeModelMat));
+      // the model matrices only rotate and scale uniformly, and the
+      // projection's focal length is in half-heights of the window
+      const float treeScale = glm::length(glm::vec3((modelViewMat * treeModelMat)[0]));
+      glUniform1f(spacingScaleLoc, treeScale * projectionMatrix[1][1] * view.height * 0.5f);
+      if constexpr (Schema::template has<attribute::Normal>) {
+        // normals are normalised in the shader
+        const glm::mat3 normalMatrix(modelViewMat * treeModelMat);
+        glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, glm::value_ptr(normalMatrix));
+      }
+    };
+    SpacingTexture* spacing = isAdaptivePointSize ? &spacingTexture : nullptr;
+    bool isFrameDrawn = false;
+    if (!isIdle) {
+      // refined views are drawn in full instead, so holes are only filled here
+      if (isFillingHoles) {
+        holeFiller.bind(view.width, view.height);
+      } else {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      }
+
+      // debug mode 2: draw bounding boxes of nodes being drawn
+      // debug mode 3: draw bounding boxes of all nodes
+      if (liveDebug >= 2) {
+        // the boxes walk the trees, which a pipelined build still inserts into
+        std::lock_guard<std::mutex> lock(octreeMutex);
+        glUseProgram(bboxShaderProg);
+        scene.drawDebugBoxes(bboxOverlay, liveDebug == 2, [&](const glm::mat4& treeModelMat) {
+          glUniformMatrix4fv(bboxMvpLoc, 1, GL_FALSE, glm::value_ptr(mvp * treeModelMat));
+        });
+      }
+
+      glUseProgram(pointsShaderProg);
+      pointDrawCount = scene.submit(drawLists, setModelMatrix, spacing);
+      if (isFillingHoles) {
+        holeFiller.fill(holeFillShaderProg, viewerOptions.fillPasses, view.zNearPlane,
+                        view.zFarPlane);
+      }
+      isFrameDrawn = true;
+    } else if (refinement != Refinement::Done &&
+               lodWorker.getDrawListsRequest().serial == lodRequest.serial) {
+      const bool isStarting = refinement == Refinement::Off;
+      if (isStarting) {
+        refineCursors.clear();
+        pointDrawCount = 0;
+      }
+      accumulationTarget.bind(view.width, view.height, isStarting);
+      glUseProgram(pointsShaderProg);
+      const std::uint64_t refinedPoints =
+          scene.submitNext(drawLists, frameBudget, refineCursors, setModelMatrix, spacing);
+      pointDrawCount += refinedPoints;
+      refinement = refinedPoints > 0 ? Refinement::Refining : Refinement::Done;
+      accumulationTarget.present(accumulationShaderProg);
+      isFrameDrawn = true;
+    }
 
     // --- framerate cap & performance ---
 
-    // force GPU operations to complete for higher time measurement accuracy
-    glFinish();
+    if (isFrameDrawn) {
+      SDL_GL_SwapWindow(window);
+      // force GPU operations to complete for higher time measurement accuracy
+      glFinish();
+    }
+
+    if (!isFirstFrameDrawn && pointDrawCount > 0) {
+      isFirstFrameDrawn = true;
+      startupTimer.end();
+      printTime("TIME TO FIRST FRAME", startupTimer.getMS());
+      if (!pipeline && !tileLoader) printTime("TIME TO FULL DETAIL", startupTimer.getMS());
+    }
     timer.updateAverages();
     const int avgFPS = timer.getAvgFPS();
     const float avgMS = timer.getAvgMS();
@@ -325,12 +1305,76 @@ int main(int argc, char** argv) {
 
     if (liveDebug) {
       std::ostringstream os;
-      os << "Points: " << octree.getPointDrawCount()
+      os << "Points: " << pointDrawCount
          << " | Uncapped: " << std::setprecision(2) << fps << "FPS " << elapsedMS
          << "MS | Average: " << avgFPS << "FPS " << avgMS << "MS";
+      if (isFillingHoles) os << " | Hole fill: " << holeFiller.getGpuMS() << "MS GPU";
       SDL_SetWindowTitle(window, os.str().c_str());
     } else {
       SDL_SetWindowTitle(window, standardTitle.c_str());
     }
   }
 }
+
+int main(int argc, char** argv) {
+  // --- initialisation ---
+  LoadOptions loadOptions;
+  ViewerOptions viewerOptions;
+  std::vector<std::string> args;
+  if (!parseOptions(argc, argv, loadOptions, viewerOptions, args) ||
+      args.size() < 2 || args.size() > 4) {
+    printUsage();
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::string> filepaths = splitPaths(args[0]);
+  const std::uint64_t frameBudget = std::stoull(args[1]);
+  if (args.size() >= 3) {
+    loadOptions.pointLimit = std::stoull(args[2]);
+  }
+  const unsigned int minPointsPerNode =
+      args.size() == 4 ? std::stoul(args[3]) : defaultMinPointsPerNode;
+  if (filepaths.empty()) {
+    printUsage();
+    return EXIT_FAILURE;
+  }
+  const bool isTileSet = filepaths.size() == 1 && TileIndex::isTileSet(filepaths.front());
+  if ((filepaths.size() > 1 || isTileSet) &&
+      (viewerOptions.pipelinedBuild || !viewerOptions.liveFeed.empty())) {
+    std::cerr << "Error: --pipelined-build and --live-feed take a single FILE" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // a tile set's headers and bounds are read up front, its points as needed
+  std::unique_ptr<TileIndex> tileIndex;
+  if (isTileSet) {
+    Timer timer;
+    timer.start();
+    std::optional<TileIndex> opened = TileIndex::open(filepaths.front(), loadOptions);
+    if (!opened) return EXIT_FAILURE;
+    tileIndex = std::make_unique<TileIndex>(std::move(*opened));
+    timer.end();
+    printTime("TILE INDEX TIME", timer.getMS());
+    filepaths = tileIndex->getFilepaths();
+    for (std::size_t i = 0; i < tileIndex->size(); i++) {
+      const TileIndex::Tile& tile = tileIndex->getTile(i);
+      if (!resolveAttributes(tile.filepath, tile.attributes, loadOptions.attributes)) {
+        return EXIT_FAILURE;
+      }
+    }
+  } else {
+    for (const std::string& filepath : filepaths) {
+      if (!resolveAttributes(filepath, PointCloud::getFileAttributes(filepath),
+                             loadOptions.attributes)) {
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // the rest is compiled for each point schema, and runs the files'
+  return dispatchSchema(loadOptions.attributes, [&](auto schema) {
+    return run<decltype(schema)>(filepaths, tileIndex.get(), frameBudget, minPointsPerNode,
+                                 loadOptions, viewerOptions);
+  });
+}
+
@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <occlusion-culler/occlusion-culler.h>
+
+namespace {
+
+  constexpr float farDepth = std::numeric_limits<float>::max();
+
+  // row[i] = min(row[i], depth) over `count` texels
+  void drawSpan(float* row, int count, float depth) {
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 depths = _mm_set1_ps(depth);
+    for (; i + 4 <= count; i += 4) {
+      _mm_storeu_ps(row + i, _mm_min_ps(_mm_loadu_ps(row + i), depths));
+    }
+#endif
+    for (; i < count; i++) {
+      row[i] = std::min(row[i], depth);
+    }
+  }
+
+  // dst[i] = the maximum of the 2x2 texels of rows `a` and `b` under it
+  void downsampleRow(const float* a, const float* b, float* dst, int dstWidth) {
+    int i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= dstWidth; i += 4) {
+      const __m128 low = _mm_max_ps(_mm_loadu_ps(a + 2 * i), _mm_loadu_ps(b + 2 * i));
+      const __m128 high = _mm_max_ps(_mm_loadu_ps(a + 2 * i + 4), _mm_loadu_ps(b + 2 * i + 4));
+      const __m128 even = _mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0));
+      const __m128 odd = _mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1));
+      _mm_storeu_ps(dst + i, _mm_max_ps(even, odd));
+    }
+#endif
+    for (; i < dstWidth; i++) {
+      dst[i] = std::max(std::max(a[2 * i], a[2 * i + 1]), std::max(b[2 * i], b[2 * i + 1]));
+    }
+  }
+
+}  // namespace
+
+OcclusionCuller::OcclusionCuller()
+    : focalX(0.f),
+      focalY(0.f) {
+  glm::ivec2 size(width, height);
+  levelSizes.push_back(size);
+  while (size.x > 1 || size.y > 1) {
+    size = glm::max(size / 2, glm::ivec2(1));
+    levelSizes.push_back(size);
+  }
+  for (const glm::ivec2& levelSize : levelSizes) {
+    levels.emplace_back(std::size_t(levelSize.x) * levelSize.y, farDepth);
+  }
+}
+
+void OcclusionCuller::reset(const View& view) {
+  this->view = view;
+  const float slopeY = std::tan(glm::radians(view.fov) * 0.5f);
+  const float aspect = view.height > 0 ? float(view.width) / float(view.height) : 1.f;
+  focalX = width * 0.5f / (slopeY * aspect);
+  focalY = height * 0.5f / slopeY;
+  occluders.clear();
+}
+
+void OcclusionCuller::addOccluder(const glm::vec3& center, float inner, float outer) {
+  const float distance = -center.z;
+  if (distance - outer < view.zNearPlane) return;
+  glm::vec2 pixel;
+  glm::vec2 scale;
+  if (!project(center, pixel, scale)) return;
+
+  // the square around the inner sphere's disc, covering the texels whose
+  // centres it holds
+  const glm::vec2 half = inner * scale;
+  Rect rect;
+  rect.x0 = std::max(0, static_cast<int>(std::ceil(pixel.x - half.x - 0.5f)));
+  rect.y0 = std::max(0, static_cast<int>(std::ceil(pixel.y - half.y - 0.5f)));
+  rect.x1 = std::min(width, static_cast<int>(std::floor(pixel.x + half.x - 0.5f)) + 1);
+  rect.y1 = std::min(height, static_cast<int>(std::floor(pixel.y + half.y - 0.5f)) + 1);
+  rect.depth = distance + outer;
+  if (rect.x0 < rect.x1 && rect.y0 < rect.y1) occluders.push_back(rect);
+}
+
+void OcclusionCuller::rasterize() {
+  std::vector<float>& buffer = levels.front();
+  std::fill(buffer.begin(), buffer.end(), farDepth);
+  for (const Rect& rect : occluders) {
+    for (int y = rect.y0; y < rect.y1; y++) {
+      drawSpan(&buffer[std::size_t(y) * width + rect.x0], rect.x1 - rect.x0, rect.depth);
+    }
+  }
+  for (std::size_t level = 1; level < levels.size(); level++) {
+    downsample(level);
+  }
+}
+
+void OcclusionCuller::test(const std::vector<Sphere>& spheres,
+                           std::vector<unsigned char>& isHidden) const {
+  isHidden.resize(spheres.size());
+  for (std::size_t i = 0; i < spheres.size(); i++) {
+    isHidden[i] = this->isHidden(spheres[i]);
+  }
+}
+
+bool OcclusionCuller::isHidden(const Sphere& sphere) const {
+  const float nearest = -sphere.center.z - sphere.radius;
+  if (nearest <= view.zNearPlane) return false;
+  glm::vec2 pixel;
+  glm::vec2 scale;
+  if (!project(sphere.center, pixel, scale)) return false;
+
+  // the sphere's square, as large as it would be at its nearest point
+  const glm::vec2 half = sphere.radius * scale * (-sphere.center.z / nearest);
+  const int x0 = std::max(0, static_cast<int>(std::floor(pixel.x - half.x)));
+  const int y0 = std::max(0, static_cast<int>(std::floor(pixel.y - half.y)));
+  const int x1 = std::min(width - 1, static_cast<int>(std::floor(pixel.x + half.x)));
+  const int y1 = std::min(height - 1, static_cast<int>(std::floor(pixel.y + half.y)));
+  if (x0 > x1 || y0 > y1) return false;
+
+  // the level at which the square spans at most 2x2 texels
+  const int span = std::max(x1 - x0, y1 - y0) + 1;
+  int level = 0;
+  while ((1 << level) < span && level + 1 < static_cast<int>(levels.size())) level++;
+
+  float farthest = 0.f;
+  for (int y = y0 >> level; y <= y1 >> level; y++) {
+    for (int x = x0 >> level; x <= x1 >> level; x++) {
+      farthest = std::max(farthest, getLevelMax(level, x, y));
+    }
+  }
+  return farthest < nearest;
+}
+
+bool OcclusionCuller::project(const glm::vec3& center, glm::vec2& pixel,
+                              glm::vec2& scale) const {
+  const float distance = -center.z;
+  if (distance <= view.zNearPlane) return false;
+  scale = glm::vec2(focalX, focalY) / distance;
+  pixel = glm::vec2(width, height) * 0.5f + glm::vec2(center) * scale;
+  return true;
+}
+
+void OcclusionCuller::downsample(std::size_t level) {
+  const std::vector<float>& src = levels[level - 1];
+  const glm::ivec2 srcSize = levelSizes[level - 1];
+  std::vector<float>& dst = levels[level];
+  const glm::ivec2 dstSize = levelSizes[level];
+  for (int y = 0; y < dstSize.y; y++) {
+    const float* a = &src[std::size_t(std::min(2 * y, srcSize.y - 1)) * srcSize.x];
+    const float* b = &src[std::size_t(std::min(2 * y + 1, srcSize.y - 1)) * srcSize.x];
+    downsampleRow(a, b, &dst[std::size_t(y) * dstSize.x], dstSize.x);
+  }
+}
+
+float OcclusionCuller::getLevelMax(int level, int x, int y) const {
+  const glm::ivec2 size = levelSizes[level];
+  return levels[level][std::size_t(std::min(y, size.y - 1)) * size.x + std::min(x, size.x - 1)];
+}
@@ -1,55 +1,171 @@
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
 #include <queue>
+#include <tuple>
 #include <utility>
 
 #include <octree/octree-node.h>
 
-OctreeNode::OctreeNode()
+namespace {
+
+  // splitmix64 finaliser, as used by PointSampler
+  std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+  }
+
+  std::uint32_t floatBits(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+  }
+
+  bool isLower(const glm::vec3& a, const glm::vec3& b) {
+    return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+  }
+
+  // whether a point at `a` scoring `scoreA` in its cell goes before one at
+  // `b` scoring `scoreB`, for the cell or a place in the overflow
+  bool isAhead(std::uint32_t scoreA, const glm::vec3& a, std::uint32_t scoreB,
+               const glm::vec3& b) {
+    return scoreA < scoreB || (scoreA == scoreB && isLower(a, b));
+  }
+
+  template <typename Schema>
+  const glm::vec3& getPosition(const typename Schema::Point& point) {
+    return Schema::template get<attribute::Position>(point);
+  }
+
+  void extendRange(glm::vec2& range, float value) {
+    range.x = std::min(range.x, value);
+    range.y = std::max(range.y, value);
+  }
+
+  // widens `summary` to cover `points`
+  template <typename Schema>
+  void summarise(const typename Schema::Columns& points,
+                 OctreeNodeBase::AttributeSummary& summary) {
+    if constexpr (Schema::template has<attribute::Intensity>) {
+      for (const auto value : points.template get<attribute::Intensity>()) {
+        extendRange(summary.intensity, attribute::Intensity::decode(value));
+      }
+    }
+    if constexpr (Schema::template has<attribute::Classification>) {
+      for (const auto value : points.template get<attribute::Classification>()) {
+        extendRange(summary.classification, value);
+      }
+    }
+  }
+
+  bool overlaps(const glm::vec2& range, const std::optional<glm::vec2>& filter) {
+    return !filter || (range.x <= filter->y && range.y >= filter->x);
+  }
+
+}  // namespace
+
+std::optional<OctreeNodeBase::Sampling> OctreeNodeBase::parseSampling(const std::string& name) {
+  if (name == "first") return Sampling::First;
+  if (name == "center") return Sampling::Center;
+  if (name == "average") return Sampling::Average;
+  if (name == "random") return Sampling::Random;
+  return std::nullopt;
+}
+
+const char* OctreeNodeBase::getSamplingName(Sampling sampling) {
+  switch (sampling) {
+    case Sampling::First:
+      return "first";
+    case Sampling::Center:
+      return "center";
+    case Sampling::Average:
+      return "average";
+    default:
+      return "random";
+  }
+}
+
+template <typename Schema>
+OctreeNode<Schema>::OctreeNode()
     : children{nullptr},
       activeChildren(0),
       depth(0),
+      limit(Limit::None),
       cellSize(0),
-      screenProjectedSize(0),
+      gridOrigin(0.f),
       isBuffered(false),
       isDrawn(false),
+      isChanged(false),
+      hasChangedBelow(false),
+      isAppendOnly(true),
+      occupancy(0),
       vao(0) {
 }
 
-OctreeNode::OctreeNode(BoundingBox bbox, unsigned int depth)
+template <typename Schema>
+OctreeNode<Schema>::OctreeNode(BoundingBox bbox, unsigned int depth,
+                               std::shared_ptr<const BuildSettings> settings)
     : bbox(bbox),
       children{nullptr},
       activeChildren(0),
       depth(depth),
-      cellSize(bbox.getScale() / resolution),
-      screenProjectedSize(0),
+      limit(Limit::None),
+      settings(std::move(settings)),
+      cellSize(std::max(bbox.getScale(), this->settings->minNodeExtent) /
+               this->settings->resolution),
+      gridOrigin(glm::floor(bbox.getMin() / cellSize)),
       isBuffered(false),
       isDrawn(false),
+      isChanged(false),
+      hasChangedBelow(false),
+      isAppendOnly(true),
+      occupancy(0),
       vao(0) {
-  if (depth > maxDepth) {
-    maxDepth = depth;
+  const glm::vec3 dimensions = bbox.getDimensions();
+  const float extent = std::max(dimensions.x, std::max(dimensions.y, dimensions.z));
+  if (depth >= depthLimit) {
+    limit = Limit::Depth;
+  } else if (extent * 0.5f < this->settings->minNodeExtent) {
+    limit = Limit::Extent;
   }
 }
 
-OctreeNode::~OctreeNode() {
+template <typename Schema>
+OctreeNode<Schema>::~OctreeNode() {
   deleteChildren();
   if (vao != 0) {
     glDeleteVertexArrays(1, &vao);
   }
 }
 
-OctreeNode::OctreeNode(OctreeNode&& other) noexcept
+template <typename Schema>
+OctreeNode<Schema>::OctreeNode(OctreeNode&& other) noexcept
     : buffers(std::move(other.buffers)),
       bbox(other.bbox),
       activeChildren(other.activeChildren),
       depth(other.depth),
-      overflowPositions(std::move(other.overflowPositions)),
-      overflowColours(std::move(other.overflowColours)),
+      limit(other.limit),
+      settings(std::move(other.settings)),
+      overflow(std::move(other.overflow)),
+      overflowScores(std::move(other.overflowScores)),
       grid(std::move(other.grid)),
       cellSize(other.cellSize),
-      screenProjectedSize(other.screenProjectedSize),
+      gridOrigin(other.gridOrigin),
       isBuffered(other.isBuffered),
       isDrawn(other.isDrawn),
+      isChanged(other.isChanged),
+      hasChangedBelow(other.hasChangedBelow),
+      isAppendOnly(other.isAppendOnly),
+      pending(std::move(other.pending)),
+      summary(other.summary),
+      occupancy(other.occupancy),
       vao(other.vao) {
   for (int i = 0; i < 8; i++) {
     children[i] = other.children[i];
@@ -59,7 +175,8 @@ OctreeNode::OctreeNode(OctreeNode&& other) noexcept
   other.vao = 0;
 }
 
-void OctreeNode::deleteChildren() {
+template <typename Schema>
+void OctreeNode<Schema>::deleteChildren() {
   for (int i = 0; i < 8; i++) {
     delete children[i];
     children[i] = nullptr;
@@ -67,86 +184,302 @@ void OctreeNode::deleteChildren() {
   activeChildren = 0;
 }
 
-bool OctreeNode::isChildActive(unsigned int idx) const {
+template <typename Schema>
+bool OctreeNode<Schema>::isChildActive(unsigned int idx) const {
   return (activeChildren & (1 << idx)) != 0;
 }
 
-void OctreeNode::activateChild(unsigned int idx) {
+template <typename Schema>
+void OctreeNode<Schema>::activateChild(unsigned int idx) {
   activeChildren |= (1 << idx);
 }
 
-bool OctreeNode::compareByScreenProjectedSize(OctreeNode* node1,
-                                              OctreeNode* node2) {
-  return node1->screenProjectedSize > node2->screenProjectedSize;
+template <typename Schema>
+OctreeNode<Schema> OctreeNode<Schema>::buildOctree(const PointCloud& pointCloud,
+                                   unsigned int minPointsPerNode,
+                                   unsigned int resolution,
+                                   Sampling sampling, std::uint64_t seed) {
+  const BoundingBox& bbox = pointCloud.getBoundingBox();
+  auto settings = std::make_shared<BuildSettings>(
+      *configure(bbox, minPointsPerNode, resolution, sampling, seed));
+  settings->pointSpacing = pointCloud.getSpacing();
+  OctreeNode root(bbox, initialDepth, std::move(settings));
+
+  // streaming build: insert each batch as the reader decodes it
+  if (pointCloud.isScanned()) {
+    std::string error;
+    const bool isRead = pointCloud.stream(
+        [&root](const PointBatch& batch) {
+          for (std::size_t i = 0; i < batch.size(); i++) {
+            root.insert(Schema::getPoint(batch, i));
+          }
+          return true;
+        },
+        error);
+    if (!isRead) {
+      std::cerr << "Error: " << error << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    return root;
+  }
+
+  const PointBatch& points = pointCloud.getPoints();
+  for (std::size_t i = 0; i < points.size(); i++) {
+    root.insert(Schema::getPoint(points, i));
+  }
+
+  return root;
 }
 
-OctreeNode OctreeNode::buildOctree(const PointCloud& pointCloud,
-                                   unsigned int pointBudget,
-                                   unsigned int minPointsPerNode,
-                                   const View& view) {
-  OctreeNode::frameBudget = pointBudget;
-  OctreeNode::minPointsPerNode = minPointsPerNode;
-  OctreeNode::view = view;
+template <typename Schema>
+OctreeNode<Schema> OctreeNode<Schema>::createRoot(const BoundingBox& bbox,
+                                  unsigned int minPointsPerNode,
+                                  unsigned int resolution,
+                                  Sampling sampling, std::uint64_t seed) {
+  return OctreeNode(bbox, initialDepth,
+                    configure(bbox, minPointsPerNode, resolution, sampling, seed));
+}
 
-  OctreeNode root(pointCloud.getBoundingBox(), initialDepth);
+template <typename Schema>
+void OctreeNode<Schema>::insert(const Point& point) {
+  const glm::vec3& position = getPosition<Schema>(point);
+  const glm::vec3 cellCoords = glm::floor(position / cellSize);
+  const int gridCellHash = getCellHash(cellCoords);
+
+  const std::uint32_t score = getScore(position, cellCoords);
+  auto [entry, isNewCell] = grid.try_emplace(gridCellHash);
+  Cell& cell = entry->second;
+  if (isNewCell) {
+    cell.point = point;
+    cell.score = score;
+    cell.duplicates = 0;
+    if constexpr (hasColour) {
+      cell.colourSum = glm::u64vec3(Schema::template get<attribute::Colour>(point));
+      cell.count = 1;
+    }
+    recordAppend(point);
+    trimOverflow();
+    return;
+  }
 
-  const Buffers& buffers = pointCloud.getBuffers();
-  const glm::vec3* pointPositions = buffers.getPositionBuffer();
-  const glm::u8vec3* pointColours = buffers.getColourBuffer();
+  // copies count towards the mean colour too, as whether they are dropped
+  // depends on the order
+  if constexpr (hasColour) {
+    if (settings->sampling == Sampling::Average) {
+      cell.colourSum += glm::u64vec3(Schema::template get<attribute::Colour>(point));
+      cell.count++;
+      recordRewrite();
+    }
+  }
 
-  for (unsigned int i = 0; i < buffers.getNumPoints(); i++) {
-    root.insert(&pointPositions[i], &pointColours[i]);
+  if (getPosition<Schema>(cell.point) == position) {
+    cell.duplicates++;
+    buildStats.duplicatePoints++;
+    return;
   }
 
-  return root;
+  // The point that loses the cell is the one passed on below, with the
+  // copies of it dropped while it held the cell, so the same copies move
+  // down whether they came before or after the point that won.
+  const Point* passedOn = &point;
+  std::uint32_t passedScore = score;
+  std::uint32_t copies = 1;
+  Point displaced;
+  if (settings->sampling != Sampling::First &&
+      isAhead(score, position, cell.score, getPosition<Schema>(cell.point))) {
+    displaced = cell.point;
+    passedOn = &displaced;
+    passedScore = cell.score;
+    copies += cell.duplicates;
+    buildStats.duplicatePoints -= cell.duplicates;
+    cell.point = point;
+    cell.score = score;
+    cell.duplicates = 0;
+    recordRewrite();
+  }
+  for (std::uint32_t i = 0; i < copies; i++) {
+    passOn(*passedOn, passedScore);
+  }
 }
 
-void OctreeNode::insert(const glm::vec3* position, const glm::u8vec3* colour) {
-  // spatial hash: project the point's 3D cell position into one integer.
-  int gridCellHash =
-      (std::floor(position->x / cellSize)) +
-      (std::floor(position->y / cellSize)) * resolution +
-      (std::floor(position->z / cellSize)) * resolution * resolution;
-
-  if (grid.find(gridCellHash) == grid.end()) {
-    grid[gridCellHash] = {*position, *colour};
-  } else if (grid.size() + overflowPositions.size() < minPointsPerNode) {
-    overflowPositions.push_back(*position);
-    overflowColours.push_back(*colour);
-  } else {
-    unsigned int childNodeIdx = getChildNodeIndex(position);
-    if (!isChildActive(childNodeIdx)) {
-      createChildNode(childNodeIdx);
+template <typename Schema>
+void OctreeNode<Schema>::passOn(const Point& point, std::uint32_t score) {
+  if (limit != Limit::None) {
+    if (getBuildSize() >= settings->minPointsPerNode) {
+      (limit == Limit::Depth ? buildStats.depthLimitedPoints
+                             : buildStats.extentLimitedPoints)++;
     }
-    children[childNodeIdx]->insert(position, colour);
-
-    if (!overflowPositions.empty()) {
-      for (size_t i = 0; i < overflowPositions.size(); i++) {
-        unsigned int childNodeIdx = getChildNodeIndex(&overflowPositions[i]);
-        if (!isChildActive(childNodeIdx)) {
-          createChildNode(childNodeIdx);
-        }
-        children[childNodeIdx]->insert(&overflowPositions[i], &overflowColours[i]);
-      }
-      overflowPositions.clear();
-      overflowColours.clear();
+    pushOverflow(point, score);
+    recordAppend(point);
+    return;
+  }
+
+  // a full node only takes the point in place of its last overflow point
+  if (getBuildSize() >= settings->minPointsPerNode &&
+      (overflow.empty() || settings->sampling == Sampling::First ||
+       !isAhead(score, getPosition<Schema>(point), overflowScores.front(),
+                overflow.template get<attribute::Position>().front()))) {
+    insertIntoChild(point);
+    return;
+  }
+  pushOverflow(point, score);
+  recordAppend(point);
+  trimOverflow();
+}
+
+template <typename Schema>
+void OctreeNode<Schema>::trimOverflow() {
+  if (limit != Limit::None) return;
+  while (getBuildSize() > settings->minPointsPerNode && !overflow.empty()) {
+    insertIntoChild(popOverflow());
+    recordRewrite();
+  }
+}
+
+template <typename Schema>
+void OctreeNode<Schema>::pushOverflow(const Point& point, std::uint32_t score) {
+  overflow.push_back(point);
+  overflowScores.push_back(score);
+  if (settings->sampling == Sampling::First) return;
+  std::size_t idx = overflow.size() - 1;
+  while (idx > 0) {
+    const std::size_t parent = (idx - 1) / 2;
+    if (!isOverflowAhead(parent, point, score)) break;
+    moveOverflow(parent, idx);
+    idx = parent;
+  }
+  overflow.set(idx, point);
+  overflowScores[idx] = score;
+}
+
+template <typename Schema>
+typename OctreeNode<Schema>::Point OctreeNode<Schema>::popOverflow() {
+  if (settings->sampling == Sampling::First) {
+    const Point point = overflow.back();
+    overflow.pop_back();
+    overflowScores.pop_back();
+    return point;
+  }
+  const Point point = overflow.at(0);
+  const Point last = overflow.back();
+  const std::uint32_t lastScore = overflowScores.back();
+  overflow.pop_back();
+  overflowScores.pop_back();
+  if (!overflow.empty()) siftOverflowDown(0, last, lastScore);
+  return point;
+}
+
+template <typename Schema>
+void OctreeNode<Schema>::siftOverflowDown(std::size_t idx, const Point& point,
+                                          std::uint32_t score) {
+  const std::vector<glm::vec3>& positions = overflow.template get<attribute::Position>();
+  const std::size_t size = overflow.size();
+  while (2 * idx + 1 < size) {
+    std::size_t child = 2 * idx + 1;
+    if (child + 1 < size && isAhead(overflowScores[child], positions[child],
+                                    overflowScores[child + 1], positions[child + 1])) {
+      child++;
+    }
+    if (!isAhead(score, getPosition<Schema>(point), overflowScores[child], positions[child])) {
+      break;
+    }
+    moveOverflow(child, idx);
+    idx = child;
+  }
+  overflow.set(idx, point);
+  overflowScores[idx] = score;
+}
+
+template <typename Schema>
+void OctreeNode<Schema>::rescoreOverflow() {
+  overflowScores.resize(overflow.size());
+  if (settings->sampling == Sampling::First) return;
+  const std::vector<glm::vec3>& positions = overflow.template get<attribute::Position>();
+  for (std::size_t i = 0; i < positions.size(); i++) {
+    overflowScores[i] = getScore(positions[i], glm::floor(positions[i] / cellSize));
+  }
+  for (std::size_t i = positions.size() / 2; i-- > 0;) {
+    siftOverflowDown(i, overflow.at(i), overflowScores[i]);
+  }
+}
+
+template <typename Schema>
+bool OctreeNode<Schema>::isOverflowAhead(std::size_t idx, const Point& point,
+                                         std::uint32_t score) const {
+  return isAhead(overflowScores[idx], overflow.template get<attribute::Position>()[idx], score,
+                 getPosition<Schema>(point));
+}
+
+template <typename Schema>
+void OctreeNode<Schema>::moveOverflow(std::size_t from, std::size_t to) {
+  overflow.copyPoint(from, to);
+  overflowScores[to] = overflowScores[from];
+}
+
+template <typename Schema>
+void OctreeNode<Schema>::recordAppend(const Point& point) {
+  isChanged = true;
+  if (isBuffered && isAppendOnly) {
+    pending.push_back(point);
+  }
+}
+
+template <typename Schema>
+void OctreeNode<Schema>::recordRewrite() {
+  isChanged = true;
+  isAppendOnly = false;
+  pending.clear();
+}
+
+template <typename Schema>
+std::uint32_t OctreeNode<Schema>::getScore(const glm::vec3& position,
+                                   const glm::vec3& cellCoords) const {
+  switch (settings->sampling) {
+    case Sampling::Center:
+    case Sampling::Average: {
+      const glm::vec3 offset = position - (cellCoords + 0.5f) * cellSize;
+      // non-negative floats order the same as their bit patterns
+      return floatBits(glm::dot(offset, offset));
     }
+    case Sampling::Random: {
+      std::uint64_t h = settings->samplingSeed;
+      h = mix(h ^ floatBits(position.x));
+      h = mix(h ^ floatBits(position.y));
+      h = mix(h ^ floatBits(position.z));
+      return static_cast<std::uint32_t>(h >> 32);
+    }
+    default:
+      return 0;
   }
 }
 
-unsigned int OctreeNode::getChildNodeIndex(const glm::vec3* position) const {
+// spatial hash: project the point's 3D cell position, counted from the cell
+// holding the node's min corner, into one integer. Cells are at least
+// 1/resolution of the node's diagonal, so the node spans at most
+// resolution + 1 of them along each axis; the clamp only catches rounding at
+// its faces and points inserted outside its box.
+template <typename Schema>
+int OctreeNode<Schema>::getCellHash(const glm::vec3& cellCoords) const {
+  const int span = static_cast<int>(settings->resolution) + 1;
+  const glm::ivec3 local(glm::clamp(cellCoords - gridOrigin, 0.f, static_cast<float>(span - 1)));
+  return local.x + (local.y + local.z * span) * span;
+}
+
+template <typename Schema>
+unsigned int OctreeNode<Schema>::getChildNodeIndex(const glm::vec3& position) const {
   glm::vec3 center = bbox.getCenter();
 
   // 3 bits encode the 8 octants: x -> bit 2, y -> bit 1, z -> bit 0.
   unsigned int idx = 0;
-  if (position->x > center.x) idx |= 4;
-  if (position->y > center.y) idx |= 2;
-  if (position->z > center.z) idx |= 1;
+  if (position.x > center.x) idx |= 4;
+  if (position.y > center.y) idx |= 2;
+  if (position.z > center.z) idx |= 1;
 
   return idx;
 }
 
-void OctreeNode::createChildNode(unsigned int idx) {
+template <typename Schema>
+void OctreeNode<Schema>::createChildNode(unsigned int idx) {
   glm::vec3 min = bbox.getMin();
   glm::vec3 max = bbox.getMax();
   glm::vec3 center = bbox.getCenter();
@@ -168,59 +501,228 @@ void OctreeNode::createChildNode(unsigned int idx) {
   }
 
   BoundingBox boundingBox(childMin, childMax, false);
-  children[idx] = new OctreeNode(boundingBox, depth + 1);
-  totalNodes++;
+  children[idx] = new OctreeNode(boundingBox, depth + 1, settings);
   activateChild(idx);
 }
 
-void OctreeNode::collect(const glm::mat4& modelViewMat) {
-  // get the position of the node with the model-view matrix applied to sync
-  // its CPU position with its GPU position
-  glm::vec3 bboxViewPosition = modelViewMat * glm::vec4(bbox.getCenter(), 1);
-  float distance = glm::length(bboxViewPosition);
-  screenProjectedSize =
-      view.getScreenProjectedSize(bbox.getBoundingSphereRadius(), distance);
+template <typename Schema>
+void OctreeNode<Schema>::insertIntoChild(const Point& point) {
+  unsigned int childNodeIdx = getChildNodeIndex(getPosition<Schema>(point));
+  if (!isChildActive(childNodeIdx)) {
+    createChildNode(childNodeIdx);
+  }
+  children[childNodeIdx]->insert(point);
+  hasChangedBelow = true;
+}
 
-  if (screenProjectedSize > minScreenSize && depth != 0) {
-    collectedNodes.push_back(this);
+template <typename Schema>
+typename OctreeNode<Schema>::Point OctreeNode<Schema>::getDrawnPoint(const Cell& cell) const {
+  if constexpr (hasColour) {
+    if (settings->sampling == Sampling::Average) {
+      Point point = cell.point;
+      Schema::template get<attribute::Colour>(point) =
+          glm::u8vec3(cell.colourSum / std::uint64_t(cell.count));
+      return point;
+    }
   }
+  return cell.point;
+}
+
+template <typename Schema>
+std::size_t OctreeNode<Schema>::getBuildSize() const {
+  return grid.size() + overflow.size();
+}
 
+template <typename Schema>
+std::size_t OctreeNode<Schema>::getDrawSize() const {
+  return isBuffered ? buffers.getNumPoints() : getBuildSize();
+}
+
+template <typename Schema>
+float OctreeNode<Schema>::getSpacing() const {
+  return std::max(cellSize, settings->pointSpacing);
+}
+
+template <typename Schema>
+void OctreeNode<Schema>::rebalance(unsigned int minNodeSize, unsigned int maxNodeSize) {
+  // split first, so the children it fills are balanced below
+  const bool isSplit = getBuildSize() > maxNodeSize && limit == Limit::None;
+  if (isSplit) split(maxNodeSize);
+
+  bool hasOnlyLeafChildren = activeChildren != 0;
+  std::size_t childPoints = 0;
   for (int i = 0; i < 8; i++) {
-    if (isChildActive(i) && children[i]->isBuffered) {
-      children[i]->collect(modelViewMat);
+    if (!isChildActive(i)) continue;
+    children[i]->rebalance(minNodeSize, maxNodeSize);
+    hasChangedBelow = hasChangedBelow || children[i]->isChanged || children[i]->hasChangedBelow;
+    hasOnlyLeafChildren = hasOnlyLeafChildren && children[i]->activeChildren == 0;
+    childPoints += children[i]->getBuildSize();
+  }
+
+  // after the children settled, so collapses cascade up the tree
+  if (!isSplit && hasOnlyLeafChildren && childPoints < minNodeSize &&
+      getBuildSize() + childPoints <= maxNodeSize) {
+    mergeChildren();
+  }
+}
+
+template <typename Schema>
+void OctreeNode<Schema>::split(unsigned int maxNodeSize) {
+  // the overflow is the surplus beyond the node's LOD sample, so it goes
+  // first, last points first
+  while (getBuildSize() > maxNodeSize && !overflow.empty()) {
+    insertIntoChild(popOverflow());
+  }
+  overflow.shrink_to_fit();
+  overflowScores.shrink_to_fit();
+
+  while (grid.size() > maxNodeSize) {
+    coarsenGrid();
+  }
+  recordRewrite();
+}
+
+// Doubles the cell size, keeping the point each merged cell's sampling
+// policy prefers and passing the others down to the children.
+template <typename Schema>
+void OctreeNode<Schema>::coarsenGrid() {
+  cellSize *= 2.f;
+  gridOrigin = glm::floor(bbox.getMin() / cellSize);
+
+  std::unordered_map<int, Cell> coarse;
+  coarse.reserve(grid.size() / 4);
+  for (auto& pair : grid) {
+    Cell cell = pair.second;
+    const glm::vec3& position = getPosition<Schema>(cell.point);
+    const glm::vec3 cellCoords = glm::floor(position / cellSize);
+    cell.score = getScore(position, cellCoords);
+
+    auto [entry, isNewCell] = coarse.try_emplace(getCellHash(cellCoords), cell);
+    if (isNewCell) continue;
+
+    Cell& kept = entry->second;
+    if (settings->sampling != Sampling::First &&
+        isAhead(cell.score, getPosition<Schema>(cell.point), kept.score,
+                getPosition<Schema>(kept.point))) {
+      std::swap(kept.point, cell.point);
+      std::swap(kept.score, cell.score);
+      std::swap(kept.duplicates, cell.duplicates);
+    }
+    if constexpr (hasColour) {
+      kept.colourSum += cell.colourSum;
+      kept.count += cell.count;
+    }
+    buildStats.duplicatePoints -= cell.duplicates;
+    for (std::uint32_t i = 0; i <= cell.duplicates; i++) {
+      insertIntoChild(cell.point);
     }
   }
+  grid = std::move(coarse);
+  // the overflow's scores were in the finer cells
+  rescoreOverflow();
 }
 
-void OctreeNode::draw(const glm::mat4& modelViewMat) {
-  pointDrawCount = 0;
-  collectedNodes.clear();
+template <typename Schema>
+void OctreeNode<Schema>::mergeChildren() {
+  for (int i = 0; i < 8; i++) {
+    if (!isChildActive(i)) continue;
+    OctreeNode* child = children[i];
+
+    for (const auto& pair : child->grid) {
+      overflow.push_back(getDrawnPoint(pair.second));
+    }
+    overflow.append(child->overflow);
+  }
+  rescoreOverflow();
+  deleteChildren();
+  recordRewrite();
+}
+
+template <typename Schema>
+std::vector<std::uint64_t> OctreeNode<Schema>::getSizeHistogram() const {
+  std::vector<std::uint64_t> histogram;
+  addToHistogram(histogram);
+  return histogram;
+}
+
+template <typename Schema>
+void OctreeNode<Schema>::addToHistogram(std::vector<std::uint64_t>& histogram) const {
+  // uploaded nodes may have freed their build data
+  const std::size_t size = getDrawSize();
+  std::size_t bucket = 0;
+  while ((std::size_t(2) << bucket) <= size) bucket++;
+  if (histogram.size() <= bucket) histogram.resize(bucket + 1, 0);
+  histogram[bucket]++;
+
+  for (int i = 0; i < 8; i++) {
+    if (isChildActive(i)) {
+      children[i]->addToHistogram(histogram);
+    }
+  }
+}
 
-  // the root node (LOD 0) is always drawn
-  glBindVertexArray(vao);
-  glDrawArrays(GL_POINTS, 0, buffers.getNumPoints());
-  isDrawn = true;
-  pointDrawCount += buffers.getNumPoints();
-  if (pointDrawCount >= frameBudget) return;
+template <typename Schema>
+std::size_t OctreeNode<Schema>::getBuildMemory() const {
+  std::size_t bytes = 0;
+  addBuildMemory(bytes);
+  return bytes;
+}
 
-  collect(modelViewMat);
+template <typename Schema>
+void OctreeNode<Schema>::addBuildMemory(std::size_t& bytes) const {
+  // a hash map node holds its value and a next pointer, each bucket a pointer
+  bytes += sizeof(OctreeNode) + grid.bucket_count() * sizeof(void*) +
+           grid.size() * (sizeof(std::pair<const int, Cell>) + sizeof(void*)) +
+           overflow.getCapacityBytes() + overflowScores.capacity() * sizeof(std::uint32_t) +
+           pending.getCapacityBytes();
 
-  std::sort(collectedNodes.begin(), collectedNodes.end(),
-            &compareByScreenProjectedSize);
+  for (int i = 0; i < 8; i++) {
+    if (isChildActive(i)) {
+      children[i]->addBuildMemory(bytes);
+    }
+  }
+}
 
-  for (OctreeNode* node : collectedNodes) {
-    unsigned int nodePointCount = node->buffers.getNumPoints();
-    if (pointDrawCount + nodePointCount > frameBudget) return;
+template <typename Schema>
+bool OctreeNode<Schema>::isFilteredOut(const DisplayFilter& filter) const {
+  // nodes not uploaded yet have no summary, e.g. in LODSelector::select()
+  if (!isBuffered) return false;
+  if constexpr (Schema::template has<attribute::Intensity>) {
+    if (!overlaps(summary.intensity, filter.intensity)) return true;
+  }
+  if constexpr (Schema::template has<attribute::Classification>) {
+    if (!overlaps(summary.classification, filter.classification)) return true;
+  }
+  return false;
+}
 
-    glBindVertexArray(node->vao);
-    glDrawArrays(GL_POINTS, 0, nodePointCount);
-    node->isDrawn = true;
+template <typename Schema>
+std::uint64_t OctreeNode<Schema>::submit(const DrawList& drawList,
+                                         SpacingTexture* spacing) const {
+  return submit(drawList, 0, drawList.entries.size(), spacing);
+}
 
-    pointDrawCount += nodePointCount;
+template <typename Schema>
+std::uint64_t OctreeNode<Schema>::submit(const DrawList& drawList, std::size_t begin,
+                                         std::size_t end, SpacingTexture* spacing) const {
+  if (spacing) spacing->upload(drawList.spacingTree);
+  std::uint64_t pointDrawCount = 0;
+  for (std::size_t i = begin; i < end; i++) {
+    const typename DrawList::Entry& entry = drawList.entries[i];
+    if (spacing) spacing->setNode(entry.spacingIndex, entry.node->bbox);
+    // a node re-uploaded since the list was built may hold fewer points
+    const auto count = static_cast<std::uint32_t>(
+        std::min<std::size_t>(entry.count, entry.node->buffers.getNumPoints()));
+    glBindVertexArray(entry.node->vao);
+    glDrawArrays(GL_POINTS, 0, count);
+    entry.node->isDrawn = true;
+    pointDrawCount += count;
   }
+  return pointDrawCount;
 }
 
-void OctreeNode::drawLevel(unsigned int level) {
+template <typename Schema>
+void OctreeNode<Schema>::drawLevel(unsigned int level) {
   std::queue<OctreeNode*> queue;
   queue.push(this);
 
@@ -244,30 +746,22 @@ void OctreeNode::drawLevel(unsigned int level) {
   }
 }
 
-void OctreeNode::drawDebug() {
-  if (isDrawn || depth == 0) {
-    bbox.draw();
+template <typename Schema>
+void OctreeNode<Schema>::addDebugBoxes(BoxOverlay& overlay, bool onlyDrawn) {
+  if (!onlyDrawn || isDrawn || depth == 0) {
+    overlay.add(bbox);
     isDrawn = false;
   }
 
   for (int i = 0; i < 8; i++) {
     if (isChildActive(i)) {
-      children[i]->drawDebug();
+      children[i]->addDebugBoxes(overlay, onlyDrawn);
     }
   }
 }
 
-void OctreeNode::drawDebugAll() {
-  bbox.draw();
-
-  for (int i = 0; i < 8; i++) {
-    if (isChildActive(i)) {
-      children[i]->drawDebugAll();
-    }
-  }
-}
-
-void OctreeNode::buffer() {
+template <typename Schema>
+void OctreeNode<Schema>::buffer() {
   std::queue<OctreeNode*> queue;
   queue.push(this);
 
@@ -275,7 +769,7 @@ void OctreeNode::buffer() {
     OctreeNode* current = queue.front();
     queue.pop();
 
-    bufferNode(current);
+    bufferNode(current, false);
 
     for (int i = 0; i < 8; i++) {
       if (current->isChildActive(i)) {
@@ -285,66 +779,223 @@ void OctreeNode::buffer() {
   }
 }
 
-void OctreeNode::bufferNode(OctreeNode* node) {
-  unsigned int bufferSize = node->grid.size() + node->overflowPositions.size();
-  glm::vec3* positions = new glm::vec3[bufferSize];
-  glm::u8vec3* colours = new glm::u8vec3[bufferSize];
+template <typename Schema>
+bool OctreeNode<Schema>::bufferChanged(std::uint64_t pointBudget, bool isFinal) {
+  std::uint64_t pointsUploaded = 0;
+
+  // coarsest first, so the coarse levels are refined before finer ones appear
+  std::vector<OctreeNode*> changed;
+  collectChanged(changed);
+  std::stable_sort(changed.begin(), changed.end(),
+                   [](const OctreeNode* a, const OctreeNode* b) { return a->depth < b->depth; });
+
+  for (OctreeNode* current : changed) {
+    const std::size_t numPoints = current->getBuildSize();
+    const bool hasGrown = !current->isBuffered ||
+                          numPoints >= current->buffers.getNumPoints() * reuploadGrowth;
+    const bool canAppend = current->isBuffered && current->isAppendOnly;
+    if (canAppend || isFinal || hasGrown) {
+      if (pointsUploaded >= pointBudget) return false;
+      if (canAppend) {
+        pointsUploaded += current->pending.size();
+        appendNode(current);
+      } else {
+        bufferNode(current, true);
+        pointsUploaded += current->buffers.getNumPoints();
+      }
+    }
+  }
+  if (isFinal) shrinkBuffers();
+  return true;
+}
 
-  unsigned int idx = 0;
-  for (const auto& pair : node->grid) {
-    positions[idx] = pair.second.first;
-    colours[idx] = pair.second.second;
-    idx++;
+template <typename Schema>
+bool OctreeNode<Schema>::collectChanged(std::vector<OctreeNode*>& changed) {
+  if (isChanged) changed.push_back(this);
+  if (hasChangedBelow) {
+    bool isAnyChanged = false;
+    for (int i = 0; i < 8; i++) {
+      if (isChildActive(i)) {
+        isAnyChanged = children[i]->collectChanged(changed) || isAnyChanged;
+      }
+    }
+    hasChangedBelow = isAnyChanged;
   }
-  node->grid.clear();
+  return isChanged || hasChangedBelow;
+}
 
-  for (size_t i = 0; i < node->overflowPositions.size(); i++) {
-    positions[idx] = node->overflowPositions[i];
-    colours[idx] = node->overflowColours[i];
-    idx++;
+template <typename Schema>
+void OctreeNode<Schema>::shrinkBuffers() {
+  if (buffers.getCapacity() > buffers.getNumPoints()) {
+    glBindVertexArray(vao);
+    buffers.shrinkToFit();
   }
-  node->overflowPositions.clear();
-  node->overflowColours.clear();
+  for (int i = 0; i < 8; i++) {
+    if (isChildActive(i)) {
+      children[i]->shrinkBuffers();
+    }
+  }
+}
 
-  node->buffers = Buffers(positions, colours, bufferSize);
+template <typename Schema>
+void OctreeNode<Schema>::releaseBuildData() {
+  grid.clear();
+  pending.clear();
+  pending.shrink_to_fit();
+  overflow.clear();
+  overflow.shrink_to_fit();
+  overflowScores.clear();
+  overflowScores.shrink_to_fit();
 
-  delete[] positions;
-  delete[] colours;
+  for (int i = 0; i < 8; i++) {
+    if (isChildActive(i)) {
+      children[i]->releaseBuildData();
+    }
+  }
+}
 
-  glGenVertexArrays(1, &node->vao);
-  glBindVertexArray(node->vao);
-  node->buffers.uploadToGPU();
-  node->isBuffered = true;
+template <typename Schema>
+std::uint64_t OctreeNode<Schema>::computeOccupancy(
+    const std::vector<glm::vec3>& positions) const {
+  constexpr unsigned int numVoxels =
+      occupancyResolution * occupancyResolution * occupancyResolution;
+  std::uint32_t counts[numVoxels] = {};
+  const glm::vec3 min = bbox.getMin();
+  const glm::vec3 dimensions = glm::max(bbox.getDimensions(), glm::vec3(settings->minNodeExtent));
+  const glm::vec3 voxelsPerUnit = float(occupancyResolution) / dimensions;
+  for (const glm::vec3& position : positions) {
+    const glm::uvec3 voxel = glm::min(glm::uvec3(glm::max((position - min) * voxelsPerUnit, 0.f)),
+                                      glm::uvec3(occupancyResolution - 1));
+    counts[(voxel.x * occupancyResolution + voxel.y) * occupancyResolution + voxel.z]++;
+  }
+
+  const float side =
+      std::min(dimensions.x, std::min(dimensions.y, dimensions.z)) / occupancyResolution;
+  const float pointSize = getSpacing() * spacingCoverage;
+  const float minPoints = (side * side) / (pointSize * pointSize);
+  std::uint64_t mask = 0;
+  for (unsigned int i = 0; i < numVoxels; i++) {
+    if (counts[i] > 0 && counts[i] >= minPoints) mask |= std::uint64_t(1) << i;
+  }
+  return mask;
 }
 
-void OctreeNode::bufferDebug() {
-  bbox.buffer();
+template <typename Schema>
+void OctreeNode<Schema>::updateOccupancy() {
+  // uploaded nodes may have freed their build data
+  if (!isBuffered) {
+    std::vector<glm::vec3> positions = overflow.template get<attribute::Position>();
+    for (const auto& pair : grid) {
+      positions.push_back(Schema::template get<attribute::Position>(pair.second.point));
+    }
+    occupancy = computeOccupancy(positions);
+  }
 
   for (int i = 0; i < 8; i++) {
     if (isChildActive(i)) {
-      children[i]->bufferDebug();
+      children[i]->updateOccupancy();
     }
   }
 }
 
+template <typename Schema>
+void OctreeNode<Schema>::bufferNode(OctreeNode* node, bool keepData) {
+  Columns points;
+  points.reserve(node->getBuildSize());
+  for (const auto& pair : node->grid) {
+    points.push_back(node->getDrawnPoint(pair.second));
+  }
+  points.append(node->overflow);
+
+  if (!keepData) {
+    node->grid.clear();
+    node->overflow.clear();
+    node->overflowScores.clear();
+  }
+
+  // refills the node's existing VBOs when it was uploaded before
+  if (node->vao == 0) glGenVertexArrays(1, &node->vao);
+  glBindVertexArray(node->vao);
+  node->buffers.upload(points);
+  node->summary = AttributeSummary();
+  summarise<Schema>(points, node->summary);
+  node->occupancy = node->computeOccupancy(points.template get<attribute::Position>());
+  node->isBuffered = true;
+  node->isChanged = false;
+  node->isAppendOnly = true;
+  node->pending.clear();
+}
+
+template <typename Schema>
+void OctreeNode<Schema>::appendNode(OctreeNode* node) {
+  glBindVertexArray(node->vao);
+  node->buffers.append(node->pending);
+  summarise<Schema>(node->pending, node->summary);
+  // voxels filled by the appended points alone; the counts of earlier
+  // uploads are not kept
+  node->occupancy |= node->computeOccupancy(node->pending.template get<attribute::Position>());
+  node->pending.clear();
+  node->isChanged = false;
+}
+
 /* static members & methods */
 
-View OctreeNode::view;
-unsigned int OctreeNode::totalNodes = 1;
-unsigned int OctreeNode::maxDepth = 0;
-unsigned int OctreeNode::pointDrawCount = 0;
-unsigned int OctreeNode::frameBudget = 0;
-unsigned int OctreeNode::minPointsPerNode = 0;
-std::vector<OctreeNode*> OctreeNode::collectedNodes;
+template <typename Schema>
+const BoundingBox& OctreeNode<Schema>::getBoundingBox() const {
+  return bbox;
+}
 
-unsigned int OctreeNode::getTotalNodes() {
-  return totalNodes;
+template <typename Schema>
+std::uint64_t OctreeNode<Schema>::getNodeCount() const {
+  std::uint64_t count = 1;
+  for (int i = 0; i < 8; i++) {
+    if (isChildActive(i)) count += children[i]->getNodeCount();
+  }
+  return count;
 }
 
-unsigned int OctreeNode::getMaxDepth() {
+template <typename Schema>
+unsigned int OctreeNode<Schema>::getMaxDepth() const {
+  unsigned int maxDepth = depth;
+  for (int i = 0; i < 8; i++) {
+    if (isChildActive(i)) maxDepth = std::max(maxDepth, children[i]->getMaxDepth());
+  }
   return maxDepth;
 }
 
-unsigned int OctreeNode::getPointDrawCount() {
-  return pointDrawCount;
+OctreeNodeBase::BuildCounters OctreeNodeBase::buildStats;
+
+std::shared_ptr<const OctreeNodeBase::BuildSettings> OctreeNodeBase::configure(
+    const BoundingBox& bbox, unsigned int minPointsPerNode, unsigned int resolution,
+    Sampling sampling, std::uint64_t seed) {
+  auto settings = std::make_shared<BuildSettings>();
+  settings->minPointsPerNode = minPointsPerNode;
+  settings->resolution = resolution;
+  settings->sampling = sampling;
+  settings->samplingSeed = seed;
+  settings->pointSpacing = 0.f;
+
+  const glm::vec3 magnitude = glm::max(glm::abs(bbox.getMin()), glm::abs(bbox.getMax()));
+  const float largest = std::max(magnitude.x, std::max(magnitude.y, magnitude.z));
+  // also keeps the cell size of a root around coincident points above zero
+  settings->minNodeExtent = std::max(largest * minExtentPrecision,
+                                     std::numeric_limits<float>::min() * resolution);
+  return settings;
 }
+
+OctreeNodeBase::BuildStats OctreeNodeBase::getBuildStats() {
+  BuildStats stats;
+  stats.duplicatePoints = buildStats.duplicatePoints;
+  stats.depthLimitedPoints = buildStats.depthLimitedPoints;
+  stats.extentLimitedPoints = buildStats.extentLimitedPoints;
+  return stats;
+}
+
+void OctreeNodeBase::resetBuildStats() {
+  buildStats.duplicatePoints = 0;
+  buildStats.depthLimitedPoints = 0;
+  buildStats.extentLimitedPoints = 0;
+}
+
+#define INSTANTIATE_OCTREE_NODE(...) template class OctreeNode<PointSchema<__VA_ARGS__>>;
+POINT_SCHEMAS(INSTANTIATE_OCTREE_NODE)
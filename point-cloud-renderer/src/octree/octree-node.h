@@ -1,77 +1,327 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
 #include <glm/glm.hpp>
 
 #include <boundingbox/boundingbox.h>
-#include <buffers/buffers.h>
+#include <box-overlay/box-overlay.h>
+#include <point-buffers/point-buffers.h>
 #include <point-cloud/point-cloud.h>
-#include <view/view.h>
+#include <point-schema/point-schema.h>
+#include <spacing-texture/spacing-texture.h>
 
-class OctreeNode {
+template <typename Schema>
+class LODSelector;
+
+// The build settings and statistics shared by octrees of every schema.
+class OctreeNodeBase {
+ public:
+  // How a grid cell picks the point that represents it at the node's level;
+  // the others move down to the overflow or the children. All but First
+  // build the same tree whatever order the points arrive in, taking points
+  // at one position as copies of one point.
+  enum class Sampling {
+    First,    // the first point to reach the cell
+    Center,   // the point closest to the cell's center
+    Average,  // as Center, drawn with the mean colour of the cell's points
+    Random,   // the point with the lowest seeded hash of its position
+  };
+
+  // each node's grid has `resolution` cells along the diagonal of its
+  // bounding box
+  static constexpr unsigned int defaultResolution = 256;
+
+  // Only points whose attributes are in these ranges are drawn; an unset
+  // range, or one the schema has no column for, lets every point through.
+  struct DisplayFilter {
+    std::optional<glm::vec2> intensity;
+    std::optional<glm::vec2> classification;
+  };
+
+  // the range of each filterable attribute over a node's uploaded points,
+  // so nodes the display filter excludes entirely are never drawn
+  struct AttributeSummary {
+    glm::vec2 intensity = glm::vec2(std::numeric_limits<float>::max(),
+                                    std::numeric_limits<float>::lowest());
+    glm::vec2 classification = glm::vec2(std::numeric_limits<float>::max(),
+                                         std::numeric_limits<float>::lowest());
+  };
+
+  static std::optional<Sampling> parseSampling(const std::string& name);
+  static const char* getSamplingName(Sampling sampling);
+
+  // points affected by the build limits since the last resetBuildStats(),
+  // over every tree built since
+  struct BuildStats {
+    std::uint64_t duplicatePoints = 0;      // dropped, same position as their cell's point
+    std::uint64_t depthLimitedPoints = 0;   // kept past minPointsPerNode at depthLimit
+    std::uint64_t extentLimitedPoints = 0;  // kept past minPointsPerNode in too small a node
+  };
+
+  // a snapshot, safe to take while trees are built on other threads
+  static BuildStats getBuildStats();
+  static void resetBuildStats();
+
+ protected:
+  static constexpr unsigned int initialDepth = 0;
+  static constexpr float reuploadGrowth = 1.5f;
+  // Nodes at depthLimit, or whose children would be narrower than
+  // minNodeExtent, stop splitting and keep extra points in a growing bucket.
+  // Coincident clusters would otherwise split until float precision runs out.
+  static constexpr unsigned int depthLimit = 21;
+  // node extent, relative to the largest coordinate, below which the grid's
+  // cells are only a few float steps wide
+  static constexpr float minExtentPrecision = 1.f / 16384;
+
+  enum class Limit : unsigned char {
+    None,
+    Depth,
+    Extent,
+  };
+
+  // the settings of one tree, which all its nodes share
+  struct BuildSettings {
+    unsigned int minPointsPerNode;
+    unsigned int resolution;
+    float minNodeExtent;
+    Sampling sampling;
+    std::uint64_t samplingSeed;
+    // the cloud's point spacing, see PointCloud::getSpacing(); 0 if unknown
+    float pointSpacing;
+  };
+
+  // the settings from createRoot()'s arguments
+  static std::shared_ptr<const BuildSettings> configure(const BoundingBox& bbox,
+                                                        unsigned int minPointsPerNode,
+                                                        unsigned int resolution,
+                                                        Sampling sampling, std::uint64_t seed);
+
+  // BuildStats' counters, which builder threads add to while others read
+  struct BuildCounters {
+    std::atomic<std::uint64_t> duplicatePoints{0};
+    std::atomic<std::uint64_t> depthLimitedPoints{0};
+    std::atomic<std::uint64_t> extentLimitedPoints{0};
+  };
+  static BuildCounters buildStats;
+};
+
+// An octree node storing its points in the layout of `Schema`, see
+// PointSchema. The octree code is compiled once per schema in POINT_SCHEMAS.
+template <typename Schema>
+class OctreeNode : public OctreeNodeBase {
  public:
+  using Point = typename Schema::Point;
+  using Columns = typename Schema::Columns;
+
+  // the nodes an LODSelector picked, in drawing order, with the points of
+  // each uploaded when it was picked
+  struct DrawList {
+    struct Entry {
+      const OctreeNode* node;
+      std::uint32_t count;  // points drawn, clamped to what one draw call takes
+      std::uint32_t spacingIndex = 0;  // of the node in spacingTree
+    };
+    std::vector<Entry> entries;
+    std::uint64_t points = 0;
+    // The picked nodes and their ancestors, breadth first, with the
+    // children of each listed together in octant order. x holds the mask of
+    // a node's listed children and, above its 8 bits, the index of the
+    // first; y the bits of its point spacing, its grid's cell size, or 0
+    // if it is not drawn.
+    std::vector<glm::uvec2> spacingTree;
+  };
+
   OctreeNode();
   ~OctreeNode();
 
   OctreeNode(OctreeNode&& other) noexcept;
 
+  // `pointCloud` must hold, or stream, every attribute of the schema
   static OctreeNode buildOctree(const PointCloud& pointCloud,
-                                unsigned int pointBudget,
                                 unsigned int minPointsPerNode,
-                                const View& view);
+                                unsigned int resolution,
+                                Sampling sampling, std::uint64_t seed);
+  // Empty root for inserting points into later, e.g. by a BuildPipeline.
+  // Each tree has its own build settings, so trees can be built at once on
+  // separate threads.
+  static OctreeNode createRoot(const BoundingBox& bbox,
+                               unsigned int minPointsPerNode,
+                               unsigned int resolution,
+                               Sampling sampling, std::uint64_t seed);
+
+  const BoundingBox& getBoundingBox() const;
+  // nodes in the tree below and including this one, and its deepest depth
+  std::uint64_t getNodeCount() const;
+  unsigned int getMaxDepth() const;
 
-  static unsigned int getTotalNodes();
-  static unsigned int getMaxDepth();
-  static unsigned int getPointDrawCount();
+  // Post-build pass over a tree that still holds its build data. Splits nodes
+  // holding more than `maxNodeSize` points, moving their overflow and then a
+  // coarser grid's surplus down, and collapses sibling leaves holding fewer
+  // than `minNodeSize` points between them into their parent. Nodes at a
+  // build limit are not split.
+  void rebalance(unsigned int minNodeSize, unsigned int maxNodeSize);
+  // Counts nodes by their number of points: bucket i holds nodes with
+  // [2^i, 2^(i+1)) points, and bucket 0 empty nodes too.
+  std::vector<std::uint64_t> getSizeHistogram() const;
+  // Approximate bytes held by the tree's nodes and build data, excluding
+  // the GPU buffers.
+  std::size_t getBuildMemory() const;
 
-  void insert(const glm::vec3* position, const glm::u8vec3* colour);
+  void insert(const Point& point);
   void buffer();
-  void draw(const glm::mat4& modelViewMat);
+  // Uploads nodes whose points changed since their last upload, coarsest
+  // first, keeping their CPU copies so they can keep growing. Nodes that only
+  // gained points since then have just those appended to their buffers.
+  // Other changes rewrite the whole node, which until `isFinal` waits for it
+  // to grow by reuploadGrowth, so the total upload stays a small multiple of
+  // the final size. The `isFinal` pass also trims the spare buffer capacity
+  // appends leave. Stops once about `pointBudget` points were uploaded;
+  // returns false if changed nodes remain.
+  bool bufferChanged(std::uint64_t pointBudget, bool isFinal);
+  // frees the CPU copies kept by bufferChanged() once no more points arrive
+  void releaseBuildData();
+  // Sets the occupancy masks occlusion culling draws nodes with from the
+  // build data of the nodes not uploaded, for headless selections; uploads
+  // set them otherwise.
+  void updateOccupancy();
+  // Draws the nodes of `drawList`, which must have been picked from this
+  // tree, and returns the number of points drawn. `spacing`, if given, gets
+  // the list's spacing tree and each node's place in it.
+  std::uint64_t submit(const DrawList& drawList, SpacingTexture* spacing) const;
+  // draws the entries of `drawList` in [begin, end) only
+  std::uint64_t submit(const DrawList& drawList, std::size_t begin, std::size_t end,
+                       SpacingTexture* spacing) const;
   void drawLevel(unsigned int level);
-  void bufferDebug();
-  void drawDebug();
-  void drawDebugAll();
+  // Adds the boxes of the nodes drawn since the last call or, unless
+  // `onlyDrawn`, of every node to `overlay`.
+  void addDebugBoxes(BoxOverlay& overlay, bool onlyDrawn);
 
  private:
-  static constexpr unsigned int initialDepth = 0;
-  static constexpr unsigned int resolution = 256;
-  static constexpr float minScreenSize = 1.f;
+  friend class LODSelector<Schema>;
 
-  Buffers buffers;
+  static constexpr bool hasColour = Schema::template has<attribute::Colour>;
+
+  // voxels along each axis of a node's box in its occupancy mask
+  static constexpr unsigned int occupancyResolution = 4;
+  // how much wider than their spacing adaptive points are drawn, as in
+  // shaders/vertex.glsl
+  static constexpr float spacingCoverage = 1.5f;
+
+  // Average: colours of every point that reached the cell, only kept by
+  // schemas with colour
+  template <bool HasColour, typename Dummy = void>
+  struct CellColour {};
+  template <typename Dummy>
+  struct CellColour<true, Dummy> {
+    glm::u64vec3 colourSum;
+    std::uint32_t count;
+  };
+
+  struct Cell : CellColour<hasColour> {
+    Point point;
+    std::uint32_t score;  // lower wins the cell, ties go to the lower position
+    // copies of the point dropped while it held the cell, passed on with it
+    // if it loses the cell
+    std::uint32_t duplicates;
+  };
+
+  PointBuffers<Schema> buffers;
   BoundingBox bbox;
   OctreeNode* children[8];
   unsigned char activeChildren;  // bitmask: 1 bit per octant
   unsigned int depth;
-  std::vector<glm::vec3> overflowPositions;
-  std::vector<glm::u8vec3> overflowColours;
-  std::unordered_map<int, std::pair<glm::vec3, glm::u8vec3>> grid;
+  Limit limit;  // why this node never splits, if it doesn't
+  std::shared_ptr<const BuildSettings> settings;  // of the node's tree
+  // Points that lost their cells kept at the node's level, a max-heap of
+  // their scores in the node's cells, ties going to the higher position, so
+  // the last of them is first. Up to minPointsPerNode points in all, those
+  // ahead stay and the others move down, whatever order they came in. First
+  // sampling depends on the order anyway, so its overflow is a plain stack.
+  Columns overflow;
+  std::vector<std::uint32_t> overflowScores;
+  std::unordered_map<int, Cell> grid;
   float cellSize;
-  float screenProjectedSize;
+  glm::vec3 gridOrigin;  // cell coordinates of the cell holding bbox's min corner
   bool isBuffered;
-  bool isDrawn;
+  // set by the draws since the last addDebugBoxes(), which clears it
+  mutable bool isDrawn;
+  bool isChanged;  // points inserted since the last upload
+  // nodes below may have changed since bufferChanged() last looked, so it
+  // only walks down to the nodes that did
+  bool hasChangedBelow;
+  // Every change since the last upload added points, which are kept in the
+  // pending columns so they can be appended to the node's buffers
+  bool isAppendOnly;
+  Columns pending;
+  AttributeSummary summary;
+  // the voxels of the uploaded points, or those of the build data when last
+  // updated, see computeOccupancy()
+  std::uint64_t occupancy;
 
   unsigned int vao;
 
-  static View view;
-  static unsigned int totalNodes;
-  static unsigned int maxDepth;
-  static unsigned int pointDrawCount;
-  static unsigned int frameBudget;
-  static unsigned int minPointsPerNode;
-  static std::vector<OctreeNode*> collectedNodes;
-
-  OctreeNode(BoundingBox bbox, unsigned int depth);
+  OctreeNode(BoundingBox bbox, unsigned int depth, std::shared_ptr<const BuildSettings> settings);
 
   bool isChildActive(unsigned int idx) const;
   void activateChild(unsigned int idx);
 
-  unsigned int getChildNodeIndex(const glm::vec3* position) const;
+  std::uint32_t getScore(const glm::vec3& position, const glm::vec3& cellCoords) const;
+  int getCellHash(const glm::vec3& cellCoords) const;
+  unsigned int getChildNodeIndex(const glm::vec3& position) const;
   void createChildNode(unsigned int idx);
-  void collect(const glm::mat4& modelViewMat);
-  void bufferNode(OctreeNode* node);
+  void insertIntoChild(const Point& point);
+  // keeps a point that lost its cell, scoring `score` there, in the
+  // overflow if it is ahead of what the overflow holds, or moves it down
+  void passOn(const Point& point, std::uint32_t score);
+  // moves the last overflow points down until the node is back to
+  // minPointsPerNode points, unless it is at a build limit
+  void trimOverflow();
+  void pushOverflow(const Point& point, std::uint32_t score);
+  Point popOverflow();  // the last overflow point
+  // puts `point` at `idx`, or below it if points there are ahead of it
+  void siftOverflowDown(std::size_t idx, const Point& point, std::uint32_t score);
+  // rebuilds the overflow's heap, after its points or the cell size changed
+  void rescoreOverflow();
+  // whether the overflow point at `idx` is ahead of `point`
+  bool isOverflowAhead(std::size_t idx, const Point& point, std::uint32_t score) const;
+  void moveOverflow(std::size_t from, std::size_t to);
+  // the point a cell is drawn with
+  Point getDrawnPoint(const Cell& cell) const;
+  std::size_t getBuildSize() const;  // points held in the build data
+  std::size_t getDrawSize() const;   // uploaded points, or the build data's
+  // Spacing the node's points are drawn to cover: its cell size, but no less
+  // than the cloud's own spacing, which the cells of deep nodes fall below.
+  float getSpacing() const;
+  void split(unsigned int maxNodeSize);
+  void coarsenGrid();
+  void mergeChildren();
+  void addToHistogram(std::vector<std::uint64_t>& histogram) const;
+  void addBuildMemory(std::size_t& bytes) const;
+  // whether `filter` excludes every uploaded point of the node
+  bool isFilteredOut(const DisplayFilter& filter) const;
+  // Bits of the occupancyResolution^3 voxels of the node's box that
+  // `positions` cover, bit x * 16 + y * 4 + z. Each point is drawn as a
+  // square spacingCoverage times as wide as the node's cell size, so a voxel
+  // is covered once its points add up to a face as wide as its narrowest
+  // side, whatever its size.
+  std::uint64_t computeOccupancy(const std::vector<glm::vec3>& positions) const;
+  void recordAppend(const Point& point);
+  void recordRewrite();  // a change the node's uploaded buffers can't append
+  void bufferNode(OctreeNode* node, bool keepData);
+  void appendNode(OctreeNode* node);
+  // Adds the changed nodes at or below this one to `changed`, and clears the
+  // flags of the subtrees left without any. Returns whether it added any.
+  bool collectChanged(std::vector<OctreeNode*>& changed);
+  // trims the spare capacity appends left in the buffers of the tree below
+  void shrinkBuffers();
   void deleteChildren();
-
-  static bool compareByScreenProjectedSize(OctreeNode* node1, OctreeNode* node2);
 };
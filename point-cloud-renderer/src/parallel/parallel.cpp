@@ -0,0 +1,11 @@
+#include <parallel/parallel.h>
+
+namespace parallel {
+
+  unsigned int getThreadCount() {
+    static const unsigned int threadCount =
+        std::max(1u, std::thread::hardware_concurrency());
+    return threadCount;
+  }
+
+}  // namespace parallel
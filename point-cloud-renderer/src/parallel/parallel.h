@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace parallel {
+  // below this many items per worker, spawning threads costs more than it saves
+  static constexpr std::size_t minItemsPerThread = 1 << 16;
+
+  unsigned int getThreadCount();
+
+  // Number of contiguous ranges `forEachRange` will split `count` items into.
+  inline unsigned int getRangeCount(std::size_t count) {
+    std::size_t byGrain = std::max<std::size_t>(1, count / minItemsPerThread);
+    return static_cast<unsigned int>(
+        std::min<std::size_t>(getThreadCount(), byGrain));
+  }
+
+  // Splits [0, count) into getRangeCount(count) contiguous ranges and calls
+  // fn(begin, end, rangeIdx) for each on its own thread. Blocks until all
+  // ranges are done. Ranges are in ascending order of rangeIdx.
+  template <typename Fn>
+  void forEachRange(std::size_t count, Fn&& fn) {
+    const unsigned int numRanges = getRangeCount(count);
+    if (numRanges <= 1) {
+      fn(std::size_t(0), count, 0u);
+      return;
+    }
+
+    const std::size_t rangeSize = (count + numRanges - 1) / numRanges;
+    std::vector<std::thread> workers;
+    workers.reserve(numRanges - 1);
+
+    for (unsigned int i = 1; i < numRanges; i++) {
+      std::size_t begin = std::min(count, i * rangeSize);
+      std::size_t end = std::min(count, begin + rangeSize);
+      workers.emplace_back([&fn, begin, end, i]() { fn(begin, end, i); });
+    }
+    // the calling thread takes the first range
+    fn(std::size_t(0), std::min(count, rangeSize), 0u);
+
+    for (std::thread& worker : workers) {
+      worker.join();
+    }
+  }
+
+  // Calls fn(idx) for every idx in [0, count) on up to getThreadCount()
+  // threads, each taking the next index once it is done with one, for a few
+  // items of uneven cost such as files. Blocks until all are done.
+  template <typename Fn>
+  void forEachItem(std::size_t count, Fn&& fn) {
+    const unsigned int numThreads =
+        static_cast<unsigned int>(std::min<std::size_t>(getThreadCount(), count));
+    std::atomic<std::size_t> next(0);
+    auto work = [&fn, &next, count]() {
+      for (std::size_t idx = next++; idx < count; idx = next++) {
+        fn(idx);
+      }
+    };
+    if (numThreads <= 1) {
+      work();
+      return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(numThreads - 1);
+    for (unsigned int i = 1; i < numThreads; i++) {
+      workers.emplace_back(work);
+    }
+    work();
+
+    for (std::thread& worker : workers) {
+      worker.join();
+    }
+  }
+
+  // Fixed-capacity FIFO handing work from one pipeline stage to the next.
+  // push() blocks while the queue is full, so a fast producer cannot run
+  // further ahead of its consumer than `capacity` items.
+  template <typename T>
+  class BoundedQueue {
+   public:
+    explicit BoundedQueue(std::size_t capacity)
+        : capacity(std::max<std::size_t>(1, capacity)), closed(false) {
+    }
+
+    // returns false, dropping `item`, if the queue has been closed
+    bool push(T item) {
+      std::unique_lock<std::mutex> lock(mutex);
+      notFull.wait(lock, [this]() { return items.size() < capacity || closed; });
+      if (closed) return false;
+      items.push_back(std::move(item));
+      notEmpty.notify_one();
+      return true;
+    }
+
+    // blocks for the next item; returns false once closed and drained
+    bool pop(T& item) {
+      std::unique_lock<std::mutex> lock(mutex);
+      notEmpty.wait(lock, [this]() { return !items.empty() || closed; });
+      if (items.empty()) return false;
+      item = std::move(items.front());
+      items.pop_front();
+      notFull.notify_one();
+      return true;
+    }
+
+    // wakes every waiter; queued items can still be popped
+    void close() {
+      std::lock_guard<std::mutex> lock(mutex);
+      closed = true;
+      notFull.notify_all();
+      notEmpty.notify_all();
+    }
+
+   private:
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+    std::deque<T> items;
+    const std::size_t capacity;
+    bool closed;
+  };
+
+  // Hands the latest value from one producer thread to one consumer thread
+  // without locks. Each side owns one of three slots; publishing or taking
+  // swaps that slot with the shared middle one in a single atomic exchange.
+  // The consumer only sees the newest value, skipping any it did not take
+  // in time, and neither side ever waits for the other.
+  template <typename T>
+  class TripleBuffer {
+   public:
+    TripleBuffer() : back(0), middle(1), front(2) {
+    }
+
+    // producer: the slot to fill before publish(), holding a stale value
+    T& getBack() { return slots[back]; }
+    void publish() {
+      back = middle.exchange(back | freshBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // whether a value was published since the consumer last took one
+    bool hasFresh() const { return (middle.load(std::memory_order_acquire) & freshBit) != 0; }
+    // consumer: moves the newest value to the front if there is one; returns
+    // false, keeping the front as it is, if none was published since
+    bool take() {
+      if (!hasFresh()) return false;
+      front = middle.exchange(front, std::memory_order_acq_rel) & indexMask;
+      return true;
+    }
+    T& getFront() { return slots[front]; }
+
+   private:
+    static constexpr unsigned int indexMask = 3;
+    static constexpr unsigned int freshBit = 4;
+
+    std::array<T, 3> slots;
+    unsigned int back;
+    std::atomic<unsigned int> middle;  // slot index, with freshBit once published
+    unsigned int front;
+  };
+}
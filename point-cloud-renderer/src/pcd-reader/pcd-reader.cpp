@@ -0,0 +1,833 @@
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+
+#include <lzf/lzf.h>
+#include <parallel/parallel.h>
+#include <pcd-reader/pcd-reader.h>
+
+namespace {
+
+  template <typename T>
+  T load(const unsigned char* src) {
+    T value;
+    std::memcpy(&value, src, sizeof(T));
+    return value;
+  }
+
+  double decodeScalar(const unsigned char* src, const PCDReader::Field& field) {
+    switch (field.type) {
+      case 'F':
+        return field.size == 8 ? load<double>(src) : load<float>(src);
+      case 'U':
+        switch (field.size) {
+          case 1: return load<std::uint8_t>(src);
+          case 2: return load<std::uint16_t>(src);
+          case 4: return load<std::uint32_t>(src);
+          default: return static_cast<double>(load<std::uint64_t>(src));
+        }
+      default:
+        switch (field.size) {
+          case 1: return load<std::int8_t>(src);
+          case 2: return load<std::int16_t>(src);
+          case 4: return load<std::int32_t>(src);
+          default: return static_cast<double>(load<std::int64_t>(src));
+        }
+    }
+  }
+
+  // PCL packs colour as 0x00RRGGBB (rgb, usually stored in a float) or
+  // 0xAARRGGBB (rgba, stored as an unsigned int). Both are 4 raw bytes.
+  glm::u8vec3 unpackColour(std::uint32_t packed) {
+    return glm::u8vec3((packed >> 16) & 0xff, (packed >> 8) & 0xff, packed & 0xff);
+  }
+
+  // The load-time filter along with the fields its attribute checks read.
+  struct RowFilter {
+    const PointFilter* filter;
+    const PCDReader::Field* intensityField;
+    const PCDReader::Field* classificationField;
+  };
+
+  // Fields of the attributes decodeRange() decodes besides position and
+  // colour, nullptr for those it skips, and the arrays it writes them to.
+  struct AttributeFields {
+    const PCDReader::Field* intensity = nullptr;
+    const PCDReader::Field* classification = nullptr;
+    const PCDReader::Field* normal[3] = {nullptr, nullptr, nullptr};
+  };
+  struct AttributeOutputs {
+    float* intensities = nullptr;
+    std::uint8_t* classifications = nullptr;
+    glm::i8vec3* normals = nullptr;
+  };
+
+  std::uint8_t toClassification(double value) {
+    return static_cast<std::uint8_t>(std::clamp(value, 0.0, 255.0));
+  }
+
+  glm::i8vec3 toNormal(double x, double y, double z) {
+    auto component = [](double value) {
+      return static_cast<std::int8_t>(std::lround(std::clamp(value, -1.0, 1.0) * 127.0));
+    };
+    return glm::i8vec3(component(x), component(y), component(z));
+  }
+
+  // Decodes rows [begin, end) into the output arrays, whose first entry
+  // corresponds to row `begin`, dropping rows with a NaN coordinate and rows
+  // the filter rejects. Since a range only ever writes at or behind its read
+  // position, ranges of one array can be decoded concurrently in place.
+  // `firstRow` is the file row of index 0. Returns the number of rows kept.
+  template <typename FieldPtrFn>
+  std::size_t decodeRange(std::size_t begin, std::size_t end, std::size_t firstRow,
+                          const PCDReader::Field* posFields[3],
+                          const PCDReader::Field* colourField,
+                          const RowFilter& rowFilter,
+                          FieldPtrFn fieldPtr,
+                          glm::vec3* positions, glm::u8vec3* colours,
+                          const AttributeFields& attributeFields = {},
+                          const AttributeOutputs& outputs = {}) {
+    const PointFilter* filter = rowFilter.filter;
+    auto scalar = [&fieldPtr](std::size_t i, const PCDReader::Field* field) {
+      return field ? decodeScalar(fieldPtr(i, *field), *field) : 0.0;
+    };
+
+    std::size_t out = 0;
+    for (std::size_t i = begin; i < end; i++) {
+      if (filter && !filter->acceptsRow(firstRow + i)) continue;
+
+      glm::vec3 position(
+          static_cast<float>(decodeScalar(fieldPtr(i, *posFields[0]), *posFields[0])),
+          static_cast<float>(decodeScalar(fieldPtr(i, *posFields[1]), *posFields[1])),
+          static_cast<float>(decodeScalar(fieldPtr(i, *posFields[2]), *posFields[2])));
+
+      if (std::isnan(position.x) || std::isnan(position.y) || std::isnan(position.z)) {
+        continue;
+      }
+      auto intensity = [&]() {
+        return static_cast<float>(scalar(i, rowFilter.intensityField));
+      };
+      auto classification = [&]() {
+        return static_cast<int>(scalar(i, rowFilter.classificationField));
+      };
+      if (filter && !filter->accepts(position, intensity, classification)) continue;
+
+      positions[out] = position;
+      if (colourField) {
+        colours[out] = unpackColour(load<std::uint32_t>(fieldPtr(i, *colourField)));
+      }
+      if (attributeFields.intensity) {
+        outputs.intensities[out] = static_cast<float>(scalar(i, attributeFields.intensity));
+      }
+      if (attributeFields.classification) {
+        outputs.classifications[out] = toClassification(scalar(i, attributeFields.classification));
+      }
+      if (attributeFields.normal[0]) {
+        outputs.normals[out] = toNormal(scalar(i, attributeFields.normal[0]),
+                                        scalar(i, attributeFields.normal[1]),
+                                        scalar(i, attributeFields.normal[2]));
+      }
+      out++;
+    }
+    return out;
+  }
+
+  // Locates a field of a row in interleaved binary data.
+  struct RowFieldPtr {
+    const unsigned char* base;
+    std::size_t rowSize;
+
+    const unsigned char* operator()(std::size_t row, const PCDReader::Field& field) const {
+      return base + row * rowSize + field.offset;
+    }
+  };
+
+  // Locates a field of a row in field-major (decompressed) data.
+  struct BlockFieldPtr {
+    const unsigned char* base;
+    const PCDReader::Field* firstField;
+    const std::size_t* blockOffsets;
+
+    const unsigned char* operator()(std::size_t row, const PCDReader::Field& field) const {
+      return base + blockOffsets[&field - firstField] +
+             row * static_cast<std::size_t>(field.size) * field.count;
+    }
+  };
+
+  // Closes the gaps left between ranges by decodeRange. Returns the total
+  // number of points kept.
+  std::size_t compactRanges(const std::vector<std::size_t>& rangeBegins,
+                            const std::vector<std::size_t>& rangeCounts,
+                            glm::vec3* positions, glm::u8vec3* colours,
+                            bool hasColours) {
+    std::size_t total = 0;
+    for (std::size_t r = 0; r < rangeBegins.size(); r++) {
+      if (rangeBegins[r] != total) {
+        std::memmove(positions + total, positions + rangeBegins[r],
+                     rangeCounts[r] * sizeof(glm::vec3));
+        if (hasColours) {
+          std::memmove(colours + total, colours + rangeBegins[r],
+                       rangeCounts[r] * sizeof(glm::u8vec3));
+        }
+      }
+      total += rangeCounts[r];
+    }
+    return total;
+  }
+
+  // Parses a whole header value as an unsigned integer. Unlike std::stoul, a
+  // malformed value is reported rather than thrown.
+  template <typename T>
+  bool parseUnsigned(const std::string& token, T* value) {
+    const char* end = token.data() + token.size();
+    const auto [ptr, ec] = std::from_chars(token.data(), end, *value);
+    return ec == std::errc() && ptr == end;
+  }
+
+  // Parses one whitespace separated ascii value for `field`. Packed colours are
+  // written by PCL as the integer value of the packed bits, but older writers
+  // print the float the bits were stored in, so both forms are accepted.
+  const char* parseASCIIValue(const char* src, const PCDReader::Field& field,
+                              bool isColour, double* value,
+                              std::uint32_t* packedColour) {
+    char* end = nullptr;
+    if (!isColour) {
+      *value = std::strtod(src, &end);
+      return end;
+    }
+
+    const char* tokenEnd = src;
+    while (*tokenEnd == ' ' || *tokenEnd == '\t') tokenEnd++;
+    const char* tokenStart = tokenEnd;
+    bool isInteger = true;
+    while (*tokenEnd && !std::isspace(static_cast<unsigned char>(*tokenEnd))) {
+      if (*tokenEnd == '.' || *tokenEnd == 'e' || *tokenEnd == 'E' ||
+          *tokenEnd == 'n' || *tokenEnd == 'N') {
+        isInteger = false;
+      }
+      tokenEnd++;
+    }
+
+    if (isInteger || field.type != 'F') {
+      *packedColour = static_cast<std::uint32_t>(std::strtoull(tokenStart, &end, 10));
+    } else {
+      float bits = std::strtof(tokenStart, &end);
+      std::memcpy(packedColour, &bits, sizeof(bits));
+    }
+    return end;
+  }
+
+}  // namespace
+
+PCDReader::PCDReader(const std::string& filepath)
+    : filepath(filepath),
+      isValid(false),
+      dataFormat(DataFormat::ASCII),
+      rowSize(0),
+      numPoints(0),
+      width(0),
+      height(1),
+      dataOffset(0),
+      posFields{noField, noField, noField},
+      colourField(noField),
+      intensityField(noField),
+      classificationField(noField),
+      normalFields{noField, noField, noField},
+      rowsStreamed(0) {
+  std::ifstream file(filepath, std::ios::binary);
+  if (!file.is_open()) {
+    fail("Failed to open " + filepath);
+    return;
+  }
+  isValid = parseHeader(file);
+}
+
+bool PCDReader::valid() const {
+  return isValid;
+}
+
+const std::string& PCDReader::getError() const {
+  return error;
+}
+
+PCDReader::DataFormat PCDReader::getDataFormat() const {
+  return dataFormat;
+}
+
+const char* PCDReader::getDataFormatName() const {
+  switch (dataFormat) {
+    case DataFormat::ASCII:
+      return "ascii";
+    case DataFormat::Binary:
+      return "binary";
+    default:
+      return "binary_compressed";
+  }
+}
+
+std::size_t PCDReader::getNumPoints() const {
+  return numPoints;
+}
+
+unsigned int PCDReader::getWidth() const {
+  return width;
+}
+
+unsigned int PCDReader::getHeight() const {
+  return height;
+}
+
+bool PCDReader::isOrganized() const {
+  return height > 1;
+}
+
+bool PCDReader::hasColours() const {
+  return colourField != noField;
+}
+
+bool PCDReader::hasIntensities() const {
+  return intensityField != noField;
+}
+
+bool PCDReader::hasClassifications() const {
+  return classificationField != noField;
+}
+
+bool PCDReader::hasNormals() const {
+  return normalFields[0] != noField && normalFields[1] != noField && normalFields[2] != noField;
+}
+
+bool PCDReader::fail(const std::string& message) {
+  error = message;
+  isValid = false;
+  return false;
+}
+
+bool PCDReader::parseHeader(std::ifstream& file) {
+  std::vector<std::string> sizes;
+  std::vector<std::string> types;
+  std::vector<std::string> counts;
+  bool hasPoints = false;
+  std::string line;
+
+  while (std::getline(file, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.empty() || line[0] == '#') continue;
+
+    std::istringstream tokens(line);
+    std::string keyword;
+    tokens >> keyword;
+
+    std::vector<std::string> values;
+    for (std::string value; tokens >> value;) {
+      values.push_back(value);
+    }
+
+    if (keyword == "FIELDS") {
+      for (const std::string& name : values) {
+        Field field;
+        field.name = name;
+        fields.push_back(field);
+      }
+    } else if (keyword == "SIZE") {
+      sizes = values;
+    } else if (keyword == "TYPE") {
+      types = values;
+    } else if (keyword == "COUNT") {
+      counts = values;
+    } else if (keyword == "WIDTH" && !values.empty()) {
+      if (!parseUnsigned(values[0], &width)) {
+        return fail("Invalid WIDTH '" + values[0] + "' in PCD header");
+      }
+    } else if (keyword == "HEIGHT" && !values.empty()) {
+      if (!parseUnsigned(values[0], &height)) {
+        return fail("Invalid HEIGHT '" + values[0] + "' in PCD header");
+      }
+    } else if (keyword == "POINTS" && !values.empty()) {
+      if (!parseUnsigned(values[0], &numPoints)) {
+        return fail("Invalid POINTS '" + values[0] + "' in PCD header");
+      }
+      hasPoints = true;
+    } else if (keyword == "DATA" && !values.empty()) {
+      if (values[0] == "ascii") {
+        dataFormat = DataFormat::ASCII;
+      } else if (values[0] == "binary") {
+        dataFormat = DataFormat::Binary;
+      } else if (values[0] == "binary_compressed") {
+        dataFormat = DataFormat::BinaryCompressed;
+      } else {
+        return fail("Unsupported PCD data format '" + values[0] + "'");
+      }
+      dataOffset = file.tellg();
+      break;
+    }
+    // VERSION and VIEWPOINT do not affect decoding
+  }
+
+  if (dataOffset <= 0) {
+    return fail("No DATA line found in PCD header");
+  }
+  if (fields.empty() || sizes.size() != fields.size() || types.size() != fields.size() ||
+      (!counts.empty() && counts.size() != fields.size())) {
+    return fail("FIELDS, SIZE, TYPE and COUNT lengths do not match in PCD header");
+  }
+  if (!hasPoints) {
+    numPoints = static_cast<std::size_t>(width) * height;
+  }
+
+  for (std::size_t i = 0; i < fields.size(); i++) {
+    Field& field = fields[i];
+    if (!parseUnsigned(sizes[i], &field.size)) {
+      return fail("Invalid SIZE '" + sizes[i] + "' for PCD field '" + field.name + "'");
+    }
+    field.type = types[i][0];
+    if (!counts.empty() && (!parseUnsigned(counts[i], &field.count) || field.count == 0)) {
+      return fail("Invalid COUNT '" + counts[i] + "' for PCD field '" + field.name + "'");
+    }
+    field.offset = rowSize;
+    rowSize += field.size * field.count;
+
+    if ((field.type != 'F' && field.type != 'U' && field.type != 'I') ||
+        (field.size != 1 && field.size != 2 && field.size != 4 && field.size != 8) ||
+        (field.type == 'F' && field.size != 4 && field.size != 8)) {
+      return fail("Unsupported type for PCD field '" + field.name + "'");
+    }
+
+    const int idx = static_cast<int>(i);
+    if (field.name == "x") posFields[0] = idx;
+    if (field.name == "y") posFields[1] = idx;
+    if (field.name == "z") posFields[2] = idx;
+    if ((field.name == "rgb" || field.name == "rgba") && field.size == 4) {
+      colourField = idx;
+    }
+    if (field.name == "intensity") intensityField = idx;
+    if (field.name == "label" || field.name == "classification") classificationField = idx;
+    if (field.name == "normal_x") normalFields[0] = idx;
+    if (field.name == "normal_y") normalFields[1] = idx;
+    if (field.name == "normal_z") normalFields[2] = idx;
+  }
+
+  if (posFields[0] == noField || posFields[1] == noField || posFields[2] == noField) {
+    return fail("PCD file has no x, y and z fields");
+  }
+  const bool areNormalsRead = hasNormals();
+  auto isOneOf = [](int idx, const int (&indices)[3]) {
+    return std::find(std::begin(indices), std::end(indices), idx) != std::end(indices);
+  };
+  for (std::size_t i = 0; i < fields.size(); i++) {
+    const int idx = static_cast<int>(i);
+    const bool isRead = isOneOf(idx, posFields) || idx == colourField ||
+                        idx == intensityField || idx == classificationField ||
+                        (areNormalsRead && isOneOf(idx, normalFields));
+    // "_" marks PCL's padding
+    if (!isRead && fields[i].name != "_") unreadFields.push_back(fields[i].name);
+  }
+
+  // compressed data is stored field by field: all x values, then all y
+  // values, and so on, each block holding every point of the file.
+  std::size_t blockOffset = 0;
+  for (const Field& field : fields) {
+    blockOffsets.push_back(blockOffset);
+    blockOffset += static_cast<std::size_t>(field.size) * field.count * numPoints;
+  }
+
+  return true;
+}
+
+bool PCDReader::read(glm::vec3* positions, glm::u8vec3* colours,
+                     std::size_t maxPoints, std::size_t* numRead) {
+  *numRead = 0;
+  if (!isValid) return false;
+
+  std::ifstream file(filepath, std::ios::binary);
+  if (!file.is_open()) {
+    return fail("Failed to open " + filepath);
+  }
+
+  file.seekg(0, std::ios::end);
+  const std::streamoff fileSize = file.tellg();
+  file.seekg(dataOffset);
+
+  // binary data only needs the rows being read; ascii and compressed data
+  // must be scanned or decompressed from the start of the section.
+  std::size_t bytesToRead = static_cast<std::size_t>(fileSize - dataOffset);
+  const std::size_t pointsToRead = std::min(maxPoints, numPoints);
+  if (dataFormat == DataFormat::Binary) {
+    bytesToRead = std::min(bytesToRead, pointsToRead * rowSize);
+  }
+
+  // one extra zero byte terminates the ascii parser
+  std::vector<unsigned char> data(bytesToRead + 1, 0);
+  file.read(reinterpret_cast<char*>(data.data()), bytesToRead);
+  if (static_cast<std::size_t>(file.gcount()) != bytesToRead) {
+    return fail("Failed to read PCD data section");
+  }
+
+  bool ok = false;
+  switch (dataFormat) {
+    case DataFormat::ASCII:
+      ok = readASCII(data, positions, colours, pointsToRead, numRead);
+      break;
+    case DataFormat::Binary:
+      ok = readBinary(data, positions, colours, pointsToRead, numRead);
+      break;
+    case DataFormat::BinaryCompressed:
+      ok = readBinaryCompressed(data, positions, colours, pointsToRead, numRead);
+      break;
+  }
+  return ok;
+}
+
+bool PCDReader::parseASCIIRow(const char* cursor, glm::vec3* position,
+                              std::uint32_t* packedColour,
+                              RowAttributes* rowAttributes) const {
+  double coords[3] = {0.0, 0.0, 0.0};
+  double& intensity = rowAttributes->intensity;
+  double& classification = rowAttributes->classification;
+
+  for (std::size_t f = 0; f < fields.size(); f++) {
+    const int fieldIdx = static_cast<int>(f);
+    for (unsigned int c = 0; c < fields[f].count; c++) {
+      double value = 0.0;
+      cursor = parseASCIIValue(cursor, fields[f], fieldIdx == colourField,
+                               &value, packedColour);
+      if (c != 0) continue;
+      if (fieldIdx == posFields[0]) coords[0] = value;
+      if (fieldIdx == posFields[1]) coords[1] = value;
+      if (fieldIdx == posFields[2]) coords[2] = value;
+      if (fieldIdx == intensityField) intensity = value;
+      if (fieldIdx == classificationField) classification = value;
+      for (int axis = 0; axis < 3; axis++) {
+        if (fieldIdx == normalFields[axis]) rowAttributes->normal[axis] = value;
+      }
+    }
+  }
+
+  *position = glm::vec3(coords[0], coords[1], coords[2]);
+  if (std::isnan(position->x) || std::isnan(position->y) || std::isnan(position->z)) {
+    return false;
+  }
+  return !filter || filter->accepts(
+                        *position,
+                        [&intensity]() { return static_cast<float>(intensity); },
+                        [&classification]() { return static_cast<int>(classification); });
+}
+
+const PCDReader::Field* PCDReader::getField(int idx) const {
+  return idx == noField ? nullptr : &fields[idx];
+}
+
+bool PCDReader::readBinary(const std::vector<unsigned char>& data,
+                           glm::vec3* positions, glm::u8vec3* colours,
+                           std::size_t numPoints, std::size_t* numRead) {
+  if (data.size() < numPoints * rowSize) {
+    return fail("PCD binary data section is truncated");
+  }
+
+  const Field* pos[3] = {&fields[posFields[0]], &fields[posFields[1]], &fields[posFields[2]]};
+  const Field* colour = hasColours() && attributes.colours ? &fields[colourField] : nullptr;
+  const RowFilter rowFilter{filter, getField(intensityField), getField(classificationField)};
+  RowFieldPtr fieldPtr{data.data(), rowSize};
+
+  const unsigned int numRanges = parallel::getRangeCount(numPoints);
+  std::vector<std::size_t> rangeBegins(numRanges);
+  std::vector<std::size_t> rangeCounts(numRanges);
+  parallel::forEachRange(numPoints, [&](std::size_t begin, std::size_t end, unsigned int r) {
+    rangeBegins[r] = begin;
+    rangeCounts[r] = decodeRange(begin, end, 0, pos, colour, rowFilter, fieldPtr,
+                                 positions + begin, colours ? colours + begin : nullptr);
+  });
+
+  *numRead = compactRanges(rangeBegins, rangeCounts, positions, colours, colour != nullptr);
+  return true;
+}
+
+bool PCDReader::decompress(const std::vector<unsigned char>& data,
+                           std::vector<unsigned char>& decompressed) {
+  constexpr std::size_t sizesHeaderLen = 2 * sizeof(std::uint32_t);
+  if (data.size() < sizesHeaderLen) {
+    return fail("PCD compressed data section is truncated");
+  }
+
+  const std::uint32_t compressedSize = load<std::uint32_t>(data.data());
+  const std::uint32_t uncompressedSize = load<std::uint32_t>(data.data() + sizeof(std::uint32_t));
+  if (data.size() < sizesHeaderLen + compressedSize ||
+      uncompressedSize < numPoints * rowSize) {
+    return fail("PCD compressed data section is truncated");
+  }
+
+  decompressed.resize(uncompressedSize);
+  if (lzf::decompress(data.data() + sizesHeaderLen, compressedSize,
+                      decompressed.data(), uncompressedSize) != uncompressedSize) {
+    return fail("Failed to decompress PCD data section");
+  }
+  return true;
+}
+
+bool PCDReader::readBinaryCompressed(const std::vector<unsigned char>& data,
+                                     glm::vec3* positions, glm::u8vec3* colours,
+                                     std::size_t numPoints, std::size_t* numRead) {
+  std::vector<unsigned char> decompressed;
+  if (!decompress(data, decompressed)) return false;
+
+  const Field* pos[3] = {&fields[posFields[0]], &fields[posFields[1]], &fields[posFields[2]]};
+  const Field* colour = hasColours() && attributes.colours ? &fields[colourField] : nullptr;
+  const RowFilter rowFilter{filter, getField(intensityField), getField(classificationField)};
+  BlockFieldPtr fieldPtr{decompressed.data(), fields.data(), blockOffsets.data()};
+
+  const unsigned int numRanges = parallel::getRangeCount(numPoints);
+  std::vector<std::size_t> rangeBegins(numRanges);
+  std::vector<std::size_t> rangeCounts(numRanges);
+  parallel::forEachRange(numPoints, [&](std::size_t begin, std::size_t end, unsigned int r) {
+    rangeBegins[r] = begin;
+    rangeCounts[r] = decodeRange(begin, end, 0, pos, colour, rowFilter, fieldPtr,
+                                 positions + begin, colours ? colours + begin : nullptr);
+  });
+
+  *numRead = compactRanges(rangeBegins, rangeCounts, positions, colours, colour != nullptr);
+  return true;
+}
+
+bool PCDReader::readASCII(const std::vector<unsigned char>& data,
+                          glm::vec3* positions, glm::u8vec3* colours,
+                          std::size_t numPoints, std::size_t* numRead) {
+  // index the line starts serially (a memchr sweep), then parse lines in parallel
+  const char* text = reinterpret_cast<const char*>(data.data());
+  const char* textEnd = text + data.size() - 1;
+  std::vector<const char*> lines;
+  lines.reserve(numPoints);
+
+  for (const char* line = text; line < textEnd && lines.size() < numPoints;) {
+    const char* newline = static_cast<const char*>(std::memchr(line, '\n', textEnd - line));
+    const char* lineEnd = newline ? newline : textEnd;
+
+    const char* first = line;
+    while (first < lineEnd && std::isspace(static_cast<unsigned char>(*first))) first++;
+    if (first < lineEnd) lines.push_back(first);
+
+    line = lineEnd + 1;
+  }
+
+  if (lines.size() < numPoints) {
+    return fail("PCD ascii data section has fewer rows than POINTS");
+  }
+
+  const bool hasColour = hasColours() && attributes.colours;
+  const unsigned int numRanges = parallel::getRangeCount(numPoints);
+  std::vector<std::size_t> rangeBegins(numRanges);
+  std::vector<std::size_t> rangeCounts(numRanges);
+
+  parallel::forEachRange(numPoints, [&](std::size_t begin, std::size_t end, unsigned int r) {
+    std::size_t out = begin;
+    for (std::size_t i = begin; i < end; i++) {
+      if (filter && !filter->acceptsRow(i)) continue;
+
+      glm::vec3 position;
+      std::uint32_t packedColour = 0;
+      RowAttributes rowAttributes;
+      if (!parseASCIIRow(lines[i], &position, &packedColour, &rowAttributes)) continue;
+
+      positions[out] = position;
+      if (hasColour) colours[out] = unpackColour(packedColour);
+      out++;
+    }
+    rangeBegins[r] = begin;
+    rangeCounts[r] = out - begin;
+  });
+
+  *numRead = compactRanges(rangeBegins, rangeCounts, positions, colours, hasColour);
+  return true;
+}
+
+bool PCDReader::rewind() {
+  if (!isValid) return false;
+
+  stream.close();
+  stream.clear();
+  stream.open(filepath, std::ios::binary);
+  if (!stream.is_open()) {
+    return fail("Failed to open " + filepath);
+  }
+  stream.seekg(dataOffset);
+  rowsStreamed = 0;
+
+  fieldStreams.clear();
+  if (dataFormat == DataFormat::BinaryCompressed) return openFieldStreams();
+  return true;
+}
+
+bool PCDReader::openFieldStreams() {
+  constexpr std::size_t sizesHeaderLen = 2 * sizeof(std::uint32_t);
+  unsigned char sizes[sizesHeaderLen];
+  stream.read(reinterpret_cast<char*>(sizes), sizesHeaderLen);
+  if (static_cast<std::size_t>(stream.gcount()) != sizesHeaderLen) {
+    return fail("PCD compressed data section is truncated");
+  }
+  const std::uint32_t compressedSize = load<std::uint32_t>(sizes);
+  const std::uint32_t uncompressedSize = load<std::uint32_t>(sizes + sizeof(std::uint32_t));
+  if (uncompressedSize < numPoints * rowSize) {
+    return fail("PCD compressed data section is truncated");
+  }
+
+  // only the fields decodeRange() will look at are decoded
+  std::vector<int> needed(std::begin(posFields), std::end(posFields));
+  if (hasColours() && attributes.colours) needed.push_back(colourField);
+  if (intensityField != noField &&
+      (attributes.intensities || (filter && filter->needsIntensity()))) {
+    needed.push_back(intensityField);
+  }
+  if (classificationField != noField &&
+      (attributes.classifications || (filter && filter->needsClassification()))) {
+    needed.push_back(classificationField);
+  }
+  if (hasNormals() && attributes.normals) {
+    needed.insert(needed.end(), std::begin(normalFields), std::end(normalFields));
+  }
+  std::sort(needed.begin(), needed.end());
+  needed.erase(std::unique(needed.begin(), needed.end()), needed.end());
+
+  // each field's block starts deep into the section, so every field gets its
+  // own decoder, run up to the start of its block
+  for (int idx : needed) {
+    auto fieldStream = std::make_unique<FieldStream>();
+    fieldStream->field = idx;
+    fieldStream->file.open(filepath, std::ios::binary);
+    if (!fieldStream->file.is_open()) {
+      return fail("Failed to open " + filepath);
+    }
+    fieldStream->file.seekg(dataOffset + static_cast<std::streamoff>(sizesHeaderLen));
+    fieldStream->decoder =
+        std::make_unique<lzf::StreamDecoder>(fieldStream->file, compressedSize);
+    if (!fieldStream->decoder->read(nullptr, blockOffsets[idx])) {
+      return fail("Failed to decompress PCD data section");
+    }
+    fieldStreams.push_back(std::move(fieldStream));
+  }
+  return true;
+}
+
+bool PCDReader::readFieldBlocks(std::size_t numRows) {
+  streamBlocks.resize(numRows * rowSize);
+  streamBlockOffsets.resize(fields.size());
+  for (std::size_t i = 0; i < fields.size(); i++) {
+    streamBlockOffsets[i] = numRows * fields[i].offset;
+  }
+
+  for (const auto& fieldStream : fieldStreams) {
+    const Field& field = fields[fieldStream->field];
+    if (!fieldStream->decoder->read(streamBlocks.data() + streamBlockOffsets[fieldStream->field],
+                                    numRows * field.size * field.count)) {
+      return fail("Failed to decompress PCD data section");
+    }
+  }
+  return true;
+}
+
+std::size_t PCDReader::readBatch(PointBatch& batch, std::size_t maxPoints) {
+  if (!isValid) return 0;
+  if (!stream.is_open() && !rewind()) return 0;
+
+  const std::size_t numRows = std::min(maxPoints, numPoints - rowsStreamed);
+  if (numRows == 0) return 0;
+
+  const bool hasColour = hasColours() && attributes.colours;
+  const bool hasIntensity = hasIntensities() && attributes.intensities;
+  const bool hasClassification = hasClassifications() && attributes.classifications;
+  const bool hasNormal = hasNormals() && attributes.normals;
+  const std::size_t first = batch.size();
+  batch.positions.resize(first + numRows);
+  if (hasColour) batch.colours.resize(first + numRows);
+  if (hasIntensity) batch.intensities.resize(first + numRows);
+  if (hasClassification) batch.classifications.resize(first + numRows);
+  if (hasNormal) batch.normals.resize(first + numRows);
+  glm::vec3* positions = batch.positions.data() + first;
+  glm::u8vec3* colours = hasColour ? batch.colours.data() + first : nullptr;
+
+  const Field* pos[3] = {&fields[posFields[0]], &fields[posFields[1]], &fields[posFields[2]]};
+  const Field* colour = hasColour ? &fields[colourField] : nullptr;
+  const RowFilter rowFilter{filter, getField(intensityField), getField(classificationField)};
+  AttributeFields attributeFields;
+  AttributeOutputs outputs;
+  if (hasIntensity) {
+    attributeFields.intensity = &fields[intensityField];
+    outputs.intensities = batch.intensities.data() + first;
+  }
+  if (hasClassification) {
+    attributeFields.classification = &fields[classificationField];
+    outputs.classifications = batch.classifications.data() + first;
+  }
+  if (hasNormal) {
+    for (int axis = 0; axis < 3; axis++) attributeFields.normal[axis] = &fields[normalFields[axis]];
+    outputs.normals = batch.normals.data() + first;
+  }
+  std::size_t numKept = 0;
+
+  switch (dataFormat) {
+    case DataFormat::Binary: {
+      streamBuffer.resize(numRows * rowSize);
+      stream.read(reinterpret_cast<char*>(streamBuffer.data()), streamBuffer.size());
+      if (static_cast<std::size_t>(stream.gcount()) != streamBuffer.size()) {
+        fail("PCD binary data section is truncated");
+        break;
+      }
+      RowFieldPtr fieldPtr{streamBuffer.data(), rowSize};
+      numKept = decodeRange(0, numRows, rowsStreamed, pos, colour, rowFilter, fieldPtr,
+                            positions, colours, attributeFields, outputs);
+      break;
+    }
+
+    case DataFormat::BinaryCompressed: {
+      if (!readFieldBlocks(numRows)) break;
+      BlockFieldPtr fieldPtr{streamBlocks.data(), fields.data(), streamBlockOffsets.data()};
+      numKept = decodeRange(0, numRows, rowsStreamed, pos, colour, rowFilter, fieldPtr,
+                            positions, colours, attributeFields, outputs);
+      break;
+    }
+
+    case DataFormat::ASCII:
+      for (std::size_t i = 0; i < numRows;) {
+        if (!std::getline(stream, streamLine)) {
+          fail("PCD ascii data section has fewer rows than POINTS");
+          break;
+        }
+        const char* cursor = streamLine.c_str();
+        while (std::isspace(static_cast<unsigned char>(*cursor))) cursor++;
+        if (*cursor == '\0') continue;
+
+        std::uint32_t packedColour = 0;
+        RowAttributes rowAttributes;
+        if ((!filter || filter->acceptsRow(rowsStreamed + i)) &&
+            parseASCIIRow(cursor, &positions[numKept], &packedColour, &rowAttributes)) {
+          if (hasColour) colours[numKept] = unpackColour(packedColour);
+          if (hasIntensity) {
+            outputs.intensities[numKept] = static_cast<float>(rowAttributes.intensity);
+          }
+          if (hasClassification) {
+            outputs.classifications[numKept] = toClassification(rowAttributes.classification);
+          }
+          if (hasNormal) {
+            outputs.normals[numKept] = toNormal(rowAttributes.normal[0], rowAttributes.normal[1],
+                                                rowAttributes.normal[2]);
+          }
+          numKept++;
+        }
+        i++;
+      }
+      break;
+  }
+
+  batch.positions.resize(first + numKept);
+  if (hasColour) batch.colours.resize(first + numKept);
+  if (hasIntensity) batch.intensities.resize(first + numKept);
+  if (hasClassification) batch.classifications.resize(first + numKept);
+  if (hasNormal) batch.normals.resize(first + numKept);
+
+  rowsStreamed += numRows;
+  return isValid ? numRows : 0;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <lzf/lzf.h>
+#include <point-reader/point-reader.h>
+
+// Reader for Point Cloud Library (.pcd) v0.7 files. Supports the ascii,
+// binary and binary_compressed (LZF) data sections, the packed `rgb`/`rgba`
+// colour fields and organized clouds (WIDTH x HEIGHT with NaN holes).
+// Streaming a compressed section decodes only the fields being read, one
+// batch at a time, at the cost of one pass over the section per field.
+class PCDReader : public PointReader {
+ public:
+  enum class DataFormat {
+    ASCII,
+    Binary,
+    BinaryCompressed,
+  };
+
+  struct Field {
+    std::string name;
+    unsigned int size = 4;
+    char type = 'F';  // F: float, U: unsigned int, I: signed int
+    unsigned int count = 1;
+    std::size_t offset = 0;  // byte offset of the field within a binary row
+  };
+
+  explicit PCDReader(const std::string& filepath);
+
+  bool valid() const override;
+  const std::string& getError() const override;
+
+  DataFormat getDataFormat() const;
+  const char* getDataFormatName() const;
+  std::size_t getNumPoints() const override;
+  unsigned int getWidth() const;
+  unsigned int getHeight() const;
+  bool isOrganized() const;
+  bool hasColours() const override;
+  bool hasIntensities() const override;
+  bool hasClassifications() const override;
+  bool hasNormals() const override;
+
+  // Decodes the first `maxPoints` points into `positions` and `colours` (which
+  // must hold at least that many entries), splitting the work across threads.
+  // Points with a NaN coordinate, i.e. the invalid entries of organized
+  // clouds, and points rejected by the filter are skipped. `colours` is left
+  // untouched if the file has no colour field or colours were not requested;
+  // other attributes are only decoded by readBatch(). Returns false if the
+  // data section is truncated or corrupt.
+  bool read(glm::vec3* positions, glm::u8vec3* colours, std::size_t maxPoints,
+            std::size_t* numRead);
+
+  // streaming access; rows with a NaN coordinate are consumed but not returned
+  std::size_t readBatch(PointBatch& batch, std::size_t maxPoints) override;
+  bool rewind() override;
+
+ private:
+  static constexpr int noField = -1;
+
+  // decoder of one field's block of a compressed section when streaming
+  struct FieldStream {
+    int field;
+    std::ifstream file;
+    std::unique_ptr<lzf::StreamDecoder> decoder;
+  };
+
+  // values of an ascii row's attributes besides position and colour
+  struct RowAttributes {
+    double intensity = 0.0;
+    double classification = 0.0;
+    double normal[3] = {0.0, 0.0, 0.0};
+  };
+
+  const Field* getField(int idx) const;  // nullptr for noField
+
+  bool parseHeader(std::ifstream& file);
+  bool fail(const std::string& message);
+  bool parseASCIIRow(const char* cursor, glm::vec3* position,
+                     std::uint32_t* packedColour, RowAttributes* rowAttributes) const;
+  bool decompress(const std::vector<unsigned char>& data,
+                  std::vector<unsigned char>& decompressed);
+  bool openFieldStreams();
+  bool readFieldBlocks(std::size_t numRows);
+
+  bool readBinary(const std::vector<unsigned char>& data,
+                  glm::vec3* positions, glm::u8vec3* colours,
+                  std::size_t numPoints, std::size_t* numRead);
+  bool readBinaryCompressed(const std::vector<unsigned char>& data,
+                            glm::vec3* positions, glm::u8vec3* colours,
+                            std::size_t numPoints, std::size_t* numRead);
+  bool readASCII(const std::vector<unsigned char>& data,
+                 glm::vec3* positions, glm::u8vec3* colours,
+                 std::size_t numPoints, std::size_t* numRead);
+
+  std::string filepath;
+  std::string error;
+  bool isValid;
+
+  DataFormat dataFormat;
+  std::vector<Field> fields;
+  std::size_t rowSize;
+  std::size_t numPoints;
+  unsigned int width;
+  unsigned int height;
+  std::streamoff dataOffset;
+
+  std::vector<std::size_t> blockOffsets;  // per-field offsets in decompressed data
+
+  int posFields[3];
+  int colourField;
+  int intensityField;
+  int classificationField;  // "label" in PCL's own point types
+  int normalFields[3];
+
+  std::ifstream stream;
+  std::size_t rowsStreamed;
+  std::vector<unsigned char> streamBuffer;
+  std::vector<std::unique_ptr<FieldStream>> fieldStreams;
+  std::vector<unsigned char> streamBlocks;  // the batch's rows, field by field
+  std::vector<std::size_t> streamBlockOffsets;
+  std::string streamLine;
+};
@@ -0,0 +1,442 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <sstream>
+
+#include <ply-reader/ply-reader.h>
+
+namespace {
+
+  std::size_t propertySize(miniply::PLYPropertyType type) {
+    switch (type) {
+      case miniply::PLYPropertyType::Char:
+      case miniply::PLYPropertyType::UChar:
+        return 1;
+      case miniply::PLYPropertyType::Short:
+      case miniply::PLYPropertyType::UShort:
+        return 2;
+      case miniply::PLYPropertyType::Double:
+        return 8;
+      default:
+        return 4;
+    }
+  }
+
+  miniply::PLYPropertyType parsePropertyType(const std::string& name) {
+    if (name == "char" || name == "int8") return miniply::PLYPropertyType::Char;
+    if (name == "uchar" || name == "uint8") return miniply::PLYPropertyType::UChar;
+    if (name == "short" || name == "int16") return miniply::PLYPropertyType::Short;
+    if (name == "ushort" || name == "uint16") return miniply::PLYPropertyType::UShort;
+    if (name == "int" || name == "int32") return miniply::PLYPropertyType::Int;
+    if (name == "uint" || name == "uint32") return miniply::PLYPropertyType::UInt;
+    if (name == "float" || name == "float32") return miniply::PLYPropertyType::Float;
+    if (name == "double" || name == "float64") return miniply::PLYPropertyType::Double;
+    return miniply::PLYPropertyType::None;
+  }
+
+  // colours are normally uchar, but 16-bit and normalised float colours occur too
+  unsigned char toColourChannel(double value, miniply::PLYPropertyType type) {
+    switch (type) {
+      case miniply::PLYPropertyType::UShort:
+        value /= 257.0;
+        break;
+      case miniply::PLYPropertyType::Float:
+      case miniply::PLYPropertyType::Double:
+        value *= 255.0;
+        break;
+      default:
+        break;
+    }
+    return static_cast<unsigned char>(std::clamp(value, 0.0, 255.0));
+  }
+
+  // classifications are small integer codes, e.g. the ASPRS LAS classes
+  std::uint8_t toClassification(double value) {
+    return static_cast<std::uint8_t>(std::clamp(value, 0.0, 255.0));
+  }
+
+  std::int8_t toNormalComponent(double value) {
+    return static_cast<std::int8_t>(std::lround(std::clamp(value, -1.0, 1.0) * 127.0));
+  }
+
+  template <typename T>
+  T load(const unsigned char* src) {
+    T value;
+    std::memcpy(&value, src, sizeof(T));
+    return value;
+  }
+
+}  // namespace
+
+PLYStreamReader::PLYStreamReader(const std::string& filepath)
+    : filepath(filepath),
+      isValid(false),
+      fileType(miniply::PLYFileType::ASCII),
+      dataOffset(0),
+      rowsToSkip(0),
+      rowStride(0),
+      numColumns(0),
+      numPoints(0),
+      rowsRead(0),
+      hasColourProperties(false),
+      hasIntensityProperty(false),
+      hasClassificationProperty(false),
+      hasNormalProperties(false) {
+  isValid = parseHeader();
+}
+
+bool PLYStreamReader::valid() const {
+  return isValid;
+}
+
+const std::string& PLYStreamReader::getError() const {
+  return error;
+}
+
+std::size_t PLYStreamReader::getNumPoints() const {
+  return numPoints;
+}
+
+bool PLYStreamReader::hasColours() const {
+  return hasColourProperties;
+}
+
+bool PLYStreamReader::hasIntensities() const {
+  return hasIntensityProperty;
+}
+
+bool PLYStreamReader::hasClassifications() const {
+  return hasClassificationProperty;
+}
+
+bool PLYStreamReader::hasNormals() const {
+  return hasNormalProperties;
+}
+
+bool PLYStreamReader::fail(const std::string& message) {
+  error = message;
+  isValid = false;
+  return false;
+}
+
+bool PLYStreamReader::parseHeader() {
+  // miniply stores element counts in 32 bits, so the header is parsed here to
+  // support files of more than 4G points
+  struct Element {
+    std::string name;
+    std::uint64_t count = 0;
+    std::vector<std::string> propertyNames;
+    std::vector<Property> properties;
+    bool fixedSize = true;
+    std::size_t rowStride = 0;
+  };
+  std::vector<Element> elements;
+
+  file.open(filepath, std::ios::binary);
+  if (!file.is_open()) {
+    return fail("Failed to open " + filepath);
+  }
+
+  bool hasFormat = false;
+  bool hasEnd = false;
+  for (std::size_t lineIdx = 0; !hasEnd && std::getline(file, line); lineIdx++) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    std::istringstream tokens(line);
+    std::string keyword;
+    tokens >> keyword;
+
+    if (lineIdx == 0) {
+      if (keyword != "ply") return fail(filepath + " is not a PLY file");
+    } else if (keyword == "format") {
+      std::string format;
+      tokens >> format;
+      if (format == "ascii") {
+        fileType = miniply::PLYFileType::ASCII;
+      } else if (format == "binary_little_endian") {
+        fileType = miniply::PLYFileType::Binary;
+      } else if (format == "binary_big_endian") {
+        fileType = miniply::PLYFileType::BinaryBigEndian;
+      } else {
+        return fail("Unsupported PLY format '" + format + "' in " + filepath);
+      }
+      hasFormat = true;
+    } else if (keyword == "element") {
+      Element element;
+      if (!(tokens >> element.name >> element.count)) {
+        return fail("Malformed element in PLY header of " + filepath);
+      }
+      elements.push_back(element);
+    } else if (keyword == "property" && !elements.empty()) {
+      Element& element = elements.back();
+      std::string type;
+      std::string name;
+      tokens >> type;
+      if (type == "list") {
+        std::string countType;
+        tokens >> countType >> type;
+        element.fixedSize = false;
+      }
+      tokens >> name;
+
+      Property property{parsePropertyType(type), element.rowStride,
+                        element.properties.size()};
+      if (property.type == miniply::PLYPropertyType::None || name.empty()) {
+        return fail("Malformed property '" + line + "' in " + filepath);
+      }
+      element.rowStride += propertySize(property.type);
+      element.propertyNames.push_back(name);
+      element.properties.push_back(property);
+    } else if (keyword == "end_header") {
+      hasEnd = true;
+    }
+    // comment and obj_info lines carry nothing needed here
+  }
+
+  if (!hasFormat || !hasEnd) {
+    return fail("Malformed or truncated PLY header in " + filepath);
+  }
+  dataOffset = file.tellg();
+
+  auto vertex = std::find_if(elements.begin(), elements.end(), [](const Element& element) {
+    return element.name == miniply::kPLYVertexElement;
+  });
+  if (vertex == elements.end()) {
+    return fail("No vertex element found in " + filepath);
+  }
+
+  // rows belonging to elements stored ahead of the vertex element must be
+  // skipped, which is only possible without scanning when they are fixed size
+  std::uint64_t bytesToSkip = 0;
+  for (auto element = elements.begin(); element != vertex; ++element) {
+    if (!element->fixedSize && fileType != miniply::PLYFileType::ASCII) {
+      return fail("Cannot stream " + filepath +
+                  ": variable-size element '" + element->name +
+                  "' precedes the vertex element");
+    }
+    bytesToSkip += element->count * element->rowStride;
+    rowsToSkip += element->count;
+  }
+
+  if (!vertex->fixedSize) {
+    return fail("Cannot stream " + filepath + ": vertex element has list properties");
+  }
+  numPoints = vertex->count;
+  rowStride = vertex->rowStride;
+  numColumns = vertex->properties.size();
+
+  // properties an attribute is read from, to report the rest
+  std::vector<bool> isRead(vertex->propertyNames.size(), false);
+  auto findIndex = [&vertex](std::initializer_list<const char*> names) {
+    for (const char* name : names) {
+      auto it = std::find(vertex->propertyNames.begin(), vertex->propertyNames.end(), name);
+      if (it != vertex->propertyNames.end()) return it - vertex->propertyNames.begin();
+    }
+    return static_cast<std::ptrdiff_t>(-1);
+  };
+  auto findProperty = [&](std::initializer_list<const char*> names, Property* property) {
+    const std::ptrdiff_t idx = findIndex(names);
+    if (idx < 0) return false;
+    *property = vertex->properties[idx];
+    isRead[idx] = true;
+    return true;
+  };
+  auto findProperties = [&](const char* (&names)[3], Property* properties) {
+    const std::ptrdiff_t idx[3] = {findIndex({names[0]}), findIndex({names[1]}),
+                                   findIndex({names[2]})};
+    if (idx[0] < 0 || idx[1] < 0 || idx[2] < 0) return false;
+    for (int i = 0; i < 3; i++) {
+      properties[i] = vertex->properties[idx[i]];
+      isRead[idx[i]] = true;
+    }
+    return true;
+  };
+
+  const char* positionNames[3] = {"x", "y", "z"};
+  if (!findProperties(positionNames, positionProperties)) {
+    return fail("No position property found in " + filepath);
+  }
+
+  const char* colourNames[3][3] = {{"red", "green", "blue"},
+                                   {"r", "g", "b"},
+                                   {"diffuse_red", "diffuse_green", "diffuse_blue"}};
+  for (auto& names : colourNames) {
+    if (!hasColourProperties) {
+      hasColourProperties = findProperties(names, colourProperties);
+    }
+  }
+
+  // scalar field names used by common exporters (CloudCompare prefixes "scalar_")
+  hasIntensityProperty = findProperty(
+      {"intensity", "scalar_intensity", "scalar_Intensity"}, &intensityProperty);
+  hasClassificationProperty = findProperty(
+      {"classification", "scalar_classification", "scalar_Classification", "label"},
+      &classificationProperty);
+  const char* normalNames[3] = {"nx", "ny", "nz"};
+  hasNormalProperties = findProperties(normalNames, normalProperties);
+  for (std::size_t i = 0; i < isRead.size(); i++) {
+    if (!isRead[i]) unreadFields.push_back(vertex->propertyNames[i]);
+  }
+
+  if (fileType != miniply::PLYFileType::ASCII) {
+    dataOffset += static_cast<std::streamoff>(bytesToSkip);
+  }
+
+  return rewind();
+}
+
+bool PLYStreamReader::rewind() {
+  file.clear();
+  file.seekg(dataOffset);
+  rowsRead = 0;
+
+  if (fileType == miniply::PLYFileType::ASCII) {
+    for (std::size_t i = 0; i < rowsToSkip; i++) {
+      if (!std::getline(file, line)) {
+        return fail("Unexpected end of file in " + filepath);
+      }
+    }
+  }
+
+  return static_cast<bool>(file) || fail("Failed to seek in " + filepath);
+}
+
+std::size_t PLYStreamReader::readBatch(PointBatch& batch, std::size_t maxPoints) {
+  if (!isValid) return 0;
+
+  const std::size_t numRows = std::min(maxPoints, numPoints - rowsRead);
+  if (numRows == 0) return 0;
+
+  return fileType == miniply::PLYFileType::ASCII ? readASCIIRows(batch, numRows)
+                                                 : readBinaryRows(batch, numRows);
+}
+
+double PLYStreamReader::decode(const unsigned char* row, const Property& property) const {
+  unsigned char bytes[8];
+  const std::size_t size = propertySize(property.type);
+  std::memcpy(bytes, row + property.offset, size);
+  if (fileType == miniply::PLYFileType::BinaryBigEndian) {
+    std::reverse(bytes, bytes + size);
+  }
+
+  switch (property.type) {
+    case miniply::PLYPropertyType::Char:
+      return load<std::int8_t>(bytes);
+    case miniply::PLYPropertyType::UChar:
+      return load<std::uint8_t>(bytes);
+    case miniply::PLYPropertyType::Short:
+      return load<std::int16_t>(bytes);
+    case miniply::PLYPropertyType::UShort:
+      return load<std::uint16_t>(bytes);
+    case miniply::PLYPropertyType::Int:
+      return load<std::int32_t>(bytes);
+    case miniply::PLYPropertyType::UInt:
+      return load<std::uint32_t>(bytes);
+    case miniply::PLYPropertyType::Double:
+      return load<double>(bytes);
+    default:
+      return load<float>(bytes);
+  }
+}
+
+template <typename ValueFn>
+void PLYStreamReader::appendAttributes(PointBatch& batch, ValueFn value) const {
+  if (hasColourProperties && attributes.colours) {
+    batch.colours.emplace_back(toColourChannel(value(colourProperties[0]), colourProperties[0].type),
+                               toColourChannel(value(colourProperties[1]), colourProperties[1].type),
+                               toColourChannel(value(colourProperties[2]), colourProperties[2].type));
+  }
+  if (hasIntensityProperty && attributes.intensities) {
+    batch.intensities.push_back(static_cast<float>(value(intensityProperty)));
+  }
+  if (hasClassificationProperty && attributes.classifications) {
+    batch.classifications.push_back(toClassification(value(classificationProperty)));
+  }
+  if (hasNormalProperties && attributes.normals) {
+    batch.normals.emplace_back(toNormalComponent(value(normalProperties[0])),
+                               toNormalComponent(value(normalProperties[1])),
+                               toNormalComponent(value(normalProperties[2])));
+  }
+}
+
+std::size_t PLYStreamReader::readBinaryRows(PointBatch& batch, std::size_t numRows) {
+  rowBuffer.resize(numRows * rowStride);
+  file.read(reinterpret_cast<char*>(rowBuffer.data()), rowBuffer.size());
+  if (static_cast<std::size_t>(file.gcount()) != rowBuffer.size()) {
+    fail("Unexpected end of file in " + filepath);
+    return 0;
+  }
+
+  for (std::size_t i = 0; i < numRows; i++) {
+    if (filter && !filter->acceptsRow(rowsRead + i)) continue;
+
+    const unsigned char* row = rowBuffer.data() + i * rowStride;
+    const glm::vec3 position(decode(row, positionProperties[0]),
+                             decode(row, positionProperties[1]),
+                             decode(row, positionProperties[2]));
+    // a property the file lacks reads as 0, rather than as the default
+    // Property, which would decode the row's first value
+    auto scalar = [&](bool hasProperty, const Property& property) {
+      return hasProperty ? decode(row, property) : 0.0;
+    };
+    auto intensity = [&]() {
+      return static_cast<float>(scalar(hasIntensityProperty, intensityProperty));
+    };
+    auto classification = [&]() {
+      return static_cast<int>(scalar(hasClassificationProperty, classificationProperty));
+    };
+    if (filter && !filter->accepts(position, intensity, classification)) continue;
+
+    batch.positions.push_back(position);
+    appendAttributes(batch, [&](const Property& property) { return decode(row, property); });
+  }
+
+  rowsRead += numRows;
+  return numRows;
+}
+
+std::size_t PLYStreamReader::readASCIIRows(PointBatch& batch, std::size_t numRows) {
+  for (std::size_t i = 0; i < numRows; i++) {
+    if (!std::getline(file, line)) {
+      fail("Unexpected end of file in " + filepath);
+      return i;
+    }
+    if (filter && !filter->acceptsRow(rowsRead + i)) continue;
+
+    asciiValues.clear();
+    const char* cursor = line.c_str();
+    for (std::size_t column = 0; column < numColumns && *cursor; column++) {
+      char* end = nullptr;
+      double value = std::strtod(cursor, &end);
+      if (end == cursor) break;
+      asciiValues.push_back(value);
+      cursor = end;
+    }
+
+    auto column = [this](const Property& property) {
+      return property.column < asciiValues.size() ? asciiValues[property.column] : 0.0;
+    };
+
+    const glm::vec3 position(column(positionProperties[0]),
+                             column(positionProperties[1]),
+                             column(positionProperties[2]));
+    auto scalar = [&column](bool hasProperty, const Property& property) {
+      return hasProperty ? column(property) : 0.0;
+    };
+    auto intensity = [&]() {
+      return static_cast<float>(scalar(hasIntensityProperty, intensityProperty));
+    };
+    auto classification = [&]() {
+      return static_cast<int>(scalar(hasClassificationProperty, classificationProperty));
+    };
+    if (filter && !filter->accepts(position, intensity, classification)) continue;
+
+    batch.positions.push_back(position);
+    appendAttributes(batch, column);
+  }
+
+  rowsRead += numRows;
+  return numRows;
+}
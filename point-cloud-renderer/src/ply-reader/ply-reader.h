@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <miniply/miniply.h>
+
+#include <point-reader/point-reader.h>
+
+// Streams the vertex element of a PLY file in fixed-size batches. miniply is
+// not used for reading: its loader reads a whole element at once, which does
+// not fit files larger than memory, and its header counts are 32-bit. Binary
+// (both endiannesses) and ascii files are supported, provided the vertex
+// element has no list properties and any elements before it can be skipped.
+class PLYStreamReader : public PointReader {
+ public:
+  explicit PLYStreamReader(const std::string& filepath);
+
+  bool valid() const override;
+  const std::string& getError() const override;
+  std::size_t getNumPoints() const override;
+  bool hasColours() const override;
+  bool hasIntensities() const override;
+  bool hasClassifications() const override;
+  bool hasNormals() const override;
+  std::size_t readBatch(PointBatch& batch, std::size_t maxPoints) override;
+  bool rewind() override;
+
+ private:
+  struct Property {
+    miniply::PLYPropertyType type = miniply::PLYPropertyType::None;
+    std::size_t offset = 0;  // byte offset within a binary row
+    std::size_t column = 0;  // token index within an ascii row
+  };
+
+  bool parseHeader();
+  bool fail(const std::string& message);
+  double decode(const unsigned char* row, const Property& property) const;
+  // appends the requested attributes of a row, read through `value(property)`
+  template <typename ValueFn>
+  void appendAttributes(PointBatch& batch, ValueFn value) const;
+  std::size_t readBinaryRows(PointBatch& batch, std::size_t numRows);
+  std::size_t readASCIIRows(PointBatch& batch, std::size_t numRows);
+
+  std::string filepath;
+  std::string error;
+  bool isValid;
+
+  miniply::PLYFileType fileType;
+  std::ifstream file;
+  std::streamoff dataOffset;  // start of the first vertex row (binary) or data section (ascii)
+  std::size_t rowsToSkip;     // ascii rows of elements that precede the vertex element
+  std::size_t rowStride;
+  std::size_t numColumns;
+  std::size_t numPoints;
+  std::size_t rowsRead;
+
+  Property positionProperties[3];
+  Property colourProperties[3];
+  Property intensityProperty;
+  Property classificationProperty;
+  Property normalProperties[3];
+  bool hasColourProperties;
+  bool hasIntensityProperty;
+  bool hasClassificationProperty;
+  bool hasNormalProperties;
+
+  std::vector<unsigned char> rowBuffer;
+  std::vector<double> asciiValues;
+  std::string line;
+};
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <utility>
+
+#include <point-buffers/point-buffers.h>
+
+namespace {
+
+  template <typename Attribute>
+  void setAttributePointer() {
+    glEnableVertexAttribArray(Attribute::location);
+    if constexpr (Attribute::isInteger) {
+      glVertexAttribIPointer(Attribute::location, Attribute::components, Attribute::glType,
+                             sizeof(typename Attribute::Type), 0);
+    } else {
+      glVertexAttribPointer(Attribute::location, Attribute::components, Attribute::glType,
+                            Attribute::isNormalized ? GL_TRUE : GL_FALSE,
+                            sizeof(typename Attribute::Type), 0);
+    }
+  }
+
+  // Moves the first `usedBytes` of `vbo` into a new buffer of `newBytes`,
+  // copying on the GPU.
+  void resizeVBO(unsigned int& vbo, std::size_t usedBytes, std::size_t newBytes) {
+    unsigned int resized;
+    glGenBuffers(1, &resized);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, resized);
+    glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, vbo);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedBytes);
+    glDeleteBuffers(1, &vbo);
+    vbo = resized;
+  }
+
+  template <typename Schema>
+  struct Layout;
+
+  // the per-attribute loops of PointBuffers, expanded over the schema
+  template <typename... Attributes>
+  struct Layout<PointSchema<Attributes...>> {
+    using Schema = PointSchema<Attributes...>;
+    using VBOs = std::array<unsigned int, sizeof...(Attributes)>;
+
+    static void upload(VBOs& vbos, const typename Schema::Columns& points) {
+      std::size_t i = 0;
+      auto uploadColumn = [&](auto attribute) {
+        using Attribute = decltype(attribute);
+        const auto& column = points.template get<Attribute>();
+        if (vbos[i] == 0) glGenBuffers(1, &vbos[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, vbos[i]);
+        glBufferData(GL_ARRAY_BUFFER, column.size() * sizeof(typename Attribute::Type),
+                     column.data(), GL_STATIC_DRAW);
+        setAttributePointer<Attribute>();
+        i++;
+      };
+      (uploadColumn(Attributes()), ...);
+    }
+
+    static void append(VBOs& vbos, std::size_t offset, const typename Schema::Columns& points) {
+      std::size_t i = 0;
+      auto appendColumn = [&](auto attribute) {
+        using Attribute = decltype(attribute);
+        const auto& column = points.template get<Attribute>();
+        glBindBuffer(GL_ARRAY_BUFFER, vbos[i]);
+        glBufferSubData(GL_ARRAY_BUFFER, offset * sizeof(typename Attribute::Type),
+                        column.size() * sizeof(typename Attribute::Type), column.data());
+        i++;
+      };
+      (appendColumn(Attributes()), ...);
+    }
+
+    static void resize(VBOs& vbos, std::size_t numPoints, std::size_t newCapacity) {
+      std::size_t i = 0;
+      auto resizeColumn = [&](auto attribute) {
+        using Attribute = decltype(attribute);
+        constexpr std::size_t size = sizeof(typename Attribute::Type);
+        resizeVBO(vbos[i], numPoints * size, newCapacity * size);
+        // point the bound VAO's attribute at the new buffer
+        glBindBuffer(GL_ARRAY_BUFFER, vbos[i]);
+        setAttributePointer<Attribute>();
+        i++;
+      };
+      (resizeColumn(Attributes()), ...);
+    }
+  };
+
+}  // namespace
+
+template <typename Schema>
+PointBuffers<Schema>::PointBuffers()
+    : vbos{},
+      numPoints(0),
+      capacity(0) {
+}
+
+template <typename Schema>
+PointBuffers<Schema>::~PointBuffers() {
+  release();
+}
+
+template <typename Schema>
+PointBuffers<Schema>::PointBuffers(PointBuffers&& other) noexcept
+    : vbos(other.vbos),
+      numPoints(other.numPoints),
+      capacity(other.capacity) {
+  other.vbos.fill(0);
+  other.numPoints = 0;
+  other.capacity = 0;
+}
+
+template <typename Schema>
+PointBuffers<Schema>& PointBuffers<Schema>::operator=(PointBuffers&& other) noexcept {
+  if (this != &other) {
+    release();
+    vbos = other.vbos;
+    numPoints = other.numPoints;
+    capacity = other.capacity;
+    other.vbos.fill(0);
+    other.numPoints = 0;
+    other.capacity = 0;
+  }
+  return *this;
+}
+
+template <typename Schema>
+std::size_t PointBuffers<Schema>::getNumPoints() const {
+  return numPoints;
+}
+
+template <typename Schema>
+std::size_t PointBuffers<Schema>::getCapacity() const {
+  return capacity;
+}
+
+template <typename Schema>
+void PointBuffers<Schema>::upload(const Columns& points) {
+  Layout<Schema>::upload(vbos, points);
+  numPoints = points.size();
+  capacity = numPoints;
+}
+
+template <typename Schema>
+void PointBuffers<Schema>::append(const Columns& points) {
+  const std::size_t count = points.size();
+  if (count == 0) return;
+
+  if (numPoints + count > capacity) {
+    // grow geometrically so a node gaining points a few at a time is not
+    // copied on every append
+    resize(std::max(numPoints + count, capacity * 2));
+  }
+  Layout<Schema>::append(vbos, numPoints, points);
+  numPoints += count;
+}
+
+template <typename Schema>
+void PointBuffers<Schema>::shrinkToFit() {
+  if (capacity > numPoints) resize(numPoints);
+}
+
+template <typename Schema>
+void PointBuffers<Schema>::resize(std::size_t newCapacity) {
+  Layout<Schema>::resize(vbos, numPoints, newCapacity);
+  capacity = newCapacity;
+}
+
+template <typename Schema>
+void PointBuffers<Schema>::release() {
+  for (unsigned int& vbo : vbos) {
+    if (vbo != 0) glDeleteBuffers(1, &vbo);
+    vbo = 0;
+  }
+  numPoints = 0;
+  capacity = 0;
+}
+
+#define INSTANTIATE_POINT_BUFFERS(...) template class PointBuffers<PointSchema<__VA_ARGS__>>;
+POINT_SCHEMAS(INSTANTIATE_POINT_BUFFERS)
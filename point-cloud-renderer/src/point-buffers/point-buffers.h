@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include <glad/gl.h>
+
+#include <point-schema/point-schema.h>
+
+// The GPU buffers of one octree node: a tightly packed VBO per attribute of
+// the schema, filled straight from the node's columns with no CPU copy. The
+// attribute pointers are set on whichever VAO is bound when uploading.
+template <typename Schema>
+class PointBuffers {
+ public:
+  using Columns = typename Schema::Columns;
+
+  PointBuffers();
+  ~PointBuffers();
+
+  PointBuffers(const PointBuffers&) = delete;
+  PointBuffers& operator=(const PointBuffers&) = delete;
+
+  PointBuffers(PointBuffers&& other) noexcept;
+  PointBuffers& operator=(PointBuffers&& other) noexcept;
+
+  std::size_t getNumPoints() const;
+  std::size_t getCapacity() const;  // points the VBOs can hold
+
+  // Replaces the buffers' contents with `points`, reusing the VBOs of an
+  // earlier upload.
+  void upload(const Columns& points);
+  // Appends points to the uploaded VBOs, growing them when full.
+  void append(const Columns& points);
+  // Drops the spare capacity left by append(), copying on the GPU.
+  void shrinkToFit();
+
+ private:
+  void resize(std::size_t newCapacity);  // keeps the first numPoints points
+  void release();
+
+  // GPU buffer names, in the schema's attribute order
+  std::array<unsigned int, Schema::numAttributes> vbos;
+  std::size_t numPoints;
+  std::size_t capacity;
+};
@@ -1,5 +1,6 @@
 #include "point-cloud.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <limits>
@@ -7,16 +8,94 @@
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <miniply/miniply.h>
+#include <pcd-reader/pcd-reader.h>
+#include <ply-reader/ply-reader.h>
+#include <point-stats/point-stats.h>
 
-PointCloud::PointCloud(Buffers&& buffers, const BoundingBox& bbox)
-    : buffers(std::move(buffers)), bbox(bbox), pointSize(3.f), vao(0) {
-  // Center and scale the point cloud so it starts in view.
-  float scale = bbox.getScreenScaleFactor();
-  glm::vec3 center = bbox.getCenter();
+namespace {
+
+  // Fraction of the points at each end of every axis left out of the initial
+  // framing and the height range, so a few stray points far from the cloud
+  // neither shrink it on screen nor flatten its height colours.
+  constexpr float outlierFraction = 0.001f;
+
+  bool isSupportedExtension(const std::string& ext) {
+    return ext == ".ply" || ext == ".pcd";
+  }
+
+  // attributes only the streaming readers decode
+  bool needsStreamingReader(const AttributeSet& attributes) {
+    return attributes.intensities || attributes.classifications || attributes.normals;
+  }
+
+  // where a load reports what it found: standard output, or nowhere if quiet
+  std::ostream& getLog(bool quiet) {
+    thread_local std::ostream discard(nullptr);
+    return quiet ? discard : std::cout;
+  }
+
+  // the fields a load skips, e.g. return numbers, so none is dropped unannounced
+  void logUnreadFields(const std::vector<std::string>& fields, std::ostream& log) {
+    if (fields.empty()) return;
+    log << "  - Not loaded, as no attribute holds them:";
+    for (const std::string& field : fields) {
+      log << " " << field;
+    }
+    log << std::endl;
+  }
+
+  // Hands the filter of `options`, if it is active, to `reader`. A filter on
+  // an attribute the file lacks is an error, since the reader would test a 0
+  // in its place.
+  bool applyFilter(PointReader& reader, const LoadOptions& options,
+                   const std::string& filepath, std::string& error) {
+    const PointFilter& filter = options.filter;
+    if (!filter.isActive()) return true;
+    if (filter.needsIntensity() && !reader.hasIntensities()) {
+      error = "No intensity attribute found in " + filepath;
+      return false;
+    }
+    if (filter.needsClassification() && !reader.hasClassifications()) {
+      error = "No classification attribute found in " + filepath;
+      return false;
+    }
+    reader.setFilter(&filter);
+    return true;
+  }
+
+  AttributeSet intersect(const AttributeSet& a, const AttributeSet& b) {
+    AttributeSet both;
+    both.colours = a.colours && b.colours;
+    both.intensities = a.intensities && b.intensities;
+    both.classifications = a.classifications && b.classifications;
+    both.normals = a.normals && b.normals;
+    return both;
+  }
+
+}  // namespace
+
+PointCloud::PointCloud(PointBatch&& points, const glm::vec3& min, const glm::vec3& max)
+    : points(std::move(points)),
+      attributes(this->points.getAttributes()),
+      bbox(min, max, true),
+      pointSize(3.f),
+      zRange(min.z, max.z),
+      intensityRange(0.f),
+      spacing(0.f),
+      isColourUniform(false),
+      sourcePoints(this->points.size()) {
+  frame(min, max);
+}
+
+void PointCloud::frame(const glm::vec3& min, const glm::vec3& max) {
+  const BoundingBox framed(min, max, true);
+  float scale = framed.getScreenScaleFactor();
+  glm::vec3 center = framed.getCenter();
 
   // translate point cloud to center
   modelMatrix = glm::translate(glm::mat4(1.f),
@@ -26,23 +105,151 @@ PointCloud::PointCloud(Buffers&& buffers, const BoundingBox& bbox)
   modelMatrix = glm::scale(modelMatrix, glm::vec3(scale));
 }
 
-PointCloud::~PointCloud() {
-  if (vao != 0) {
-    glDeleteVertexArrays(1, &vao);
+PointCloud PointCloud::build(const std::string& filepath, const LoadOptions& options) {
+  std::string error;
+  std::optional<PointCloud> cloud = load(filepath, options, error);
+  if (!cloud) {
+    std::cerr << "Error: " << error << std::endl;
+    std::exit(EXIT_FAILURE);
   }
+  return std::move(*cloud);
 }
 
-PointCloud PointCloud::build(const std::string& filepath,
-                             std::optional<unsigned int> pointLimit) {
+std::optional<PointCloud> PointCloud::load(const std::string& filepath,
+                                           const LoadOptions& options, std::string& error) {
   std::string ext = getFileExtension(filepath);
+  std::ostream& log = getLog(options.quiet);
 
-  if (ext == ".ply") {
-    return loadPLY(filepath, pointLimit);
+  if (isSupportedExtension(ext)) {
+    // "first" keeps the readers' own truncating fast path unless filtering
+    if (options.filter.isActive() || needsStreamingReader(options.attributes) ||
+        (options.pointLimit && options.sampling != PointSampler::Mode::First)) {
+      return loadStreamed(filepath, options, error);
+    }
+    if (ext == ".pcd") {
+      return loadPCD(filepath, options.pointLimit, options.attributes.colours, log, error);
+    }
+    // miniply's row counts are 32-bit, so larger PLY files use the streaming reader
+    std::unique_ptr<PointReader> reader = createReader(filepath);
+    if (!reader->valid()) {
+      error = reader->getError();
+      return std::nullopt;
+    }
+    if (reader->getNumPoints() > std::numeric_limits<std::uint32_t>::max()) {
+      return loadStreamed(filepath, options, error);
+    }
+    return loadPLY(filepath, options.pointLimit, options.attributes.colours,
+                   reader->getUnreadFields(), log, error);
   }
 
-  std::cerr << "Error: Unrecognised file extension '" << ext
-            << "'. Supported formats: .ply" << std::endl;
-  std::exit(EXIT_FAILURE);
+  error = "Unrecognised file extension '" + ext + "'. Supported formats: .ply, .pcd";
+  return std::nullopt;
+}
+
+PointCloud PointCloud::scan(const std::string& filepath, const LoadOptions& options) {
+  std::string ext = getFileExtension(filepath);
+  if (!isSupportedExtension(ext)) {
+    std::cerr << "Error: Unrecognised file extension '" << ext
+              << "'. Supported formats: .ply, .pcd" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  std::ostream& log = getLog(options.quiet);
+  std::unique_ptr<PointReader> reader = openReader(filepath);
+  log << "Streaming build:" << std::endl;
+  log << "  - " << reader->getNumPoints() << " points" << std::endl;
+  logUnreadFields(reader->getUnreadFields(), log);
+  if (options.filter.isActive()) options.filter.describe(log);
+  std::string error;
+  if (!applyFilter(*reader, options, filepath, error)) {
+    std::cerr << "Error: " << error << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  const Bounds bounds = readBounds(*reader, options);
+  if (!reader->valid()) {
+    std::cerr << "Error: " << reader->getError() << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  if (bounds.numPoints == 0) {
+    std::cerr << "Error: No points in " << filepath << " passed the filters"
+              << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  log << "  - Bounds found in a first pass over " << bounds.numPoints << " points"
+      << std::endl;
+
+  PointCloud cloud(PointBatch(), bounds.min, bounds.max);
+  cloud.filepath = filepath;
+  cloud.options = options;
+  cloud.attributes = intersect(options.attributes, reader->getAvailableAttributes());
+  if (cloud.attributes.intensities) cloud.intensityRange = bounds.intensityRange;
+  cloud.sourcePoints = bounds.numPoints;
+  return cloud;
+}
+
+PointCloud PointCloud::frameBounds(const glm::vec3& min, const glm::vec3& max) {
+  return PointCloud(PointBatch(), min, max);
+}
+
+bool PointCloud::getFileBounds(const std::string& filepath, const LoadOptions& options,
+                               Bounds& bounds, std::string& error) {
+  std::string ext = getFileExtension(filepath);
+  if (!isSupportedExtension(ext)) {
+    error = "Unrecognised file extension '" + ext + "'. Supported formats: .ply, .pcd";
+    return false;
+  }
+
+  std::unique_ptr<PointReader> reader = createReader(filepath);
+  if (reader->valid()) {
+    if (!applyFilter(*reader, options, filepath, error)) return false;
+    bounds = readBounds(*reader, options);
+  }
+  if (!reader->valid()) {
+    error = reader->getError();
+    return false;
+  }
+  return true;
+}
+
+bool PointCloud::readFileHeader(const std::string& filepath, std::uint64_t& numPoints,
+                                AttributeSet& attributes, std::string& error) {
+  std::string ext = getFileExtension(filepath);
+  if (!isSupportedExtension(ext)) {
+    error = "Unrecognised file extension '" + ext + "'. Supported formats: .ply, .pcd";
+    return false;
+  }
+
+  std::unique_ptr<PointReader> reader = createReader(filepath);
+  if (!reader->valid()) {
+    error = reader->getError();
+    return false;
+  }
+  numPoints = reader->getNumPoints();
+  attributes = reader->getAvailableAttributes();
+  return true;
+}
+
+AttributeSet PointCloud::getFileAttributes(const std::string& filepath) {
+  std::uint64_t numPoints;
+  AttributeSet attributes;
+  std::string error;
+  if (!readFileHeader(filepath, numPoints, attributes, error)) {
+    std::cerr << "Error: " << error << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  return attributes;
+}
+
+std::uint64_t PointCloud::getFilePoints(const std::string& filepath) {
+  std::uint64_t numPoints;
+  AttributeSet attributes;
+  std::string error;
+  if (!readFileHeader(filepath, numPoints, attributes, error)) {
+    std::cerr << "Error: " << error << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  return numPoints;
 }
 
 void PointCloud::rotate(float deltaX, float deltaY, float deltaTime,
@@ -74,29 +281,141 @@ float PointCloud::getPointSize() const {
   return pointSize;
 }
 
-void PointCloud::buffer() {
-  glGenVertexArrays(1, &vao);
-  glBindVertexArray(vao);
-  buffers.uploadToGPU();
-}
-
-void PointCloud::draw() const {
-  glBindVertexArray(vao);
-  glDrawArrays(GL_POINTS, 0, buffers.getNumPoints());
-}
-
 const glm::mat4& PointCloud::getModelMatrix() const {
   return modelMatrix;
 }
 
-const Buffers& PointCloud::getBuffers() const {
-  return buffers;
+const PointBatch& PointCloud::getPoints() const {
+  return points;
+}
+
+const AttributeSet& PointCloud::getAttributes() const {
+  return attributes;
 }
 
 const BoundingBox& PointCloud::getBoundingBox() const {
   return bbox;
 }
 
+glm::vec2 PointCloud::getZRange() const {
+  return zRange;
+}
+
+glm::vec2 PointCloud::getIntensityRange() const {
+  return intensityRange;
+}
+
+std::uint64_t PointCloud::getSourcePoints() const {
+  return sourcePoints;
+}
+
+float PointCloud::getSpacing() const {
+  return spacing;
+}
+
+bool PointCloud::hasUniformColour() const {
+  return isColourUniform;
+}
+
+bool PointCloud::isScanned() const {
+  return !filepath.empty();
+}
+
+bool PointCloud::stream(const std::function<bool(const PointBatch&)>& consume,
+                        std::string& error) const {
+  std::ostream& log = getLog(options.quiet);
+  std::unique_ptr<PointReader> reader = createReader(filepath);
+  if (!reader->valid()) {
+    error = reader->getError();
+    return false;
+  }
+  if (!applyFilter(*reader, options, filepath, error)) return false;
+  reader->setAttributes(attributes);
+
+  // the bounds pass counted the points that pass the filters
+  const bool sampled = options.pointLimit &&
+                       options.sampling != PointSampler::Mode::First &&
+                       *options.pointLimit < sourcePoints;
+  if (!sampled) {
+    readBatches(*reader, options, consume);
+  } else {
+    // the sampler must see the whole file before any point is final, but
+    // what it keeps is bounded by the budget
+    PointSampler sampler(options.sampling, *options.pointLimit, sourcePoints, attributes,
+                         options.seed);
+    LoadOptions unlimited = options;
+    unlimited.pointLimit = std::nullopt;
+    readBatches(*reader, unlimited, [&sampler](PointBatch& batch) {
+      sampler.add(batch);
+      return true;
+    });
+
+    PointBatch sample;
+    sampler.finish(sample);
+    log << "  - Sampled " << sample.size() << " points ("
+        << PointSampler::getModeName(options.sampling)
+        << ") due to point buffer budget" << std::endl;
+    consume(sample);
+  }
+
+  if (!reader->valid()) {
+    error = reader->getError();
+    return false;
+  }
+  return true;
+}
+
+PointCloud::Bounds PointCloud::readBounds(PointReader& reader, const LoadOptions& options) {
+  // Neither PLY nor PCD headers store bounds, so take them from a pass over
+  // the positions. A sampled budget is bounded by every point that passes.
+  LoadOptions unsampled = options;
+  if (options.sampling != PointSampler::Mode::First) {
+    unsampled.pointLimit = std::nullopt;
+  }
+
+  // only the intensities are needed besides the positions, for their range
+  AttributeSet bounded;
+  bounded.colours = false;
+  bounded.intensities = options.attributes.intensities && reader.hasIntensities();
+  reader.setAttributes(bounded);
+
+  const float fmax = std::numeric_limits<float>::max();
+  Bounds bounds;
+  bounds.min = glm::vec3(fmax);
+  bounds.max = glm::vec3(-fmax);
+  bounds.intensityRange = glm::vec2(fmax, -fmax);
+  bounds.numPoints = 0;
+  readBatches(reader, unsampled, [&](PointBatch& batch) {
+    for (const glm::vec3& position : batch.positions) {
+      bounds.min = glm::min(bounds.min, position);
+      bounds.max = glm::max(bounds.max, position);
+    }
+    if (!batch.intensities.empty()) {
+      const glm::vec2 range = getRange(batch.intensities);
+      bounds.intensityRange = glm::vec2(std::min(bounds.intensityRange.x, range.x),
+                                        std::max(bounds.intensityRange.y, range.y));
+    }
+    bounds.numPoints += batch.size();
+    return true;
+  });
+  return bounds;
+}
+
+void PointCloud::readBatches(PointReader& reader, const LoadOptions& options,
+                             const std::function<bool(PointBatch&)>& consume) {
+  std::size_t remaining = options.pointLimit ? *options.pointLimit
+                                             : std::numeric_limits<std::size_t>::max();
+  PointBatch batch;
+  while (remaining > 0) {
+    batch.clear();
+    if (reader.readBatch(batch, PointReader::defaultBatchSize) == 0) break;
+
+    batch.truncate(remaining);
+    remaining -= batch.size();
+    if (batch.size() > 0 && !consume(batch)) break;
+  }
+}
+
 std::string PointCloud::getFileExtension(const std::string& filepath) {
   std::size_t dot = filepath.rfind('.');
   if (dot == std::string::npos) {
@@ -105,20 +424,149 @@ std::string PointCloud::getFileExtension(const std::string& filepath) {
   return filepath.substr(dot);
 }
 
-PointCloud PointCloud::loadPLY(const std::string& filepath,
-                               std::optional<unsigned int> pointLimit) {
+std::unique_ptr<PointReader> PointCloud::openReader(const std::string& filepath) {
+  std::unique_ptr<PointReader> reader = createReader(filepath);
+  if (!reader->valid()) {
+    std::cerr << "Error: " << reader->getError() << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  return reader;
+}
+
+std::unique_ptr<PointReader> PointCloud::createReader(const std::string& filepath) {
+  if (getFileExtension(filepath) == ".pcd") {
+    return std::make_unique<PCDReader>(filepath);
+  }
+  return std::make_unique<PLYStreamReader>(filepath);
+}
+
+std::optional<PointCloud> PointCloud::loadStreamed(const std::string& filepath,
+                                                   const LoadOptions& options,
+                                                   std::string& error) {
+  std::unique_ptr<PointReader> reader = createReader(filepath);
+  if (!reader->valid()) {
+    error = reader->getError();
+    return std::nullopt;
+  }
+  const std::size_t filePointCount = reader->getNumPoints();
+  const bool filtering = options.filter.isActive();
+  std::ostream& log = getLog(options.quiet);
+
+  // nothing to filter, sample or decode besides colours: fall back to the
+  // regular loaders
+  if (!filtering && !needsStreamingReader(options.attributes) &&
+      (!options.pointLimit || *options.pointLimit >= filePointCount)) {
+    LoadOptions unlimited = options;
+    unlimited.pointLimit = std::nullopt;
+    return load(filepath, unlimited, error);
+  }
+
+  if (!applyFilter(*reader, options, filepath, error)) return std::nullopt;
+
+  log << "Streaming reader:" << std::endl;
+  log << "  - " << filePointCount << " points" << std::endl;
+  if (filtering) options.filter.describe(log);
+  const AttributeSet attributes =
+      intersect(options.attributes, reader->getAvailableAttributes());
+  reader->setAttributes(attributes);
+  if (attributes.colours) log << "  - Found colour property" << std::endl;
+  if (attributes.intensities) log << "  - Found intensity property" << std::endl;
+  if (attributes.classifications) {
+    log << "  - Found classification property" << std::endl;
+  }
+  if (attributes.normals) log << "  - Found normal property" << std::endl;
+  logUnreadFields(reader->getUnreadFields(), log);
+
+  PointBatch points;
+  PointBatch batch;
+  std::uint64_t sourcePoints = 0;
+
+  if (options.pointLimit) {
+    log << "  - Sampling at most " << *options.pointLimit << " points ("
+        << PointSampler::getModeName(options.sampling) << ", seed "
+        << options.seed << ") due to point buffer budget" << std::endl;
+
+    // without a bounds pass, the points that pass the filters are not counted
+    const std::optional<std::uint64_t> totalPoints =
+        filtering ? std::nullopt : std::optional<std::uint64_t>(filePointCount);
+    PointSampler sampler(options.sampling, *options.pointLimit, totalPoints, attributes,
+                         options.seed);
+    while (!sampler.isSaturated()) {
+      batch.clear();
+      if (reader->readBatch(batch, PointReader::defaultBatchSize) == 0) break;
+      sampler.add(batch);
+    }
+    sampler.finish(points);
+    sourcePoints = sampler.getPointsSeen();
+  } else {
+    // the filters already ran inside the reader, so every point is kept
+    readBatches(*reader, options, [&points](PointBatch& batch) {
+      points.append(batch);
+      return true;
+    });
+  }
+
+  if (!reader->valid()) {
+    error = reader->getError();
+    return std::nullopt;
+  }
+
+  const std::size_t numPoints = points.size();
+  if (numPoints == 0) {
+    error = "No points in " + filepath + " passed the filters";
+    return std::nullopt;
+  }
+  log << "  - Kept " << numPoints << " points" << std::endl;
+
+  // points sampled apart are not neighbours, so their distances say nothing
+  const bool areNeighbours =
+      options.sampling == PointSampler::Mode::First || sourcePoints <= numPoints;
+  PointCloud cloud = fromPoints(std::move(points), areNeighbours, log);
+  cloud.sourcePoints = std::max<std::uint64_t>(sourcePoints, numPoints);
+  return cloud;
+}
+
+PointCloud PointCloud::fromPoints(PointBatch&& points, bool areNeighbours,
+                                  std::ostream& log) {
+  // the one pass over the loaded columns; the rest of the load reuses it
+  const PointStats stats = PointStats::compute(points);
+  PointCloud cloud(std::move(points), stats.min, stats.max);
+  cloud.intensityRange = stats.intensityRange;
+  if (areNeighbours) cloud.spacing = stats.getSpacing();
+  cloud.isColourUniform = cloud.attributes.colours && !stats.hasColourVariation;
+
+  const glm::vec3 low = stats.getQuantile(outlierFraction);
+  const glm::vec3 high = stats.getQuantile(1.f - outlierFraction);
+  if (glm::any(glm::greaterThan(high, low))) {
+    cloud.frame(low, high);
+    cloud.zRange = glm::vec2(low.z, high.z);
+  }
+
+  if (cloud.spacing > 0.f) {
+    log << "  - Median distance between consecutive points: " << cloud.spacing << std::endl;
+  }
+  if (cloud.isColourUniform) {
+    log << "  - Every point has the same colour, colouring by height instead"
+        << std::endl;
+  }
+  return cloud;
+}
+
+std::optional<PointCloud> PointCloud::loadPLY(const std::string& filepath,
+                                              std::optional<std::uint64_t> pointLimit,
+                                              bool readColours,
+                                              const std::vector<std::string>& unreadFields,
+                                              std::ostream& log, std::string& error) {
   miniply::PLYReader reader(filepath.c_str());
   if (!reader.valid()) {
-    std::cerr << "Error: Failed to open " << filepath << std::endl;
-    std::exit(EXIT_FAILURE);
+    error = "Failed to open " + filepath;
+    return std::nullopt;
   }
 
-  unsigned int numPoints = 0;
-  std::unique_ptr<glm::vec3[]> positions;
-  std::unique_ptr<glm::u8vec3[]> colours;
+  std::size_t numPoints = 0;
+  PointBatch points;
   uint32_t posIndexes[3];
   uint32_t colourIndexes[3];
-  bool hasColours = false;
 
   while (reader.has_element()) {
     if (!reader.element_is(miniply::kPLYVertexElement)) {
@@ -126,11 +574,11 @@ PointCloud PointCloud::loadPLY(const std::string& filepath,
       continue;
     }
 
-    const unsigned int filePointCount = reader.num_rows();
+    const std::size_t filePointCount = reader.num_rows();
     if (pointLimit && *pointLimit < filePointCount) {
       miniply::PLYElement* vertexElement =
           reader.get_element(reader.find_element(miniply::kPLYVertexElement));
-      vertexElement->count = *pointLimit;
+      vertexElement->count = static_cast<std::uint32_t>(*pointLimit);
     }
 
     if (!reader.load_element() || !reader.find_pos(posIndexes)) {
@@ -139,94 +587,108 @@ PointCloud PointCloud::loadPLY(const std::string& filepath,
     }
 
     numPoints = reader.num_rows();
-    positions = std::make_unique<glm::vec3[]>(numPoints);
-    colours = std::make_unique<glm::u8vec3[]>(numPoints);
+    points.positions.resize(numPoints);
 
-    std::cout << "PLY reader:" << std::endl;
-    std::cout << "  - Found position property" << std::endl;
-    std::cout << "  - " << filePointCount << " points" << std::endl;
+    log << "PLY reader:" << std::endl;
+    log << "  - Found position property" << std::endl;
+    log << "  - " << filePointCount << " points" << std::endl;
     if (numPoints < filePointCount) {
-      std::cout << "  - Reading first " << numPoints
-                << " points due to point buffer budget" << std::endl;
+      log << "  - Reading first " << numPoints
+          << " points due to point buffer budget" << std::endl;
     }
 
     if (reader.element()->properties[posIndexes[0]].type !=
         miniply::PLYPropertyType::Float) {
-      std::cerr << "Error: Position coordinates in " << filepath
-                << " must be floats" << std::endl;
-      std::exit(EXIT_FAILURE);
+      error = "Position coordinates in " + filepath + " must be floats";
+      return std::nullopt;
     }
 
     reader.extract_properties(posIndexes, 3, miniply::PLYPropertyType::Float,
-                              positions.get());
+                              points.positions.data());
 
-    if (reader.find_color(colourIndexes)) {
-      std::cout << "  - Found colour property" << std::endl;
+    if (readColours && reader.find_color(colourIndexes)) {
+      log << "  - Found colour property" << std::endl;
+      points.colours.resize(numPoints);
       reader.extract_properties(colourIndexes, 3,
                                 miniply::PLYPropertyType::UChar,
-                                colours.get());
-      hasColours = true;
+                                points.colours.data());
     }
+    logUnreadFields(unreadFields, log);
 
     break;
   }
 
   if (numPoints == 0) {
-    std::cerr << "Error: No vertex element found in " << filepath << std::endl;
-    std::exit(EXIT_FAILURE);
+    error = "No vertex element found in " + filepath;
+    return std::nullopt;
   }
 
-  if (!hasColours) {
-    std::cerr << "Warning: No colour attribute found in PLY file" << std::endl;
-    applyGradient(positions.get(), colours.get(), numPoints);
-  }
-
-  BoundingBox bbox = createBoundingBox(positions.get(), numPoints);
-  Buffers buffers(positions.get(), colours.get(), numPoints);
-
-  return PointCloud(std::move(buffers), bbox);
+  return fromPoints(std::move(points), true, log);
 }
 
-BoundingBox PointCloud::createBoundingBox(const glm::vec3* positionBuffer,
-                                          unsigned int numPoints) {
-  float fmax = std::numeric_limits<float>::max();
-  float fmin = std::numeric_limits<float>::lowest();
-
-  glm::vec3 min(fmax);
-  glm::vec3 max(fmin);
+std::optional<PointCloud> PointCloud::loadPCD(const std::string& filepath,
+                                              std::optional<std::uint64_t> pointLimit,
+                                              bool readColours, std::ostream& log,
+                                              std::string& error) {
+  PCDReader reader(filepath);
+  if (!reader.valid()) {
+    error = reader.getError() + " (" + filepath + ")";
+    return std::nullopt;
+  }
 
-  for (unsigned int i = 0; i < numPoints; i++) {
-    if (positionBuffer[i].x < min.x) min.x = positionBuffer[i].x;
-    if (positionBuffer[i].y < min.y) min.y = positionBuffer[i].y;
-    if (positionBuffer[i].z < min.z) min.z = positionBuffer[i].z;
-    if (positionBuffer[i].x > max.x) max.x = positionBuffer[i].x;
-    if (positionBuffer[i].y > max.y) max.y = positionBuffer[i].y;
-    if (positionBuffer[i].z > max.z) max.z = positionBuffer[i].z;
+  const std::size_t filePointCount = reader.getNumPoints();
+  std::size_t pointsToRead = filePointCount;
+  if (pointLimit && *pointLimit < filePointCount) {
+    pointsToRead = *pointLimit;
   }
 
-  return BoundingBox(min, max, true);
-}
+  log << "PCD reader:" << std::endl;
+  log << "  - Found position property" << std::endl;
+  log << "  - " << filePointCount << " points ("
+      << reader.getDataFormatName() << ")" << std::endl;
+  if (reader.isOrganized()) {
+    log << "  - Organized cloud (" << reader.getWidth() << " x "
+        << reader.getHeight() << ")" << std::endl;
+  }
+  if (pointsToRead < filePointCount) {
+    log << "  - Reading first " << pointsToRead
+        << " points due to point buffer budget" << std::endl;
+  }
+  AttributeSet attributes;
+  attributes.colours = readColours && reader.hasColours();
+  reader.setAttributes(attributes);
+  if (attributes.colours) {
+    log << "  - Found colour property" << std::endl;
+  }
+  logUnreadFields(reader.getUnreadFields(), log);
 
-// temporary fallback until point clouds without colour can be lit properly.
-void PointCloud::applyGradient(const glm::vec3* positionBuffer,
-                               glm::u8vec3* colourBuffer,
-                               unsigned int numPoints) {
-  float baseBrightness = 0.1f;
+  PointBatch points;
+  points.positions.resize(pointsToRead);
+  if (attributes.colours) points.colours.resize(pointsToRead);
 
-  float zMin = std::numeric_limits<float>::max();
-  float zMax = std::numeric_limits<float>::lowest();
+  std::size_t numRead = 0;
+  if (!reader.read(points.positions.data(), points.colours.data(), pointsToRead, &numRead)) {
+    error = reader.getError() + " (" + filepath + ")";
+    return std::nullopt;
+  }
 
-  for (unsigned int i = 0; i < numPoints; i++) {
-    if (positionBuffer[i].z < zMin) zMin = positionBuffer[i].z;
-    if (positionBuffer[i].z > zMax) zMax = positionBuffer[i].z;
+  if (numRead < pointsToRead) {
+    log << "  - Skipped " << pointsToRead - numRead
+        << " invalid (NaN) points" << std::endl;
   }
 
-  const float zRange = zMax - zMin;
-  for (unsigned int i = 0; i < numPoints; i++) {
-    float normalised =
-        zRange > 0.f ? (positionBuffer[i].z - zMin) / zRange : 0.f;
-    float brightness = baseBrightness + (1.f - baseBrightness) * normalised;
-    unsigned char colour = static_cast<unsigned char>(brightness * 255);
-    colourBuffer[i] = glm::u8vec3(colour);
+  if (numRead == 0) {
+    error = "No valid points found in " + filepath;
+    return std::nullopt;
   }
+
+  points.truncate(numRead);
+  return fromPoints(std::move(points), true, log);
+}
+
+glm::vec2 PointCloud::getRange(const std::vector<float>& values) {
+  if (values.empty()) return glm::vec2(0.f);
+
+  const auto [min, max] = std::minmax_element(values.begin(), values.end());
+  return glm::vec2(*min, *max);
 }
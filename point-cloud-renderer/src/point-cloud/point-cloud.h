@@ -1,47 +1,161 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
-#include <glad/gl.h>
 #include <glm/glm.hpp>
 
 #include <boundingbox/boundingbox.h>
-#include <buffers/buffers.h>
+#include <point-filter/point-filter.h>
+#include <point-reader/point-reader.h>
+#include <point-sampler/point-sampler.h>
+
+struct LoadOptions {
+  // point buffer budget: the most points to hold in memory
+  std::optional<std::uint64_t> pointLimit;
+  // how the budget picks points when the file holds more
+  PointSampler::Mode sampling = PointSampler::Mode::Voxel;
+  std::uint64_t seed = PointSampler::defaultSeed;
+  // crop and attribute filters applied while the file is decoded
+  PointFilter filter;
+  // push points straight from the reader into the octree builder instead of
+  // loading the whole cloud first (see PointCloud::scan)
+  bool streamingBuild = false;
+  // attributes to load besides the position, of those the file has
+  AttributeSet attributes;
+  // print nothing while loading, e.g. for tiles loaded in the background
+  bool quiet = false;
+};
 
 class PointCloud {
  public:
-  static PointCloud build(const std::string& filepath,
-                          std::optional<unsigned int> pointLimit);
-  ~PointCloud();
+  static PointCloud build(const std::string& filepath, const LoadOptions& options);
+  // Like build(), but sets `error` and returns nothing rather than exiting if
+  // the file can't be loaded, e.g. a tile loaded in the background.
+  static std::optional<PointCloud> load(const std::string& filepath, const LoadOptions& options,
+                                        std::string& error);
+  // Makes a first pass over the file for its bounds only. The returned cloud
+  // holds no points; stream() then hands them out batch by batch, so the
+  // full cloud is never held in memory.
+  static PointCloud scan(const std::string& filepath, const LoadOptions& options);
+  // Holds no points and frames the box between `min` and `max`, e.g. to view
+  // tiles that are loaded later.
+  static PointCloud frameBounds(const glm::vec3& min, const glm::vec3& max);
+
+  // what a pass over a file's positions finds, see getFileBounds()
+  struct Bounds {
+    glm::vec3 min;
+    glm::vec3 max;
+    glm::vec2 intensityRange;  // if loading intensities and the file has them
+    std::uint64_t numPoints;   // that passed the filters; the rest is unset if 0
+  };
+  // Bounds of the file's points that pass the filters and fit the budget.
+  // Neither PLY nor PCD headers store them, so this reads every position.
+  // Sets `error` and returns false if the file can't be read.
+  static bool getFileBounds(const std::string& filepath, const LoadOptions& options,
+                            Bounds& bounds, std::string& error);
+  // The number of points and the attributes the file at `filepath` holds, from
+  // its header. Sets `error` and returns false if the header can't be read.
+  static bool readFileHeader(const std::string& filepath, std::uint64_t& numPoints,
+                             AttributeSet& attributes, std::string& error);
+  // the attributes the file at `filepath` has, from its header; exits if unreadable
+  static AttributeSet getFileAttributes(const std::string& filepath);
+  // the number of points the file at `filepath` holds, from its header
+  static std::uint64_t getFilePoints(const std::string& filepath);
 
   void rotate(float deltaX, float deltaY, float deltaTime, float sensitivity,
               bool inverted);
   void incrementPointSize();
   void decrementPointSize();
   float getPointSize() const;
-  void buffer();
-  void draw() const;
   const glm::mat4& getModelMatrix() const;
+  // Centers and scales the box between `min` and `max` so it starts in view,
+  // e.g. to frame a scene of several clouds; clouds frame their own points.
+  void frame(const glm::vec3& min, const glm::vec3& max);
 
-  const Buffers& getBuffers() const;
+  // the loaded points, with a column per attribute of getAttributes()
+  const PointBatch& getPoints() const;
+  // the attributes loaded or, for a scanned cloud, streamed
+  const AttributeSet& getAttributes() const;
   const BoundingBox& getBoundingBox() const;
+  // heights of the lowest and highest points, for shading by height; of
+  // loaded clouds, without the outlying heights
+  glm::vec2 getZRange() const;
+  // range of the intensities loaded or streamed, for normalising them
+  glm::vec2 getIntensityRange() const;
+  // Points of the file that passed the filters, of which the budget kept
+  // getPoints().size(). Sampling "first" stops reading at the budget, so it
+  // only counts the points read until then.
+  std::uint64_t getSourcePoints() const;
+  // Estimated distance between neighbouring points, 0 when unknown: for
+  // scanned clouds and for samples other than the first points, which are no
+  // longer neighbours in the file. See PointStats::getSpacing(). Floors the
+  // size adaptive points are drawn at, see OctreeNode::buildOctree().
+  float getSpacing() const;
+  // whether every loaded point has the same colour, as in files exporting a
+  // placeholder rgb, so colouring by it shows nothing
+  bool hasUniformColour() const;
+
+  bool isScanned() const;
+  // Rereads a scanned file and passes the points to `consume`, stopping early
+  // if it returns false. Returns false, with the reader's error in `error`,
+  // if the file can no longer be read; it never exits, so it can run on a
+  // background thread.
+  bool stream(const std::function<bool(const PointBatch&)>& consume, std::string& error) const;
 
  private:
-  PointCloud(Buffers&& buffers, const BoundingBox& bbox);
+  // `min` and `max` bound the points, which the bounding box makes cubic
+  PointCloud(PointBatch&& points, const glm::vec3& min, const glm::vec3& max);
+
+  // Reads the points that pass the filters, stopping at the budget when
+  // sampling "first" or when `consume` returns false. Only valid for budgets
+  // the sampler does not pick.
+  static void readBatches(PointReader& reader, const LoadOptions& options,
+                          const std::function<bool(PointBatch&)>& consume);
+  // the bounds pass of scan() and getFileBounds()
+  static Bounds readBounds(PointReader& reader, const LoadOptions& options);
 
   static std::string getFileExtension(const std::string& filepath);
-  static PointCloud loadPLY(const std::string& filepath,
-                            std::optional<unsigned int> pointLimit);
-  static BoundingBox createBoundingBox(const glm::vec3* positionBuffer,
-                                       unsigned int numPoints);
-  static void applyGradient(const glm::vec3* positionBuffer,
-                            glm::u8vec3* colourBuffer,
-                            unsigned int numPoints);
-
-  Buffers buffers;
+  // exits if the file can't be read
+  static std::unique_ptr<PointReader> openReader(const std::string& filepath);
+  // the reader for the file's format, which may not be valid()
+  static std::unique_ptr<PointReader> createReader(const std::string& filepath);
+  static std::optional<PointCloud> loadStreamed(const std::string& filepath,
+                                                const LoadOptions& options, std::string& error);
+  // `areNeighbours`: whether points consecutive in `points` are consecutive
+  // in the file, as the spacing estimate assumes
+  static PointCloud fromPoints(PointBatch&& points, bool areNeighbours, std::ostream& log);
+  // The readers' bulk paths, which only decode positions and colours. miniply
+  // doesn't tell the fields it skips, so loadPLY() is handed the stream reader's.
+  static std::optional<PointCloud> loadPLY(const std::string& filepath,
+                                           std::optional<std::uint64_t> pointLimit,
+                                           bool readColours,
+                                           const std::vector<std::string>& unreadFields,
+                                           std::ostream& log, std::string& error);
+  static std::optional<PointCloud> loadPCD(const std::string& filepath,
+                                           std::optional<std::uint64_t> pointLimit,
+                                           bool readColours, std::ostream& log,
+                                           std::string& error);
+  static glm::vec2 getRange(const std::vector<float>& values);
+
+  PointBatch points;
+  AttributeSet attributes;
   BoundingBox bbox;
   glm::mat4 modelMatrix;
   float pointSize;
-  unsigned int vao;
+  glm::vec2 zRange;
+  glm::vec2 intensityRange;
+  float spacing;
+  bool isColourUniform;
+
+  // source of a scanned cloud
+  std::string filepath;
+  LoadOptions options;
+  std::uint64_t sourcePoints;
 };
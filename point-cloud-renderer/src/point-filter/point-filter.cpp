@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <limits>
+
+#include <point-filter/point-filter.h>
+
+PointFilter::PointFilter()
+    : polygonBounds{glm::vec3(0.f), glm::vec3(0.f)}, everyNth(1) {
+}
+
+void PointFilter::setBox(const glm::vec3& min, const glm::vec3& max) {
+  box = Box{glm::min(min, max), glm::max(min, max)};
+}
+
+void PointFilter::setPolygon(const std::vector<glm::vec2>& vertices, float zMin,
+                             float zMax) {
+  polygon = vertices;
+  if (polygon.empty()) return;
+
+  glm::vec2 min = polygon[0];
+  glm::vec2 max = polygon[0];
+  for (const glm::vec2& vertex : polygon) {
+    min = glm::min(min, vertex);
+    max = glm::max(max, vertex);
+  }
+  polygonBounds = Box{glm::vec3(min, std::min(zMin, zMax)),
+                      glm::vec3(max, std::max(zMin, zMax))};
+}
+
+void PointFilter::setIntensityRange(float min, float max) {
+  intensityRange = glm::vec2(std::min(min, max), std::max(min, max));
+}
+
+void PointFilter::setClassificationRange(int min, int max) {
+  classificationRange = glm::ivec2(std::min(min, max), std::max(min, max));
+}
+
+void PointFilter::setEveryNth(std::uint64_t n) {
+  everyNth = std::max<std::uint64_t>(1, n);
+}
+
+bool PointFilter::isActive() const {
+  return box || polygon.size() >= 3 || intensityRange || classificationRange ||
+         everyNth > 1;
+}
+
+bool PointFilter::needsIntensity() const {
+  return intensityRange.has_value();
+}
+
+bool PointFilter::needsClassification() const {
+  return classificationRange.has_value();
+}
+
+bool PointFilter::acceptsRow(std::uint64_t rowIdx) const {
+  return rowIdx % everyNth == 0;
+}
+
+bool PointFilter::acceptsPosition(const glm::vec3& position) const {
+  if (box && (glm::any(glm::lessThan(position, box->min)) ||
+              glm::any(glm::greaterThan(position, box->max)))) {
+    return false;
+  }
+
+  if (polygon.size() >= 3) {
+    if (glm::any(glm::lessThan(position, polygonBounds.min)) ||
+        glm::any(glm::greaterThan(position, polygonBounds.max))) {
+      return false;
+    }
+    return insidePolygon(glm::vec2(position));
+  }
+
+  return true;
+}
+
+bool PointFilter::acceptsIntensity(float intensity) const {
+  return !intensityRange ||
+         (intensity >= intensityRange->x && intensity <= intensityRange->y);
+}
+
+bool PointFilter::acceptsClassification(int classification) const {
+  return !classificationRange ||
+         (classification >= classificationRange->x &&
+          classification <= classificationRange->y);
+}
+
+// even-odd rule: count crossings of a ray cast along +x
+bool PointFilter::insidePolygon(const glm::vec2& point) const {
+  bool inside = false;
+  for (std::size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+    const glm::vec2& a = polygon[i];
+    const glm::vec2& b = polygon[j];
+    if ((a.y > point.y) != (b.y > point.y) &&
+        point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+void PointFilter::describe(std::ostream& os) const {
+  if (box) {
+    os << "  - Crop box (" << box->min.x << ", " << box->min.y << ", " << box->min.z
+       << ") to (" << box->max.x << ", " << box->max.y << ", " << box->max.z << ")\n";
+  }
+  if (polygon.size() >= 3) {
+    os << "  - Crop polygon with " << polygon.size() << " vertices, z "
+       << polygonBounds.min.z << " to " << polygonBounds.max.z << "\n";
+  }
+  if (intensityRange) {
+    os << "  - Intensity " << intensityRange->x << " to " << intensityRange->y << "\n";
+  }
+  if (classificationRange) {
+    os << "  - Classification " << classificationRange->x << " to "
+       << classificationRange->y << "\n";
+  }
+  if (everyNth > 1) {
+    os << "  - Every " << everyNth << "th point\n";
+  }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Crop and attribute filters evaluated by the readers while they decode, so
+// rejected points are never stored. Checks are ordered cheapest first:
+// row decimation, then position, then attributes, which readers only decode
+// when a filter needs them.
+class PointFilter {
+ public:
+  PointFilter();
+
+  void setBox(const glm::vec3& min, const glm::vec3& max);
+  // polygon on the xy plane, extruded between zMin and zMax
+  void setPolygon(const std::vector<glm::vec2>& vertices, float zMin, float zMax);
+  void setIntensityRange(float min, float max);
+  void setClassificationRange(int min, int max);
+  void setEveryNth(std::uint64_t n);
+
+  bool isActive() const;
+  bool needsIntensity() const;
+  bool needsClassification() const;
+
+  // `rowIdx` is the row's position in the file, so decimation does not depend
+  // on how the file is split into batches or threads
+  bool acceptsRow(std::uint64_t rowIdx) const;
+  bool acceptsPosition(const glm::vec3& position) const;
+  bool acceptsIntensity(float intensity) const;
+  bool acceptsClassification(int classification) const;
+
+  // Position and attribute checks for a decoded row. The attribute getters are
+  // only called if a range is set for them.
+  template <typename IntensityFn, typename ClassificationFn>
+  bool accepts(const glm::vec3& position, IntensityFn intensity,
+               ClassificationFn classification) const {
+    return acceptsPosition(position) &&
+           (!intensityRange || acceptsIntensity(intensity())) &&
+           (!classificationRange || acceptsClassification(classification()));
+  }
+
+  void describe(std::ostream& os) const;
+
+ private:
+  struct Box {
+    glm::vec3 min;
+    glm::vec3 max;
+  };
+
+  bool insidePolygon(const glm::vec2& point) const;
+
+  std::optional<Box> box;
+  std::vector<glm::vec2> polygon;
+  Box polygonBounds;  // extruded polygon's bounds, for early rejection
+  std::optional<glm::vec2> intensityRange;
+  std::optional<glm::ivec2> classificationRange;
+  std::uint64_t everyNth;
+};
@@ -0,0 +1,77 @@
+#include <point-reader/point-reader.h>
+
+std::size_t PointBatch::size() const {
+  return positions.size();
+}
+
+void PointBatch::clear() {
+  positions.clear();
+  colours.clear();
+  intensities.clear();
+  classifications.clear();
+  normals.clear();
+}
+
+void PointBatch::truncate(std::size_t size) {
+  if (size >= this->size()) return;
+  positions.resize(size);
+  if (!colours.empty()) colours.resize(size);
+  if (!intensities.empty()) intensities.resize(size);
+  if (!classifications.empty()) classifications.resize(size);
+  if (!normals.empty()) normals.resize(size);
+}
+
+AttributeSet PointBatch::getAttributes() const {
+  AttributeSet attributes;
+  attributes.colours = !colours.empty();
+  attributes.intensities = !intensities.empty();
+  attributes.classifications = !classifications.empty();
+  attributes.normals = !normals.empty();
+  return attributes;
+}
+
+void PointBatch::append(const PointBatch& other) {
+  positions.insert(positions.end(), other.positions.begin(), other.positions.end());
+  colours.insert(colours.end(), other.colours.begin(), other.colours.end());
+  intensities.insert(intensities.end(), other.intensities.begin(), other.intensities.end());
+  classifications.insert(classifications.end(), other.classifications.begin(),
+                         other.classifications.end());
+  normals.insert(normals.end(), other.normals.begin(), other.normals.end());
+}
+
+void PointBatch::append(const PointBatch& other, std::size_t idx) {
+  positions.push_back(other.positions[idx]);
+  if (!other.colours.empty()) colours.push_back(other.colours[idx]);
+  if (!other.intensities.empty()) intensities.push_back(other.intensities[idx]);
+  if (!other.classifications.empty()) classifications.push_back(other.classifications[idx]);
+  if (!other.normals.empty()) normals.push_back(other.normals[idx]);
+}
+
+void PointBatch::assign(std::size_t slot, const PointBatch& other, std::size_t idx) {
+  positions[slot] = other.positions[idx];
+  if (!other.colours.empty()) colours[slot] = other.colours[idx];
+  if (!other.intensities.empty()) intensities[slot] = other.intensities[idx];
+  if (!other.classifications.empty()) classifications[slot] = other.classifications[idx];
+  if (!other.normals.empty()) normals[slot] = other.normals[idx];
+}
+
+AttributeSet PointReader::getAvailableAttributes() const {
+  AttributeSet available;
+  available.colours = hasColours();
+  available.intensities = hasIntensities();
+  available.classifications = hasClassifications();
+  available.normals = hasNormals();
+  return available;
+}
+
+const std::vector<std::string>& PointReader::getUnreadFields() const {
+  return unreadFields;
+}
+
+void PointReader::setFilter(const PointFilter* filter) {
+  this->filter = filter;
+}
+
+void PointReader::setAttributes(const AttributeSet& attributes) {
+  this->attributes = attributes;
+}
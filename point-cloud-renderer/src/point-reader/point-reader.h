@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <point-filter/point-filter.h>
+
+// Per-point attributes besides the position.
+struct AttributeSet {
+  bool colours = true;
+  bool intensities = false;
+  bool classifications = false;
+  bool normals = false;
+};
+
+// A run of decoded points handed from a reader to whatever consumes it. Each
+// attribute column is empty unless the source has the attribute and it was
+// requested, see PointReader::setAttributes().
+struct PointBatch {
+  std::vector<glm::vec3> positions;
+  std::vector<glm::u8vec3> colours;
+  std::vector<float> intensities;
+  std::vector<std::uint8_t> classifications;
+  std::vector<glm::i8vec3> normals;  // unit normals scaled to [-127, 127]
+
+  std::size_t size() const;
+  void clear();
+  void truncate(std::size_t size);  // keeps the first `size` points
+  AttributeSet getAttributes() const;  // the columns held, if not empty
+  // appends every point of `other`, which must hold the same columns
+  void append(const PointBatch& other);
+  // Appends point `idx` of `other`, or overwrites point `slot` with it. Only
+  // the columns `other` holds are copied.
+  void append(const PointBatch& other, std::size_t idx);
+  void assign(std::size_t slot, const PointBatch& other, std::size_t idx);
+};
+
+// Streaming interface shared by the file readers: points are pulled in
+// bounded batches so callers can process files larger than memory.
+class PointReader {
+ public:
+  // points per batch used by the loaders when streaming
+  static constexpr std::size_t defaultBatchSize = 1 << 16;
+
+  virtual ~PointReader() = default;
+
+  virtual bool valid() const = 0;
+  virtual const std::string& getError() const = 0;
+
+  // point count declared by the file header
+  virtual std::size_t getNumPoints() const = 0;
+  virtual bool hasColours() const = 0;
+  virtual bool hasIntensities() const = 0;
+  virtual bool hasClassifications() const = 0;
+  virtual bool hasNormals() const = 0;
+  AttributeSet getAvailableAttributes() const;
+  // Fields of the file no attribute is read from, e.g. the return number or
+  // GPS time of a scan, which no point schema stores.
+  const std::vector<std::string>& getUnreadFields() const;
+
+  // Attributes to decode, of those the file has; colours only by default
+  void setAttributes(const AttributeSet& attributes);
+
+  // Rows rejected by `filter` are consumed without being appended. The filter
+  // must outlive the reads it applies to; nullptr disables filtering.
+  void setFilter(const PointFilter* filter);
+
+  // Consumes up to `maxPoints` rows of the file and appends the points they
+  // hold to `batch`. Rows a reader rejects (e.g. the NaN holes of organized
+  // clouds) are consumed without being appended. Returns the number of rows
+  // consumed, which is 0 once the data is exhausted or on error (check
+  // valid() to tell the two apart).
+  virtual std::size_t readBatch(PointBatch& batch, std::size_t maxPoints) = 0;
+
+  // restarts streaming from the first point
+  virtual bool rewind() = 0;
+
+ protected:
+  const PointFilter* filter = nullptr;
+  AttributeSet attributes;
+  std::vector<std::string> unreadFields;  // set by the reader's header parsing
+};
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <point-sampler/point-sampler.h>
+
+namespace {
+
+  // splitmix64 finaliser: cheap, well-mixed 64-bit hash
+  std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+  }
+
+  std::uint32_t floatBits(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+  }
+
+  // each coarsening step grows the voxel edge by this factor; small steps keep
+  // the final count close to the budget instead of dropping by up to 8x
+  constexpr float voxelGrowth = 1.25f;
+  // The first grid puts a few cells per budgeted point across the first batch,
+  // assuming the points lie on surfaces as scans do. Starting too fine only
+  // costs extra coarsening steps, while starting too coarse wastes budget.
+  constexpr float initialCellsPerPoint = 4.f;
+
+}  // namespace
+
+std::optional<PointSampler::Mode> PointSampler::parseMode(const std::string& name) {
+  if (name == "first") return Mode::First;
+  if (name == "stride") return Mode::Stride;
+  if (name == "reservoir") return Mode::Reservoir;
+  if (name == "voxel") return Mode::Voxel;
+  return std::nullopt;
+}
+
+const char* PointSampler::getModeName(Mode mode) {
+  switch (mode) {
+    case Mode::First:
+      return "first";
+    case Mode::Stride:
+      return "stride";
+    case Mode::Reservoir:
+      return "reservoir";
+    default:
+      return "voxel";
+  }
+}
+
+PointSampler::PointSampler(Mode mode, std::size_t budget,
+                           std::optional<std::uint64_t> totalPoints,
+                           const AttributeSet& attributes, std::uint64_t seed)
+    : mode(mode),
+      budget(std::max<std::size_t>(1, budget)),
+      totalPoints(totalPoints),
+      seed(seed),
+      pointsSeen(0),
+      rng(seed),
+      reservoirW(0.0),
+      nextReservoirIdx(0),
+      strideAccumulator(totalPoints && *totalPoints > 0 ? seed % *totalPoints : 0),
+      strideStep(1),
+      cellSize(0.f) {
+  const std::size_t expected =
+      totalPoints ? std::min<std::uint64_t>(this->budget, *totalPoints) : this->budget;
+  points.positions.reserve(expected);
+  if (attributes.colours) points.colours.reserve(expected);
+  if (attributes.intensities) points.intensities.reserve(expected);
+  if (attributes.classifications) points.classifications.reserve(expected);
+  if (attributes.normals) points.normals.reserve(expected);
+}
+
+void PointSampler::add(const PointBatch& batch) {
+  switch (mode) {
+    case Mode::First:
+      for (std::size_t i = 0; i < batch.size() && !isSaturated(); i++) {
+        points.append(batch, i);
+      }
+      break;
+    case Mode::Stride:
+      addStride(batch);
+      break;
+    case Mode::Reservoir:
+      addReservoir(batch);
+      break;
+    case Mode::Voxel:
+      addVoxel(batch);
+      break;
+  }
+  pointsSeen += batch.size();
+}
+
+bool PointSampler::isSaturated() const {
+  return mode == Mode::First && points.size() >= budget;
+}
+
+std::size_t PointSampler::getNumPoints() const {
+  return points.size();
+}
+
+std::uint64_t PointSampler::getPointsSeen() const {
+  return pointsSeen;
+}
+
+void PointSampler::finish(PointBatch& points) {
+  points = std::move(this->points);
+  cells.clear();
+  priorities.clear();
+}
+
+void PointSampler::addStride(const PointBatch& batch) {
+  if (!totalPoints) {
+    for (std::size_t i = 0; i < batch.size(); i++) {
+      const std::uint64_t idx = pointsSeen + i;
+      if (idx % strideStep != 0) continue;
+      if (points.size() == budget) {
+        // the kept indices are multiples of the step, so every other one
+        // from the first is a multiple of twice the step
+        const std::size_t kept = points.size();
+        for (std::size_t slot = 0; slot * 2 < kept; slot++) {
+          points.assign(slot, points, slot * 2);
+        }
+        points.truncate((kept + 1) / 2);
+        strideStep *= 2;
+        if (idx % strideStep != 0) continue;
+      }
+      points.append(batch, i);
+    }
+    return;
+  }
+
+  for (std::size_t i = 0; i < batch.size(); i++) {
+    if (*totalPoints <= budget) {
+      if (points.size() < budget) points.append(batch, i);
+      continue;
+    }
+
+    strideAccumulator += budget;
+    if (strideAccumulator >= *totalPoints) {
+      strideAccumulator -= *totalPoints;
+      if (points.size() < budget) points.append(batch, i);
+    }
+  }
+}
+
+void PointSampler::addReservoir(const PointBatch& batch) {
+  // uniform in (0, 1]; log() of it is always finite
+  auto random = [this]() {
+    return 1.0 - std::generate_canonical<double, std::numeric_limits<double>::digits>(rng);
+  };
+  auto skip = [this, &random]() {
+    return static_cast<std::uint64_t>(std::floor(std::log(random()) / std::log(1.0 - reservoirW)));
+  };
+
+  const double k = static_cast<double>(budget);
+
+  for (std::size_t i = 0; i < batch.size(); i++) {
+    const std::uint64_t idx = pointsSeen + i;
+
+    if (points.size() < budget) {
+      points.append(batch, i);
+      if (points.size() == budget) {
+        reservoirW = std::exp(std::log(random()) / k);
+        nextReservoirIdx = idx + skip() + 1;
+      }
+      continue;
+    }
+
+    if (idx != nextReservoirIdx) continue;
+
+    points.assign(static_cast<std::size_t>(random() * k) % budget, batch, i);
+    reservoirW *= std::exp(std::log(random()) / k);
+    nextReservoirIdx = idx + skip() + 1;
+  }
+}
+
+std::uint64_t PointSampler::getCellKey(const glm::vec3& position) const {
+  const std::int64_t x = static_cast<std::int64_t>(std::floor(position.x / cellSize));
+  const std::int64_t y = static_cast<std::int64_t>(std::floor(position.y / cellSize));
+  const std::int64_t z = static_cast<std::int64_t>(std::floor(position.z / cellSize));
+  return mix(mix(mix(static_cast<std::uint64_t>(x)) ^ static_cast<std::uint64_t>(y)) ^
+             static_cast<std::uint64_t>(z));
+}
+
+// Each cell keeps the point with the lowest seeded hash, so the result does not
+// depend on the order points arrive in.
+std::uint32_t PointSampler::getPriority(const glm::vec3& position) const {
+  std::uint64_t h = seed;
+  h = mix(h ^ floatBits(position.x));
+  h = mix(h ^ floatBits(position.y));
+  h = mix(h ^ floatBits(position.z));
+  return static_cast<std::uint32_t>(h >> 32);
+}
+
+void PointSampler::addVoxel(const PointBatch& batch) {
+  if (batch.size() == 0) return;
+
+  if (cellSize <= 0.f) {
+    glm::vec3 min = batch.positions[0];
+    glm::vec3 max = batch.positions[0];
+    for (const glm::vec3& position : batch.positions) {
+      min = glm::min(min, position);
+      max = glm::max(max, position);
+    }
+    const glm::vec3 extent = max - min;
+    const float maxExtent = std::max(extent.x, std::max(extent.y, extent.z));
+    const float cellsPerAxis = std::sqrt(static_cast<float>(budget) * initialCellsPerPoint);
+    cellSize = maxExtent > 0.f ? maxExtent / cellsPerAxis : 1e-3f;
+  }
+
+  for (std::size_t i = 0; i < batch.size(); i++) {
+    const glm::vec3& position = batch.positions[i];
+    const std::uint32_t priority = getPriority(position);
+
+    auto [cell, inserted] = cells.try_emplace(getCellKey(position),
+                                              static_cast<std::uint32_t>(points.size()));
+    if (inserted) {
+      points.append(batch, i);
+      priorities.push_back(priority);
+      if (cells.size() > budget) coarsenGrid();
+    } else if (priority < priorities[cell->second]) {
+      points.assign(cell->second, batch, i);
+      priorities[cell->second] = priority;
+    }
+  }
+}
+
+void PointSampler::coarsenGrid() {
+  while (cells.size() > budget) {
+    cellSize *= voxelGrowth;
+
+    PointBatch oldPoints = std::move(points);
+    std::vector<std::uint32_t> oldPriorities = std::move(priorities);
+    points.clear();
+    priorities.clear();
+    cells.clear();
+
+    for (std::size_t slot = 0; slot < oldPoints.size(); slot++) {
+      auto [cell, inserted] = cells.try_emplace(getCellKey(oldPoints.positions[slot]),
+                                                static_cast<std::uint32_t>(points.size()));
+      if (inserted) {
+        points.append(oldPoints, slot);
+        priorities.push_back(oldPriorities[slot]);
+      } else if (oldPriorities[slot] < priorities[cell->second]) {
+        points.assign(cell->second, oldPoints, slot);
+        priorities[cell->second] = oldPriorities[slot];
+      }
+    }
+  }
+}
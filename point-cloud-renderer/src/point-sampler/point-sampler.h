@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <point-reader/point-reader.h>
+
+// Picks at most `budget` points out of a stream in a single pass, holding no
+// more than `budget` points at any time.
+class PointSampler {
+ public:
+  enum class Mode {
+    First,      // the first points in file order
+    Stride,     // every n-th point, evenly spread over the file
+    Reservoir,  // a uniform random subset
+    Voxel,      // one point per cell of an adaptive grid (spatially uniform)
+  };
+
+  static constexpr std::uint64_t defaultSeed = 0x5eed;
+
+  static std::optional<Mode> parseMode(const std::string& name);
+  static const char* getModeName(Mode mode);
+
+  // `attributes` are the columns the batches passed to add() hold, and
+  // `totalPoints` their number, if known. Stride then keeps exactly `budget`
+  // of them. Unknown, e.g. behind filters, it keeps every n-th point and
+  // doubles n whenever the budget fills, dropping every other point kept, so
+  // it keeps more than half the budget.
+  PointSampler(Mode mode, std::size_t budget, std::optional<std::uint64_t> totalPoints,
+               const AttributeSet& attributes, std::uint64_t seed);
+
+  void add(const PointBatch& batch);
+
+  // true once further input cannot change the result (First mode only)
+  bool isSaturated() const;
+  std::size_t getNumPoints() const;
+  std::uint64_t getPointsSeen() const;  // points passed to add() so far
+
+  // Moves the selected points, with every column the input held, into `points`
+  void finish(PointBatch& points);
+
+ private:
+  void addReservoir(const PointBatch& batch);
+  void addStride(const PointBatch& batch);
+  void addVoxel(const PointBatch& batch);
+  std::uint64_t getCellKey(const glm::vec3& position) const;
+  std::uint32_t getPriority(const glm::vec3& position) const;
+  void coarsenGrid();
+
+  Mode mode;
+  std::size_t budget;
+  std::optional<std::uint64_t> totalPoints;
+  std::uint64_t seed;
+  std::uint64_t pointsSeen;
+
+  PointBatch points;
+
+  // reservoir: Li's "Algorithm L" skip state
+  std::mt19937_64 rng;
+  double reservoirW;
+  std::uint64_t nextReservoirIdx;
+
+  // stride: Bresenham-style accumulator, keeps exactly `budget` of `totalPoints`
+  std::uint64_t strideAccumulator;
+  // stride without totalPoints: points are kept whose index is a multiple
+  std::uint64_t strideStep;
+
+  // voxel: cell key -> slot in points, plus each slot's priority
+  float cellSize;
+  std::unordered_map<std::uint64_t, std::uint32_t> cells;
+  std::vector<std::uint32_t> priorities;
+};
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <point-reader/point-reader.h>
+
+// The per-point attributes a node can store: each names the PointBatch column
+// it is read from, how a value of it is encoded for storage, its vertex layout
+// and the shader define that enables it. Locations are fixed, so the one
+// vertex shader serves every schema.
+namespace attribute {
+
+  // an attribute stored as it is read
+  template <typename T>
+  struct Unencoded {
+    using Type = T;
+    using Source = T;
+    static Type encode(Source value) { return value; }
+  };
+
+  struct Position : Unencoded<glm::vec3> {
+    static constexpr std::vector<Source> PointBatch::*column = &PointBatch::positions;
+    static constexpr unsigned int location = 0;
+    static constexpr int components = 3;
+    static constexpr GLenum glType = GL_FLOAT;
+    static constexpr bool isNormalized = false;
+    static constexpr bool isInteger = false;
+    static constexpr const char* define = "";
+    static constexpr const char* name = "position";
+    static Source getDefault() { return Type(0.f); }
+  };
+
+  struct Colour : Unencoded<glm::u8vec3> {
+    static constexpr std::vector<Source> PointBatch::*column = &PointBatch::colours;
+    static constexpr unsigned int location = 1;
+    static constexpr int components = 3;
+    static constexpr GLenum glType = GL_UNSIGNED_BYTE;
+    static constexpr bool isNormalized = true;
+    static constexpr bool isInteger = false;
+    static constexpr const char* define = "#define HAS_COLOUR\n";
+    static constexpr const char* name = "rgb";
+    static Source getDefault() { return Type(255); }
+  };
+
+  // Stored as a half float, which unlike a normalised integer needs no range
+  // known before the first point is read. Integer intensities are exact up to
+  // 2048 and within 0.05% above; the 16 bit scale's top values are clamped.
+  struct Intensity {
+    using Type = std::uint16_t;
+    using Source = float;
+    static constexpr std::vector<Source> PointBatch::*column = &PointBatch::intensities;
+    static constexpr unsigned int location = 2;
+    static constexpr int components = 1;
+    static constexpr GLenum glType = GL_HALF_FLOAT;
+    static constexpr bool isNormalized = false;
+    static constexpr bool isInteger = false;
+    static constexpr const char* define = "#define HAS_INTENSITY\n";
+    static constexpr const char* name = "intensity";
+    static Source getDefault() { return 0.f; }
+    static constexpr float maxValue = 65504.f;  // the largest finite half float
+    static Type encode(Source value) {
+      return glm::packHalf1x16(glm::clamp(value, -maxValue, maxValue));
+    }
+    static Source decode(Type value) { return glm::unpackHalf1x16(value); }
+  };
+
+  struct Classification : Unencoded<std::uint8_t> {
+    static constexpr std::vector<Source> PointBatch::*column = &PointBatch::classifications;
+    static constexpr unsigned int location = 3;
+    static constexpr int components = 1;
+    static constexpr GLenum glType = GL_UNSIGNED_BYTE;
+    static constexpr bool isNormalized = false;
+    static constexpr bool isInteger = true;  // a uint in the shader
+    static constexpr const char* define = "#define HAS_CLASSIFICATION\n";
+    static constexpr const char* name = "classification";
+    static Source getDefault() { return 0; }
+  };
+
+  struct Normal : Unencoded<glm::i8vec3> {
+    static constexpr std::vector<Source> PointBatch::*column = &PointBatch::normals;
+    static constexpr unsigned int location = 4;
+    static constexpr int components = 3;
+    static constexpr GLenum glType = GL_BYTE;
+    static constexpr bool isNormalized = true;
+    static constexpr bool isInteger = false;
+    static constexpr const char* define = "#define HAS_NORMAL\n";
+    static constexpr const char* name = "normal";
+    static Source getDefault() { return Type(0, 0, 127); }
+  };
+
+}  // namespace attribute
+
+// A compile-time set of attributes, always starting with the position. Code
+// templated on a schema stores one tightly packed array per attribute it
+// holds and nothing for those it doesn't, and its per-point loops expand over
+// the attributes at compile time instead of testing for each at run time.
+// The attribute types are distinct, so a point's values are found by type.
+template <typename... Attributes>
+struct PointSchema {
+  static_assert(std::is_same_v<std::tuple_element_t<0, std::tuple<Attributes...>>,
+                               attribute::Position>,
+                "a schema starts with the position");
+
+  using Point = std::tuple<typename Attributes::Type...>;
+
+  template <typename Attribute>
+  static constexpr bool has = (std::is_same_v<Attribute, Attributes> || ...);
+
+  static constexpr std::size_t numAttributes = sizeof...(Attributes);
+  static constexpr std::size_t pointBytes = (sizeof(typename Attributes::Type) + ...);
+
+  template <typename Attribute>
+  static typename Attribute::Type& get(Point& point) {
+    return std::get<typename Attribute::Type>(point);
+  }
+  template <typename Attribute>
+  static const typename Attribute::Type& get(const Point& point) {
+    return std::get<typename Attribute::Type>(point);
+  }
+
+  static AttributeSet getAttributes() {
+    AttributeSet attributes;
+    attributes.colours = has<attribute::Colour>;
+    attributes.intensities = has<attribute::Intensity>;
+    attributes.classifications = has<attribute::Classification>;
+    attributes.normals = has<attribute::Normal>;
+    return attributes;
+  }
+
+  static bool matches(const AttributeSet& attributes) {
+    const AttributeSet own = getAttributes();
+    return own.colours == attributes.colours && own.intensities == attributes.intensities &&
+           own.classifications == attributes.classifications &&
+           own.normals == attributes.normals;
+  }
+
+  // shader source lines enabling the schema's attributes
+  static std::string getDefines() {
+    return (std::string() + ... + Attributes::define);
+  }
+
+  static std::string getName() {
+    std::string name;
+    ((name += (name.empty() ? "" : ", ") + std::string(Attributes::name)), ...);
+    return name;
+  }
+
+  // `batch` must hold every column of the schema, see fillMissing()
+  static Point getPoint(const PointBatch& batch, std::size_t idx) {
+    return Point(Attributes::encode((batch.*Attributes::column)[idx])...);
+  }
+
+  // Gives the columns of the schema that `batch` lacks, e.g. when it came
+  // from another file, their attribute's default value.
+  static void fillMissing(PointBatch& batch) {
+    const std::size_t size = batch.size();
+    auto fill = [size](auto& column, auto value) {
+      if (column.size() != size) column.assign(size, value);
+    };
+    (fill(batch.*Attributes::column, Attributes::getDefault()), ...);
+  }
+
+  // One array per attribute, for points stored column by column.
+  class Columns {
+   public:
+    std::size_t size() const { return get<attribute::Position>().size(); }
+    bool empty() const { return size() == 0; }
+
+    void push_back(const Point& point) {
+      (get<Attributes>().push_back(std::get<typename Attributes::Type>(point)), ...);
+    }
+    Point at(std::size_t idx) const { return Point(get<Attributes>()[idx]...); }
+    Point back() const { return Point(get<Attributes>().back()...); }
+    void pop_back() { (get<Attributes>().pop_back(), ...); }
+    void set(std::size_t idx, const Point& point) {
+      ((get<Attributes>()[idx] = std::get<typename Attributes::Type>(point)), ...);
+    }
+    void copyPoint(std::size_t from, std::size_t to) {
+      ((get<Attributes>()[to] = get<Attributes>()[from]), ...);
+    }
+    void append(const Columns& other) {
+      (get<Attributes>().insert(get<Attributes>().end(), other.get<Attributes>().begin(),
+                                other.get<Attributes>().end()),
+       ...);
+    }
+    void reserve(std::size_t capacity) { (get<Attributes>().reserve(capacity), ...); }
+    void clear() { (get<Attributes>().clear(), ...); }
+    void shrink_to_fit() { (get<Attributes>().shrink_to_fit(), ...); }
+    std::size_t getCapacityBytes() const {
+      return ((get<Attributes>().capacity() * sizeof(typename Attributes::Type)) + ...);
+    }
+
+    template <typename Attribute>
+    std::vector<typename Attribute::Type>& get() {
+      return std::get<std::vector<typename Attribute::Type>>(columns);
+    }
+    template <typename Attribute>
+    const std::vector<typename Attribute::Type>& get() const {
+      return std::get<std::vector<typename Attribute::Type>>(columns);
+    }
+
+   private:
+    std::tuple<std::vector<typename Attributes::Type>...> columns;
+  };
+};
+
+// Every schema the renderer is built for: the position plus any subset of the
+// other attributes. X is called with each schema's attribute list, e.g. to
+// explicitly instantiate a template for all of them.
+#define POINT_SCHEMAS(X)                                                                          \
+  X(attribute::Position)                                                                          \
+  X(attribute::Position, attribute::Colour)                                                       \
+  X(attribute::Position, attribute::Intensity)                                                    \
+  X(attribute::Position, attribute::Colour, attribute::Intensity)                                 \
+  X(attribute::Position, attribute::Classification)                                               \
+  X(attribute::Position, attribute::Colour, attribute::Classification)                            \
+  X(attribute::Position, attribute::Intensity, attribute::Classification)                         \
+  X(attribute::Position, attribute::Colour, attribute::Intensity, attribute::Classification)      \
+  X(attribute::Position, attribute::Normal)                                                       \
+  X(attribute::Position, attribute::Colour, attribute::Normal)                                    \
+  X(attribute::Position, attribute::Intensity, attribute::Normal)                                 \
+  X(attribute::Position, attribute::Colour, attribute::Intensity, attribute::Normal)              \
+  X(attribute::Position, attribute::Classification, attribute::Normal)                            \
+  X(attribute::Position, attribute::Colour, attribute::Classification, attribute::Normal)         \
+  X(attribute::Position, attribute::Intensity, attribute::Classification, attribute::Normal)      \
+  X(attribute::Position, attribute::Colour, attribute::Intensity, attribute::Classification,      \
+    attribute::Normal)
+
+// Calls `fn` with a value of the schema holding exactly `attributes`, so a
+// run-time choice selects code compiled for that schema. Returns its result.
+template <typename Fn>
+auto dispatchSchema(const AttributeSet& attributes, Fn&& fn) {
+#define DISPATCH_SCHEMA(...)                                   \
+  if (PointSchema<__VA_ARGS__>::matches(attributes)) {         \
+    return fn(PointSchema<__VA_ARGS__>());                     \
+  }
+  POINT_SCHEMAS(DISPATCH_SCHEMA)
+#undef DISPATCH_SCHEMA
+  // every combination is listed, so this is never reached
+  return fn(PointSchema<attribute::Position>());
+}
@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <parallel/parallel.h>
+#include <point-stats/point-stats.h>
+
+namespace {
+
+  // points sampled for the histograms' range before the pass
+  constexpr std::size_t histogramSamplePoints = 4096;
+
+  std::uint32_t floatBits(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+  }
+
+  int getSpacingBin(float distanceSquared) {
+    return static_cast<int>(floatBits(distanceSquared) >>
+                            (23 - PointStats::spacingMantissaBits));
+  }
+
+  bool isFinite(const glm::vec3& position) {
+    return std::isfinite(position.x) && std::isfinite(position.y) && std::isfinite(position.z);
+  }
+
+  // the histograms' layout, fixed before the pass so ranges can be merged
+  struct HistogramRange {
+    glm::vec3 min;
+    glm::vec3 binScale;  // bins per unit
+  };
+
+  HistogramRange getHistogramRange(const std::vector<glm::vec3>& positions,
+                                   glm::vec3& sampleMin, glm::vec3& sampleMax) {
+    const std::size_t stride =
+        std::max<std::size_t>(1, positions.size() / histogramSamplePoints);
+    sampleMin = glm::vec3(std::numeric_limits<float>::max());
+    sampleMax = glm::vec3(std::numeric_limits<float>::lowest());
+    for (std::size_t i = 0; i < positions.size(); i += stride) {
+      if (!isFinite(positions[i])) continue;
+      sampleMin = glm::min(sampleMin, positions[i]);
+      sampleMax = glm::max(sampleMax, positions[i]);
+    }
+    // every sampled point was NaN or infinite
+    if (glm::any(glm::greaterThan(sampleMin, sampleMax))) sampleMin = sampleMax = glm::vec3(0.f);
+
+    const glm::vec3 extent = sampleMax - sampleMin;
+    HistogramRange range;
+    range.min = sampleMin;
+    for (int axis = 0; axis < 3; axis++) {
+      range.binScale[axis] = extent[axis] > 0.f ? PointStats::histogramBins / extent[axis] : 0.f;
+    }
+    return range;
+  }
+
+  // Adds one point to the bounds, histograms and spacing of `stats`;
+  // `previous` is null for a range's first point in the file. Points with a
+  // NaN or infinite coordinate are left out, as are distances to them.
+  void addPosition(const glm::vec3& position, const glm::vec3* previous,
+                   const HistogramRange& range, PointStats& stats) {
+    if (!isFinite(position)) return;
+    stats.min = glm::min(stats.min, position);
+    stats.max = glm::max(stats.max, position);
+    for (int axis = 0; axis < 3; axis++) {
+      const float bin = (position[axis] - range.min[axis]) * range.binScale[axis];
+      stats.histograms[axis][static_cast<int>(
+          std::clamp(bin, 0.f, PointStats::histogramBins - 1.f))]++;
+    }
+    if (previous && isFinite(*previous)) {
+      const glm::vec3 offset = position - *previous;
+      stats.spacingHistogram[getSpacingBin(glm::dot(offset, offset))]++;
+    }
+  }
+
+  void addPositions(const std::vector<glm::vec3>& positions, std::size_t begin,
+                    std::size_t end, const HistogramRange& range, PointStats& stats) {
+    std::size_t i = begin;
+#if defined(__SSE2__)
+    // One point per iteration, its coordinates in three lanes: the bounds,
+    // bins and offsets of x, y and z are found at once, but the histogram
+    // counts are still added one by one. Each point is loaded with the next
+    // point's x in the fourth lane, which the masks and the final stores
+    // ignore; the array's last point, whose load would overrun, is left to
+    // the scalar loop. Four points at a time, one register per coordinate,
+    // measured slower: the adds to the histograms dominate either way, and
+    // the transposes and per-lane masks cost more than the rest saves.
+    const std::size_t vectorEnd = std::min(end, positions.size() - 1);
+    if (i < vectorEnd) {
+      const float* data = &positions[0].x;
+      __m128 min = _mm_set1_ps(std::numeric_limits<float>::max());
+      __m128 max = _mm_set1_ps(std::numeric_limits<float>::lowest());
+      const __m128 histogramMin = _mm_setr_ps(range.min.x, range.min.y, range.min.z, 0.f);
+      const __m128 binScale =
+          _mm_setr_ps(range.binScale.x, range.binScale.y, range.binScale.z, 0.f);
+      const __m128 lastBin = _mm_set1_ps(PointStats::histogramBins - 1.f);
+      const __m128 xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+      __m128 previous = i > 0 ? _mm_loadu_ps(data + 3 * (i - 1)) : _mm_setzero_ps();
+      bool hasPrevious = i > 0 && isFinite(positions[i - 1]);
+
+      alignas(16) std::int32_t bins[4];
+      alignas(16) float squares[4];
+      for (; i < vectorEnd; i++) {
+        const __m128 position = _mm_loadu_ps(data + 3 * i);
+        // only finite lanes are left zero by subtracting themselves
+        const __m128 finite = _mm_cmpeq_ps(_mm_sub_ps(position, position), _mm_setzero_ps());
+        if ((_mm_movemask_ps(finite) & 7) != 7) {
+          hasPrevious = false;
+          continue;
+        }
+        min = _mm_min_ps(min, position);
+        max = _mm_max_ps(max, position);
+
+        __m128 bin = _mm_mul_ps(_mm_sub_ps(position, histogramMin), binScale);
+        bin = _mm_min_ps(_mm_max_ps(bin, _mm_setzero_ps()), lastBin);
+        _mm_store_si128(reinterpret_cast<__m128i*>(bins), _mm_cvttps_epi32(bin));
+        stats.histograms[0][bins[0]]++;
+        stats.histograms[1][bins[1]]++;
+        stats.histograms[2][bins[2]]++;
+
+        if (hasPrevious) {
+          const __m128 offset = _mm_and_ps(_mm_sub_ps(position, previous), xyzMask);
+          _mm_store_ps(squares, _mm_mul_ps(offset, offset));
+          stats.spacingHistogram[getSpacingBin(squares[0] + squares[1] + squares[2])]++;
+        }
+        previous = position;
+        hasPrevious = true;
+      }
+
+      alignas(16) float lanes[4];
+      _mm_store_ps(lanes, min);
+      stats.min = glm::min(stats.min, glm::vec3(lanes[0], lanes[1], lanes[2]));
+      _mm_store_ps(lanes, max);
+      stats.max = glm::max(stats.max, glm::vec3(lanes[0], lanes[1], lanes[2]));
+    }
+#endif
+    for (; i < end; i++) {
+      addPosition(positions[i], i > 0 ? &positions[i - 1] : nullptr, range, stats);
+    }
+  }
+
+  void merge(PointStats& stats, const PointStats& other) {
+    stats.numPoints += other.numPoints;
+    stats.min = glm::min(stats.min, other.min);
+    stats.max = glm::max(stats.max, other.max);
+    for (int axis = 0; axis < 3; axis++) {
+      for (int bin = 0; bin < PointStats::histogramBins; bin++) {
+        stats.histograms[axis][bin] += other.histograms[axis][bin];
+      }
+    }
+    for (int bin = 0; bin < PointStats::spacingBins; bin++) {
+      stats.spacingHistogram[bin] += other.spacingHistogram[bin];
+    }
+    stats.intensityRange = glm::vec2(std::min(stats.intensityRange.x, other.intensityRange.x),
+                                     std::max(stats.intensityRange.y, other.intensityRange.y));
+    stats.hasColourVariation = stats.hasColourVariation || other.hasColourVariation;
+  }
+
+}  // namespace
+
+PointStats PointStats::compute(const PointBatch& points) {
+  PointStats stats;
+  stats.numPoints = points.size();
+  if (stats.numPoints == 0) return stats;
+
+  glm::vec3 sampleMin;
+  glm::vec3 sampleMax;
+  const HistogramRange range = getHistogramRange(points.positions, sampleMin, sampleMax);
+  stats.histogramMin = sampleMin;
+  stats.histogramMax = sampleMax;
+
+  // every column is swept by the same ranges, one thread each, and the
+  // partial stats merged after
+  std::vector<PointStats> partials(parallel::getRangeCount(stats.numPoints));
+  parallel::forEachRange(stats.numPoints, [&](std::size_t begin, std::size_t end,
+                                              unsigned int rangeIdx) {
+    PointStats& partial = partials[rangeIdx];
+    partial.numPoints = end - begin;
+    partial.min = glm::vec3(std::numeric_limits<float>::max());
+    partial.max = glm::vec3(std::numeric_limits<float>::lowest());
+    addPositions(points.positions, begin, end, range, partial);
+
+    if (!points.intensities.empty()) {
+      float min = std::numeric_limits<float>::max();
+      float max = std::numeric_limits<float>::lowest();
+      for (std::size_t i = begin; i < end; i++) {
+        min = std::min(min, points.intensities[i]);
+        max = std::max(max, points.intensities[i]);
+      }
+      partial.intensityRange = glm::vec2(min, max);
+    } else {
+      partial.intensityRange = glm::vec2(std::numeric_limits<float>::max(),
+                                         std::numeric_limits<float>::lowest());
+    }
+
+    if (!points.colours.empty()) {
+      const glm::u8vec3 first = points.colours[0];
+      for (std::size_t i = begin; i < end && !partial.hasColourVariation; i++) {
+        partial.hasColourVariation = points.colours[i] != first;
+      }
+    }
+  });
+
+  stats.min = partials[0].min;
+  stats.max = partials[0].max;
+  stats.intensityRange = partials[0].intensityRange;
+  stats.numPoints = 0;
+  for (const PointStats& partial : partials) {
+    merge(stats, partial);
+  }
+  if (points.intensities.empty()) stats.intensityRange = glm::vec2(0.f);
+  return stats;
+}
+
+glm::vec3 PointStats::getQuantile(float fraction) const {
+  const double target = fraction * static_cast<double>(numPoints);
+  glm::vec3 quantile;
+  for (int axis = 0; axis < 3; axis++) {
+    const float binWidth = (histogramMax[axis] - histogramMin[axis]) / histogramBins;
+    double count = 0.0;
+    int bin = 0;
+    while (bin < histogramBins - 1 && count + histograms[axis][bin] < target) {
+      count += histograms[axis][bin];
+      bin++;
+    }
+    // interpolated within the bin
+    const double inBin =
+        histograms[axis][bin] > 0 ? (target - count) / histograms[axis][bin] : 0.0;
+    quantile[axis] = histogramMin[axis] +
+                     binWidth * (bin + static_cast<float>(std::min(inBin, 1.0)));
+  }
+  // the end bins also hold the points outside the sampled range
+  return glm::clamp(quantile, min, max);
+}
+
+float PointStats::getSpacing() const {
+  std::uint64_t total = 0;
+  // bin 0 holds the duplicates' zero distances
+  for (int bin = 1; bin < spacingBins; bin++) total += spacingHistogram[bin];
+  if (total == 0) return 0.f;
+
+  std::uint64_t count = 0;
+  for (int bin = 1; bin < spacingBins; bin++) {
+    count += spacingHistogram[bin];
+    if (count * 2 >= total) {
+      // the squared distance at the middle of the bin
+      const std::uint32_t bits =
+          (static_cast<std::uint32_t>(bin) << (23 - spacingMantissaBits)) |
+          (1u << (22 - spacingMantissaBits));
+      float distanceSquared;
+      std::memcpy(&distanceSquared, &bits, sizeof(distanceSquared));
+      const float spacing = std::sqrt(distanceSquared);
+
+      // the widest even spread: along the longest axis, over the two longest
+      // or through the whole box, whichever leaves the most room per point
+      glm::vec3 extent = max - min;
+      std::sort(&extent[0], &extent[0] + 3, std::greater<float>());
+      const double n = static_cast<double>(numPoints);
+      const double evenSpacing = std::max({extent[0] / n, std::sqrt(extent[0] * extent[1] / n),
+                                           std::cbrt(extent[0] * extent[1] * extent[2] / n)});
+      return spacing <= 2.0 * evenSpacing ? spacing : 0.f;
+    }
+  }
+  return 0.f;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include <point-reader/point-reader.h>
+
+// Summary of a loaded cloud, gathered in one multithreaded pass over its
+// columns so later stages reuse it instead of each rescanning the arrays.
+struct PointStats {
+  static constexpr int histogramBins = 256;
+  // Distances between consecutive points are binned by the exponent and top
+  // 3 mantissa bits of their square, i.e. 4 bins an octave of distance.
+  static constexpr int spacingMantissaBits = 3;
+  static constexpr int spacingBins = 256 << spacingMantissaBits;
+
+  std::size_t numPoints = 0;
+  glm::vec3 min = glm::vec3(0.f);
+  glm::vec3 max = glm::vec3(0.f);
+  // Per axis point counts over [histogramMin, histogramMax], taken from a
+  // sample before the pass since the bounds are only known after it. Points
+  // outside fall in the end bins.
+  std::array<std::array<std::uint64_t, histogramBins>, 3> histograms{};
+  glm::vec3 histogramMin = glm::vec3(0.f);
+  glm::vec3 histogramMax = glm::vec3(0.f);
+  std::array<std::uint64_t, spacingBins> spacingHistogram{};
+  glm::vec2 intensityRange = glm::vec2(0.f);
+  // false if every point has the same colour, or there are no colours
+  bool hasColourVariation = false;
+
+  static PointStats compute(const PointBatch& points);
+
+  // per axis, the coordinate below which `fraction` of the points lie
+  glm::vec3 getQuantile(float fraction) const;
+  // Median distance between points consecutive in the file, ignoring
+  // duplicates. Scanners write points in scan order, so it estimates the
+  // point spacing; 0 if every point is a duplicate, or if the median is
+  // wider than the points would be spread evenly through the bounds, as
+  // only files not written in a spatial order give.
+  float getSpacing() const;
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+
+namespace resources {
+  // Peak resident set size of the process so far, in bytes. Returns 0 where
+  // the platform does not report it.
+  std::size_t getPeakRSS();
+}
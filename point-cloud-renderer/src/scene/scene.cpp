@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <utility>
+
+#include <scene/scene.h>
+
+template <typename Schema>
+void Scene<Schema>::add(OctreeNode<Schema>&& octree, const glm::mat4& modelMatrix) {
+  trees.push_back({std::make_unique<OctreeNode<Schema>>(std::move(octree)), modelMatrix});
+}
+
+template <typename Schema>
+std::size_t Scene<Schema>::getNumTrees() const {
+  return trees.size();
+}
+
+template <typename Schema>
+OctreeNode<Schema>& Scene<Schema>::getTree(std::size_t idx) {
+  return *trees[idx].octree;
+}
+
+template <typename Schema>
+const OctreeNode<Schema>& Scene<Schema>::getTree(std::size_t idx) const {
+  return *trees[idx].octree;
+}
+
+template <typename Schema>
+const glm::mat4& Scene<Schema>::getModelMatrix(std::size_t idx) const {
+  return trees[idx].modelMatrix;
+}
+
+template <typename Schema>
+std::uint64_t Scene<Schema>::getNodeCount() const {
+  std::uint64_t count = 0;
+  for (const Tree& tree : trees) {
+    count += tree.octree->getNodeCount();
+  }
+  return count;
+}
+
+template <typename Schema>
+unsigned int Scene<Schema>::getMaxDepth() const {
+  unsigned int maxDepth = 0;
+  for (const Tree& tree : trees) {
+    maxDepth = std::max(maxDepth, tree.octree->getMaxDepth());
+  }
+  return maxDepth;
+}
+
+template <typename Schema>
+std::uint64_t Scene<Schema>::submit(const std::vector<DrawList>& drawLists,
+                                    const ModelMatrixSetter& setModelMatrix,
+                                    SpacingTexture* spacing) const {
+  std::uint64_t pointDrawCount = 0;
+  // no lists, e.g. before the first selection, draw nothing
+  const std::size_t numLists = std::min(drawLists.size(), trees.size());
+  for (std::size_t i = 0; i < numLists; i++) {
+    if (drawLists[i].entries.empty()) continue;
+    setModelMatrix(trees[i].modelMatrix);
+    pointDrawCount += trees[i].octree->submit(drawLists[i], spacing);
+  }
+  return pointDrawCount;
+}
+
+template <typename Schema>
+std::uint64_t Scene<Schema>::submitNext(const std::vector<DrawList>& drawLists,
+                                        std::uint64_t pointBudget, std::vector<Cursor>& cursors,
+                                        const ModelMatrixSetter& setModelMatrix,
+                                        SpacingTexture* spacing) const {
+  const std::size_t numLists = std::min(drawLists.size(), trees.size());
+  cursors.resize(numLists);
+  std::uint64_t listPoints = 0;
+  std::uint64_t drawnPoints = 0;
+  for (std::size_t i = 0; i < numLists; i++) {
+    listPoints += drawLists[i].points;
+    drawnPoints += cursors[i].points;
+  }
+  if (drawnPoints >= listPoints) return 0;
+  const double fraction =
+      std::min(1.0, double(drawnPoints + pointBudget) / double(listPoints));
+
+  std::uint64_t pointDrawCount = 0;
+  for (std::size_t i = 0; i < numLists; i++) {
+    const DrawList& drawList = drawLists[i];
+    Cursor& cursor = cursors[i];
+    const double target = fraction * double(drawList.points);
+    std::size_t end = cursor.entry;
+    std::uint64_t points = cursor.points;
+    while (end < drawList.entries.size() && points < target) {
+      points += drawList.entries[end++].count;
+    }
+    if (end == cursor.entry) continue;
+
+    setModelMatrix(trees[i].modelMatrix);
+    pointDrawCount += trees[i].octree->submit(drawList, cursor.entry, end, spacing);
+    cursor.entry = end;
+    cursor.points = points;
+  }
+  return pointDrawCount;
+}
+
+template <typename Schema>
+void Scene<Schema>::drawDebugBoxes(BoxOverlay& overlay, bool onlyDrawn,
+                                   const ModelMatrixSetter& setModelMatrix) {
+  for (Tree& tree : trees) {
+    overlay.clear();
+    tree.octree->addDebugBoxes(overlay, onlyDrawn);
+    setModelMatrix(tree.modelMatrix);
+    overlay.draw();
+  }
+}
+
+#define INSTANTIATE_SCENE(...) template class Scene<PointSchema<__VA_ARGS__>>;
+POINT_SCHEMAS(INSTANTIATE_SCENE)
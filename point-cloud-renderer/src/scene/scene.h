@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <box-overlay/box-overlay.h>
+#include <octree/octree-node.h>
+#include <spacing-texture/spacing-texture.h>
+
+// Octrees drawn together, e.g. the separately scanned tiles of a site, each
+// placed in the scene by its own model matrix. LODSelector ranks the nodes
+// of every tree in one order under one point budget, so a scene draws at
+// the cost of the budget however many trees it holds.
+template <typename Schema>
+class Scene {
+ public:
+  using DrawList = typename OctreeNode<Schema>::DrawList;
+  // called with a tree's model matrix before its nodes are drawn
+  using ModelMatrixSetter = std::function<void(const glm::mat4&)>;
+
+  // how much of a tree's list submitNext() has drawn
+  struct Cursor {
+    std::size_t entry = 0;
+    std::uint64_t points = 0;
+  };
+
+  // `modelMatrix` places the tree's points in the scene's coordinates. Trees
+  // stay at the same address once added, and keep their index, but adding
+  // one while another thread selects from the scene needs the lock it holds.
+  void add(OctreeNode<Schema>&& octree, const glm::mat4& modelMatrix = glm::mat4(1.f));
+
+  std::size_t getNumTrees() const;
+  OctreeNode<Schema>& getTree(std::size_t idx);
+  const OctreeNode<Schema>& getTree(std::size_t idx) const;
+  const glm::mat4& getModelMatrix(std::size_t idx) const;
+  // over every tree, see OctreeNode
+  std::uint64_t getNodeCount() const;
+  unsigned int getMaxDepth() const;
+
+  // Draws the list of each tree in `drawLists`, one per tree as picked by
+  // LODSelector, and returns the number of points drawn. `spacing`, if
+  // given, gets each tree's spacing tree, see OctreeNode::submit().
+  std::uint64_t submit(const std::vector<DrawList>& drawLists,
+                       const ModelMatrixSetter& setModelMatrix,
+                       SpacingTexture* spacing = nullptr) const;
+  // Draws the next part of each tree's list, from its cursor on, and moves
+  // the cursors past it. Every tree is drawn up to the same fraction of its
+  // list's points, so successive calls draw about `pointBudget` more points
+  // each in about the order they were picked in. Returns the number of
+  // points drawn, which is 0 once every list is drawn.
+  std::uint64_t submitNext(const std::vector<DrawList>& drawLists, std::uint64_t pointBudget,
+                           std::vector<Cursor>& cursors,
+                           const ModelMatrixSetter& setModelMatrix,
+                           SpacingTexture* spacing = nullptr) const;
+  // Draws the boxes of the nodes drawn since the last call or, unless
+  // `onlyDrawn`, of every node, with a program for `overlay` bound.
+  void drawDebugBoxes(BoxOverlay& overlay, bool onlyDrawn,
+                      const ModelMatrixSetter& setModelMatrix);
+
+ private:
+  struct Tree {
+    std::unique_ptr<OctreeNode<Schema>> octree;
+    glm::mat4 modelMatrix;
+  };
+
+  std::vector<Tree> trees;
+};
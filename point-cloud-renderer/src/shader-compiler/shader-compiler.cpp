@@ -47,13 +47,28 @@ namespace {
     }
   }
 
-  unsigned int compile(GLenum type, const char* shaderSrcPath) {
+  // #version must be the first line of a shader, so defines go after it
+  void insertDefines(std::string& src, const std::string& defines) {
+    if (defines.empty()) return;
+
+    const std::size_t version = src.find("#version");
+    const std::size_t lineEnd = version == std::string::npos ? std::string::npos
+                                                             : src.find('\n', version);
+    if (lineEnd == std::string::npos) {
+      src.insert(0, defines);
+    } else {
+      src.insert(lineEnd + 1, defines);
+    }
+  }
+
+  unsigned int compile(GLenum type, const char* shaderSrcPath, const std::string& defines) {
     if (type != GL_VERTEX_SHADER && type != GL_FRAGMENT_SHADER) {
       throw std::invalid_argument("Invalid shader type passed to compile()");
     }
 
     unsigned int shaderID = glCreateShader(type);
     std::string src = readShaderSrc(shaderSrcPath);
+    insertDefines(src, defines);
     const char* srcPtr = src.c_str();
 
     glShaderSource(shaderID, 1, &srcPtr, nullptr);
@@ -76,9 +91,9 @@ namespace {
 namespace shader {
 
   unsigned int createProgram(const char* vertexShaderSrcPath,
-                             const char* fragShaderSrcPath) {
-    unsigned int vs = compile(GL_VERTEX_SHADER, vertexShaderSrcPath);
-    unsigned int fs = compile(GL_FRAGMENT_SHADER, fragShaderSrcPath);
+                             const char* fragShaderSrcPath, const std::string& defines) {
+    unsigned int vs = compile(GL_VERTEX_SHADER, vertexShaderSrcPath, defines);
+    unsigned int fs = compile(GL_FRAGMENT_SHADER, fragShaderSrcPath, defines);
 
     unsigned int programID = glCreateProgram();
     glAttachShader(programID, vs);
@@ -1,6 +1,10 @@
 #pragma once
+#include <string>
+
 #include <glad/gl.h>
 
 namespace shader {
-  unsigned int createProgram(const char* vertexShaderSrcPath, const char* fragShaderSrcPath);
+  // `defines` is inserted into both shaders after their #version line
+  unsigned int createProgram(const char* vertexShaderSrcPath, const char* fragShaderSrcPath,
+                             const std::string& defines = "");
 }
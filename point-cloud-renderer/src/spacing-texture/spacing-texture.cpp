@@ -0,0 +1,55 @@
+#include <spacing-texture/spacing-texture.h>
+
+namespace {
+
+  // texture unit the points shader reads the spacing tree from; its colour
+  // maps are on unit 0
+  constexpr int textureUnit = 2;
+
+}  // namespace
+
+SpacingTexture::SpacingTexture(unsigned int program)
+    : samplerLoc(glGetUniformLocation(program, "spacingTree")),
+      nodeIndexLoc(glGetUniformLocation(program, "nodeIndex")),
+      nodeMinLoc(glGetUniformLocation(program, "nodeMin")),
+      nodeExtentLoc(glGetUniformLocation(program, "nodeExtent")),
+      buffer(0),
+      texture(0) {
+}
+
+SpacingTexture::~SpacingTexture() {
+  if (buffer == 0) return;
+  glDeleteTextures(1, &texture);
+  glDeleteBuffers(1, &buffer);
+}
+
+void SpacingTexture::upload(const std::vector<glm::uvec2>& spacingTree) {
+  if (buffer == 0) create();
+
+  glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+  // orphaned per tree, so draws of the previous tree need not finish first
+  glBufferData(GL_TEXTURE_BUFFER, spacingTree.size() * sizeof(glm::uvec2), spacingTree.data(),
+               GL_STREAM_DRAW);
+  glActiveTexture(GL_TEXTURE0 + textureUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, texture);
+  glActiveTexture(GL_TEXTURE0);
+  glUniform1i(samplerLoc, textureUnit);
+}
+
+void SpacingTexture::setNode(std::uint32_t index, const BoundingBox& bbox) const {
+  glUniform1i(nodeIndexLoc, static_cast<int>(index));
+  const glm::vec3 min = bbox.getMin();
+  const glm::vec3 extent = bbox.getDimensions();
+  glUniform3f(nodeMinLoc, min.x, min.y, min.z);
+  glUniform3f(nodeExtentLoc, extent.x, extent.y, extent.z);
+}
+
+void SpacingTexture::create() {
+  glGenBuffers(1, &buffer);
+  glGenTextures(1, &texture);
+
+  glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+  glBindTexture(GL_TEXTURE_BUFFER, texture);
+  // the buffer's storage is replaced per upload, but stays attached
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, buffer);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <boundingbox/boundingbox.h>
+
+// Hands the points shader the spacing tree of the nodes drawn from an
+// octree, see OctreeNode::DrawList, as a buffer texture, and each drawn
+// node's place in it. The shader walks down from the node to the finest
+// drawn node containing each point, and sizes the point by its spacing. The
+// GL objects are only created by the first upload().
+class SpacingTexture {
+ public:
+  // `program` is the points program, built from vertex.glsl
+  explicit SpacingTexture(unsigned int program);
+  ~SpacingTexture();
+
+  SpacingTexture(const SpacingTexture&) = delete;
+  SpacingTexture& operator=(const SpacingTexture&) = delete;
+
+  // Uploads a tree's spacing tree for the nodes drawn next, with the points
+  // program bound.
+  void upload(const std::vector<glm::uvec2>& spacingTree);
+  // sets the uniforms of the node drawn next, at `index` of the spacing tree
+  void setNode(std::uint32_t index, const BoundingBox& bbox) const;
+
+ private:
+  void create();
+
+  int samplerLoc;
+  int nodeIndexLoc;
+  int nodeMinLoc;
+  int nodeExtentLoc;
+  unsigned int buffer;
+  unsigned int texture;
+};
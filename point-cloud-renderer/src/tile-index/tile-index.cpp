@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+#include <parallel/parallel.h>
+#include <tile-index/tile-index.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+  bool isTileExtension(const fs::path& filepath) {
+    return filepath.extension() == ".ply" || filepath.extension() == ".pcd";
+  }
+
+}  // namespace
+
+bool TileIndex::isTileSet(const std::string& path) {
+  std::error_code error;
+  return fs::is_directory(path, error) || fs::path(path).extension() == manifestExtension;
+}
+
+std::optional<TileIndex> TileIndex::open(const std::string& path, const LoadOptions& options) {
+  std::error_code error;
+  const bool isDirectory = fs::is_directory(path, error);
+  std::vector<Listing> listings;
+  if (!(isDirectory ? listDirectory(path, listings) : readManifest(path, listings))) {
+    return std::nullopt;
+  }
+  if (listings.empty()) {
+    std::cerr << "Error: No .ply or .pcd tiles found in " << path << std::endl;
+    return std::nullopt;
+  }
+
+  // Filters can leave a tile's points anywhere inside its listed bounds, or
+  // none at all, and the intensity range is only known from the points. The
+  // budget applies to the loaded tiles, not to their bounds. Without a pass,
+  // the bounds an earlier one found are reused if the tile is unchanged.
+  const bool needsPass = options.filter.isActive() || options.attributes.intensities;
+  LoadOptions boundsOptions = options;
+  boundsOptions.pointLimit = std::nullopt;
+  const std::string cachePath =
+      isDirectory ? (fs::path(path) / boundsCacheName).string() : path + boundsCacheExtension;
+  const BoundsCache cache = needsPass ? BoundsCache() : readBoundsCache(cachePath);
+
+  std::vector<Tile> found(listings.size());
+  std::vector<char> isEmpty(listings.size(), 0);
+  std::vector<std::string> errors(listings.size());
+  std::vector<std::optional<CachedBounds>> cacheEntries(listings.size());
+  std::vector<char> isCacheChanged(listings.size(), 0);
+  parallel::forEachItem(listings.size(), [&](std::size_t i) {
+    const Listing& listing = listings[i];
+    Tile& tile = found[i];
+    tile.filepath = listing.filepath;
+    if (!PointCloud::readFileHeader(listing.filepath, tile.filePoints, tile.attributes,
+                                    errors[i])) {
+      return;
+    }
+    tile.intensityRange = glm::vec2(0.f);
+    if (listing.hasBounds && !needsPass) {
+      tile.min = listing.min;
+      tile.max = listing.max;
+    } else {
+      std::optional<FileStamp> stamp;
+      if (!needsPass) stamp = getFileStamp(listing.filepath);
+      const auto cached = stamp ? cache.find(listing.filepath) : cache.end();
+      if (cached != cache.end() && cached->second.stamp == *stamp) {
+        tile.min = cached->second.min;
+        tile.max = cached->second.max;
+        cacheEntries[i] = cached->second;
+      } else {
+        PointCloud::Bounds bounds;
+        if (!PointCloud::getFileBounds(listing.filepath, boundsOptions, bounds, errors[i])) {
+          return;
+        }
+        isEmpty[i] = bounds.numPoints == 0;
+        tile.min = bounds.min;
+        tile.max = bounds.max;
+        if (options.attributes.intensities && tile.attributes.intensities) {
+          tile.intensityRange = bounds.intensityRange;
+        }
+        if (stamp && bounds.numPoints > 0) {
+          cacheEntries[i] = CachedBounds{*stamp, bounds.min, bounds.max};
+          isCacheChanged[i] = 1;
+        }
+      }
+    }
+    tile.bbox = BoundingBox(tile.min, tile.max, true);
+  });
+
+  TileIndex index;
+  const float fmax = std::numeric_limits<float>::max();
+  index.min = glm::vec3(fmax);
+  index.max = glm::vec3(-fmax);
+  index.intensityRange = glm::vec2(fmax, -fmax);
+  std::size_t numEmpty = 0;
+  std::size_t numUnreadable = 0;
+  for (std::size_t i = 0; i < found.size(); i++) {
+    if (!errors[i].empty()) {
+      std::cerr << "Warning: Skipping tile " << found[i].filepath << ": " << errors[i]
+                << std::endl;
+      numUnreadable++;
+      continue;
+    }
+    if (isEmpty[i]) {
+      numEmpty++;
+      continue;
+    }
+    Tile& tile = found[i];
+    index.min = glm::min(index.min, tile.min);
+    index.max = glm::max(index.max, tile.max);
+    if (options.attributes.intensities && tile.attributes.intensities) {
+      index.intensityRange = glm::vec2(std::min(index.intensityRange.x, tile.intensityRange.x),
+                                       std::max(index.intensityRange.y, tile.intensityRange.y));
+    }
+    index.tiles.push_back(std::move(tile));
+  }
+  if (index.tiles.empty()) {
+    std::cerr << "Error: None of the tiles of " << path
+              << " could be read with points passing the filters" << std::endl;
+    return std::nullopt;
+  }
+  if (index.intensityRange.x > index.intensityRange.y) index.intensityRange = glm::vec2(0.f);
+
+  if (std::find(isCacheChanged.begin(), isCacheChanged.end(), 1) != isCacheChanged.end()) {
+    BoundsCache updated;
+    for (std::size_t i = 0; i < listings.size(); i++) {
+      if (cacheEntries[i]) updated.emplace(listings[i].filepath, *cacheEntries[i]);
+    }
+    writeBoundsCache(cachePath, updated);
+  }
+
+  std::cout << "Tile index:" << std::endl;
+  std::cout << "  - " << index.tiles.size() << " tiles, " << index.getFilePoints() << " points"
+            << std::endl;
+  if (numEmpty > 0) {
+    std::cout << "  - Left out " << numEmpty << " tiles with no points passing the filters"
+              << std::endl;
+  }
+  if (numUnreadable > 0) {
+    std::cout << "  - Left out " << numUnreadable << " unreadable tiles" << std::endl;
+  }
+  return index;
+}
+
+bool TileIndex::listDirectory(const std::string& path, std::vector<Listing>& listings) {
+  std::error_code error;
+  for (const fs::directory_entry& entry : fs::directory_iterator(path, error)) {
+    if (entry.is_regular_file(error) && isTileExtension(entry.path())) {
+      listings.push_back({entry.path().string()});
+    }
+  }
+  if (error) {
+    std::cerr << "Error: Failed to list " << path << ": " << error.message() << std::endl;
+    return false;
+  }
+  // directory order is arbitrary
+  std::sort(listings.begin(), listings.end(), [](const Listing& a, const Listing& b) {
+    return a.filepath < b.filepath;
+  });
+  return true;
+}
+
+bool TileIndex::readManifest(const std::string& path, std::vector<Listing>& listings) {
+  std::ifstream manifest(path);
+  if (!manifest) {
+    std::cerr << "Error: Failed to open " << path << std::endl;
+    return false;
+  }
+
+  const fs::path directory = fs::path(path).parent_path();
+  std::string line;
+  for (std::size_t lineNumber = 1; std::getline(manifest, line); lineNumber++) {
+    std::istringstream fields(line);
+    std::string filepath;
+    if (!(fields >> filepath) || filepath[0] == '#') continue;
+
+    Listing listing;
+    const fs::path tilePath(filepath);
+    listing.filepath = (tilePath.is_relative() ? directory / tilePath : tilePath).string();
+    if (fields >> listing.min.x) {
+      fields >> listing.min.y >> listing.min.z >> listing.max.x >> listing.max.y >> listing.max.z;
+      listing.hasBounds = fields && !glm::any(glm::greaterThan(listing.min, listing.max));
+      if (!listing.hasBounds) {
+        std::cerr << "Warning: Malformed bounds on line " << lineNumber << " of " << path
+                  << ", expected MINX MINY MINZ MAXX MAXY MAXZ; reading them from the tile"
+                  << std::endl;
+      }
+    }
+    listings.push_back(std::move(listing));
+  }
+  return true;
+}
+
+std::optional<TileIndex::FileStamp> TileIndex::getFileStamp(const std::string& filepath) {
+  std::error_code error;
+  FileStamp stamp;
+  stamp.size = fs::file_size(filepath, error);
+  if (error) return std::nullopt;
+  stamp.modified = static_cast<std::int64_t>(
+      fs::last_write_time(filepath, error).time_since_epoch().count());
+  if (error) return std::nullopt;
+  return stamp;
+}
+
+TileIndex::BoundsCache TileIndex::readBoundsCache(const std::string& cachePath) {
+  // a missing or damaged cache only costs the passes it would have spared
+  BoundsCache cache;
+  std::ifstream file(cachePath);
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream fields(line);
+    CachedBounds entry;
+    std::string filepath;
+    fields >> entry.stamp.size >> entry.stamp.modified >> entry.min.x >> entry.min.y >>
+        entry.min.z >> entry.max.x >> entry.max.y >> entry.max.z >> std::ws;
+    if (fields && std::getline(fields, filepath) && !filepath.empty()) {
+      cache[filepath] = entry;
+    }
+  }
+  return cache;
+}
+
+void TileIndex::writeBoundsCache(const std::string& cachePath, const BoundsCache& cache) {
+  // Written aside and renamed over the old one, so a run reading it meanwhile
+  // never sees half of it. A tile set in a read-only directory goes uncached.
+  const std::string writtenPath = cachePath + ".tmp";
+  std::error_code error;
+  {
+    std::ofstream file(writtenPath);
+    if (!file) return;
+    file << std::setprecision(std::numeric_limits<float>::max_digits10);
+    for (const auto& [filepath, entry] : cache) {
+      file << entry.stamp.size << ' ' << entry.stamp.modified << ' ' << entry.min.x << ' '
+           << entry.min.y << ' ' << entry.min.z << ' ' << entry.max.x << ' ' << entry.max.y
+           << ' ' << entry.max.z << ' ' << filepath << '\n';
+    }
+    if (!file.flush()) {
+      file.close();
+      fs::remove(writtenPath, error);
+      return;
+    }
+  }
+  fs::rename(writtenPath, cachePath, error);
+  if (error) fs::remove(writtenPath, error);
+}
+
+std::size_t TileIndex::size() const {
+  return tiles.size();
+}
+
+const TileIndex::Tile& TileIndex::getTile(std::size_t idx) const {
+  return tiles[idx];
+}
+
+std::vector<std::string> TileIndex::getFilepaths() const {
+  std::vector<std::string> filepaths;
+  filepaths.reserve(tiles.size());
+  for (const Tile& tile : tiles) {
+    filepaths.push_back(tile.filepath);
+  }
+  return filepaths;
+}
+
+glm::vec3 TileIndex::getMin() const {
+  return min;
+}
+
+glm::vec3 TileIndex::getMax() const {
+  return max;
+}
+
+std::uint64_t TileIndex::getFilePoints() const {
+  std::uint64_t points = 0;
+  for (const Tile& tile : tiles) {
+    points += tile.filePoints;
+  }
+  return points;
+}
+
+glm::vec2 TileIndex::getIntensityRange() const {
+  return intensityRange;
+}
+
+void TileIndex::findVisible(const View& view, const glm::mat4& modelViewMat, float minScreenSize,
+                            std::vector<std::size_t>& visible) const {
+  // The model matrix only rotates and scales uniformly. Even thousands of
+  // tiles test in well under a millisecond, so they are tested one by one.
+  const float viewScale = glm::length(glm::vec3(modelViewMat[0]));
+  std::vector<std::pair<float, std::size_t>> ranked;
+  for (std::size_t i = 0; i < tiles.size(); i++) {
+    const BoundingBox& bbox = tiles[i].bbox;
+    const glm::vec3 viewPosition = modelViewMat * glm::vec4(bbox.getCenter(), 1);
+    const float viewRadius = bbox.getBoundingSphereRadius() * viewScale;
+    if (!view.isSphereVisible(viewPosition, viewRadius)) continue;
+
+    const float screenSize = view.getScreenProjectedSize(viewRadius, glm::length(viewPosition));
+    if (screenSize > minScreenSize) ranked.push_back({screenSize, i});
+  }
+  std::sort(ranked.begin(), ranked.end(),
+            [](const auto& a, const auto& b) { return a.first > b.first; });
+
+  visible.clear();
+  for (const auto& [screenSize, idx] : ranked) {
+    visible.push_back(idx);
+  }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <boundingbox/boundingbox.h>
+#include <point-cloud/point-cloud.h>
+#include <point-reader/point-reader.h>
+#include <view/view.h>
+
+// The tiles of a dataset split over many files, e.g. a directory of PLY
+// scans of one site, which share one coordinate system. Opening the index
+// reads every tile's header and bounds, several tiles at a time, but keeps
+// none of their points: a TileLoader reads a tile once the view needs it.
+// Bounds found by a pass over a tile's points are cached beside the tiles,
+// so later runs read only its header while the tile is unchanged.
+class TileIndex {
+ public:
+  struct Tile {
+    std::string filepath;
+    std::uint64_t filePoints;  // in the header
+    AttributeSet attributes;   // the file has
+    // of the points that pass the filters
+    glm::vec3 min;
+    glm::vec3 max;
+    glm::vec2 intensityRange;  // if loading intensities
+    BoundingBox bbox;          // cubic, as the root of the tile's octree
+  };
+
+  // A manifest lists a tile per line, optionally followed by its bounds as
+  // MINX MINY MINZ MAXX MAXY MAXZ, which spares a pass over its points unless
+  // filters or intensities need one. Blank lines and lines starting with '#'
+  // are skipped, and relative paths are relative to the manifest.
+  static constexpr const char* manifestExtension = ".txt";
+  // The bounds cache: a directory's is inside it, a manifest's beside it with
+  // the extension appended. Each line is SIZE MTIME MINX MINY MINZ MAXX MAXY
+  // MAXZ PATH, and an entry whose tile's size or modification time changed
+  // is ignored. Unused while filters or intensities need a pass anyway.
+  static constexpr const char* boundsCacheName = ".tile-bounds";
+  static constexpr const char* boundsCacheExtension = ".bounds";
+
+  // whether `path` is a directory or a manifest rather than a point cloud
+  static bool isTileSet(const std::string& path);
+  // Lists the .ply and .pcd files of a directory, or the tiles of a manifest,
+  // and reads their headers and bounds. Tiles that can't be read are reported
+  // and left out, as are those none of whose points pass the filters. Prints
+  // the error and returns nothing if no tile is left.
+  static std::optional<TileIndex> open(const std::string& path, const LoadOptions& options);
+
+  std::size_t size() const;
+  const Tile& getTile(std::size_t idx) const;
+  std::vector<std::string> getFilepaths() const;
+  // over every tile
+  glm::vec3 getMin() const;
+  glm::vec3 getMax() const;
+  std::uint64_t getFilePoints() const;
+  glm::vec2 getIntensityRange() const;
+
+  // Sets `visible` to the tiles whose bounding spheres are in view and, like the
+  // root of a tree LODSelector draws, larger than `minScreenSize` on screen,
+  // largest first. `modelViewMat` is the scene's, which places every tile.
+  void findVisible(const View& view, const glm::mat4& modelViewMat, float minScreenSize,
+                   std::vector<std::size_t>& visible) const;
+
+ private:
+  // a tile's path, and its bounds if a manifest gives them
+  struct Listing {
+    std::string filepath;
+    bool hasBounds = false;
+    glm::vec3 min = glm::vec3(0.f);
+    glm::vec3 max = glm::vec3(0.f);
+  };
+
+  // when a tile was last written, to tell whether its cached bounds hold
+  struct FileStamp {
+    std::uintmax_t size = 0;
+    std::int64_t modified = 0;
+
+    bool operator==(const FileStamp& other) const {
+      return size == other.size && modified == other.modified;
+    }
+  };
+  struct CachedBounds {
+    FileStamp stamp;
+    glm::vec3 min = glm::vec3(0.f);
+    glm::vec3 max = glm::vec3(0.f);
+  };
+  using BoundsCache = std::map<std::string, CachedBounds>;  // by tile path
+
+  // print the error and return false if the tiles can't be listed
+  static bool listDirectory(const std::string& path, std::vector<Listing>& listings);
+  static bool readManifest(const std::string& path, std::vector<Listing>& listings);
+  static std::optional<FileStamp> getFileStamp(const std::string& filepath);
+  static BoundsCache readBoundsCache(const std::string& cachePath);
+  static void writeBoundsCache(const std::string& cachePath, const BoundsCache& cache);
+
+  std::vector<Tile> tiles;
+  glm::vec3 min;
+  glm::vec3 max;
+  glm::vec2 intensityRange;
+};
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include <tile-loader/tile-loader.h>
+
+template <typename Schema>
+TileLoader<Schema>::TileLoader(const TileIndex& index, const LoadOptions& options,
+                               const Settings& settings)
+    : index(index),
+      options(options),
+      settings(settings),
+      pointLimits(index.size(), options.pointLimit),
+      isRequested(index.size(), false),
+      numRequested(0),
+      numTaken(0),
+      numSkipped(0),
+      requests(index.size()),
+      stopping(false) {
+  // the tiles are loaded without printing, which would interleave, and
+  // each one whole before its octree is built
+  this->options.quiet = true;
+  this->options.streamingBuild = false;
+
+  // as for a scene of several files, tiles of one site share the budget by
+  // their number of points
+  if (options.pointLimit) {
+    const double totalPoints = static_cast<double>(index.getFilePoints());
+    for (std::size_t i = 0; i < index.size(); i++) {
+      const double share =
+          totalPoints > 0.0 ? index.getTile(i).filePoints / totalPoints : 0.0;
+      pointLimits[i] =
+          std::max<std::uint64_t>(1, static_cast<std::uint64_t>(*options.pointLimit * share));
+    }
+  }
+
+  const unsigned int numReaders = std::min<unsigned int>(
+      maxReaders, std::min<std::size_t>(parallel::getThreadCount(), index.size()));
+  for (unsigned int i = 0; i < numReaders; i++) {
+    readers.emplace_back(&TileLoader::run, this);
+  }
+}
+
+template <typename Schema>
+TileLoader<Schema>::~TileLoader() {
+  stopping = true;
+  requests.close();
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+}
+
+template <typename Schema>
+void TileLoader<Schema>::request(std::size_t tile) {
+  if (isRequested[tile]) return;
+  isRequested[tile] = true;
+  numRequested++;
+  // holds every tile, so never blocks
+  requests.push(tile);
+}
+
+template <typename Schema>
+std::optional<typename TileLoader<Schema>::Loaded> TileLoader<Schema>::take() {
+  std::lock_guard<std::mutex> lock(loadedMutex);
+  if (loaded.empty()) return std::nullopt;
+  std::optional<Loaded> tile(std::move(loaded.front()));
+  loaded.pop_front();
+  numTaken++;
+  return tile;
+}
+
+template <typename Schema>
+std::size_t TileLoader<Schema>::getPendingCount() const {
+  return numRequested - numTaken - numSkipped;
+}
+
+template <typename Schema>
+void TileLoader<Schema>::run() {
+  std::size_t tile;
+  while (requests.pop(tile) && !stopping) {
+    LoadOptions tileOptions = options;
+    tileOptions.pointLimit = pointLimits[tile];
+    const std::string& filepath = index.getTile(tile).filepath;
+    std::string error;
+    const std::optional<PointCloud> cloud = PointCloud::load(filepath, tileOptions, error);
+    if (!cloud) {
+      std::cerr << "Warning: Skipping tile " << filepath << ": " << error << std::endl;
+      numSkipped++;
+      continue;
+    }
+
+    OctreeNode<Schema> octree =
+        OctreeNode<Schema>::buildOctree(*cloud, settings.minPointsPerNode, settings.resolution,
+                                        settings.sampling, options.seed);
+    if (settings.nodeSize) {
+      octree.rebalance(settings.nodeSize->x, settings.nodeSize->y);
+    }
+
+    std::lock_guard<std::mutex> lock(loadedMutex);
+    loaded.push_back({tile, std::move(octree), cloud->getPoints().size()});
+  }
+}
+
+#define INSTANTIATE_TILE_LOADER(...) template class TileLoader<PointSchema<__VA_ARGS__>>;
+POINT_SCHEMAS(INSTANTIATE_TILE_LOADER)
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <octree/octree-node.h>
+#include <parallel/parallel.h>
+#include <point-cloud/point-cloud.h>
+#include <tile-index/tile-index.h>
+
+// Reads the tiles of a TileIndex and builds their octrees on background
+// threads, in the order they are requested, so the render thread only has
+// to upload them. Several tiles are read and built at once, each tree with
+// its own build settings (see OctreeNode::createRoot). A tile that can't be
+// read is reported and skipped.
+template <typename Schema>
+class TileLoader {
+ public:
+  // tiles read at once; each is held in memory until its octree is built
+  static constexpr unsigned int maxReaders = 4;
+
+  struct Settings {
+    unsigned int minPointsPerNode;
+    unsigned int resolution;
+    OctreeNodeBase::Sampling sampling;
+    std::optional<glm::uvec2> nodeSize;  // rebalancing band, skipped when unset
+  };
+
+  struct Loaded {
+    std::size_t tile;
+    OctreeNode<Schema> octree;
+    std::uint64_t points;  // loaded into the octree
+  };
+
+  // `index` must outlive the loader. Each tile is loaded with `options`,
+  // whose point buffer budget is split between the tiles by their points.
+  TileLoader(const TileIndex& index, const LoadOptions& options, const Settings& settings);
+  // waits for the tiles being read, skipping the queued ones
+  ~TileLoader();
+
+  TileLoader(const TileLoader&) = delete;
+  TileLoader& operator=(const TileLoader&) = delete;
+
+  // render thread: queues the tile unless it was requested before
+  void request(std::size_t tile);
+  // render thread: the oldest finished tile, if one is waiting
+  std::optional<Loaded> take();
+  // tiles requested and neither taken nor skipped
+  std::size_t getPendingCount() const;
+
+ private:
+  void run();
+
+  const TileIndex& index;
+  LoadOptions options;
+  const Settings settings;
+  std::vector<std::optional<std::uint64_t>> pointLimits;  // per tile
+  std::vector<bool> isRequested;  // only used by the render thread
+  std::size_t numRequested;
+  std::atomic<std::size_t> numTaken;
+  std::atomic<std::size_t> numSkipped;
+  parallel::BoundedQueue<std::size_t> requests;
+  std::atomic<bool> stopping;
+  std::mutex loadedMutex;
+  std::deque<Loaded> loaded;
+  std::vector<std::thread> readers;
+};
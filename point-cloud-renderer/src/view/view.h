@@ -16,4 +16,19 @@ struct View {
     float slope = std::tan(glm::radians(fov) * 0.5f);
     return (float(height) * 0.5f) * (radius / (slope * distance));
   }
+
+  // whether a sphere centred at `center`, in view space, is at least partly
+  // inside the view frustum
+  bool isSphereVisible(const glm::vec3& center, float radius) const {
+    const float depth = -center.z;
+    if (depth + radius < zNearPlane || depth - radius > zFarPlane) return false;
+    if (width <= 0 || height <= 0) return true;
+
+    const float slopeY = std::tan(glm::radians(fov) * 0.5f);
+    const float slopeX = slopeY * float(width) / float(height);
+    // distances outside the side planes, which pass through the eye
+    const float outsideX = (std::abs(center.x) - slopeX * depth) / std::sqrt(1.f + slopeX * slopeX);
+    const float outsideY = (std::abs(center.y) - slopeY * depth) / std::sqrt(1.f + slopeY * slopeY);
+    return outsideX <= radius && outsideY <= radius;
+  }
 };